@@ -0,0 +1,64 @@
+#include <verify.hpp>
+
+#include "block_alignment_converter.hpp"
+
+namespace algorithms {
+    alignment_utils::AlignmentCigar ConvertToCigar(const seqan::Dna5String &subject_string,
+                                                   const seqan::Dna5String &query_string,
+                                                   const PairwiseBlockAlignment &block_alignment) {
+        using alignment_utils::CigarOperation;
+        const AlignmentPath &path = block_alignment.path;
+        VERIFY_MSG(path.check_overlaps(), "Overlaps are not correct");
+        VERIFY_MSG(!path.empty(), "Alignment path is empty");
+        alignment_utils::AlignmentCigar cigar;
+
+        // starting gap: subject prefix is aligned to gaps or query prefix is clipped
+        int starting_gap = path.first().subject_pos - path.first().read_pos;
+        if(starting_gap > 0)
+            cigar.Append(CigarOperation::Deletion, size_t(starting_gap));
+        else
+            cigar.Append(CigarOperation::SoftClip, size_t(-starting_gap));
+        int read_pos = std::max(0, -starting_gap);
+        int subject_pos = std::max(0, starting_gap);
+
+        for(size_t i = 0; i < path.size(); i++) {
+            // columns between the previous edge and the end of block are aligned without gaps
+            int block_read_end = path[i].read_pos + int(path[i].length);
+            cigar.Append(CigarOperation::Match, size_t(block_read_end - read_pos));
+            read_pos = block_read_end;
+            subject_pos = path[i].subject_pos + int(path[i].length);
+            if(i + 1 == path.size())
+                break;
+            const auto &read_edge = seqan::infix(query_string, read_pos, path[i + 1].read_pos);
+            const auto &subject_edge = seqan::infix(subject_string, subject_pos, path[i + 1].subject_pos);
+            size_t read_edge_length = seqan::length(read_edge);
+            size_t subject_edge_length = seqan::length(subject_edge);
+            if(read_edge_length < subject_edge_length) {
+                size_t gap_pos = size_t(find_simple_gap(read_edge, subject_edge));
+                cigar.Append(CigarOperation::Match, gap_pos);
+                cigar.Append(CigarOperation::Deletion, subject_edge_length - read_edge_length);
+                cigar.Append(CigarOperation::Match, read_edge_length - gap_pos);
+            }
+            else if(subject_edge_length < read_edge_length) {
+                size_t gap_pos = size_t(find_simple_gap(subject_edge, read_edge));
+                cigar.Append(CigarOperation::Match, gap_pos);
+                cigar.Append(CigarOperation::Insertion, read_edge_length - subject_edge_length);
+                cigar.Append(CigarOperation::Match, subject_edge_length - gap_pos);
+            }
+            else
+                cigar.Append(CigarOperation::Match, read_edge_length);
+            read_pos = path[i + 1].read_pos;
+            subject_pos = path[i + 1].subject_pos;
+        }
+
+        // finishing gap: subject suffix is aligned to gaps or query suffix is clipped
+        int read_suffix = int(seqan::length(query_string)) - read_pos;
+        int subject_suffix = int(seqan::length(subject_string)) - subject_pos;
+        cigar.Append(CigarOperation::Match, size_t(std::min(read_suffix, subject_suffix)));
+        if(subject_suffix > read_suffix)
+            cigar.Append(CigarOperation::Deletion, size_t(subject_suffix - read_suffix));
+        else
+            cigar.Append(CigarOperation::SoftClip, size_t(read_suffix - subject_suffix));
+        return cigar;
+    }
+}
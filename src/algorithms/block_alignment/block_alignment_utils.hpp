@@ -57,18 +57,30 @@ namespace algorithms {
         return true;
     }
 
+    // buffers of weighted_longest_path_in_DAG that can be reused across calls
+    struct LongestPathWorkspace {
+        std::vector<double> values;
+        std::vector<size_t> next;
+        AlignmentPath path;
+    };
+
+    // longest path is stored in workspace.path, its score is returned
+    // quadratic reference implementation, see SparseMatchChainer for the one used by aligners
     template<typename Tf1, typename Tf2, typename Tf3>
-    std::pair<AlignmentPath, int> weighted_longest_path_in_DAG(const std::vector<Match> &combined,
-                                                               const Tf1 &has_edge,
-                                                               const Tf2 &edge_weight,
-                                                               const Tf3 &vertex_weight) {
+    int weighted_longest_path_in_DAG(const std::vector<Match> &combined,
+                                     const Tf1 &has_edge,
+                                     const Tf2 &edge_weight,
+                                     const Tf3 &vertex_weight,
+                                     LongestPathWorkspace &workspace) {
         VERIFY(combined.size() > 0);
         VERIFY(std::is_sorted(combined.cbegin(), combined.cend(), Match::less_subject_pos));
-        // Vertices should be topologically sorted
-        VERIFY(is_topologically_sorted(combined, has_edge));
+        // Vertices should be topologically sorted (quadratic check, debug mode only)
+        assert(is_topologically_sorted(combined, has_edge));
 
-        std::vector<double> values(combined.size(), 0.);
-        std::vector<size_t> next(combined.size());
+        std::vector<double> &values = workspace.values;
+        values.assign(combined.size(), 0.);
+        std::vector<size_t> &next = workspace.next;
+        next.resize(combined.size());
         std::iota(next.begin(), next.end(), 0);
 
         for (size_t i = combined.size() - 1; i + 1 > 0; --i) {
@@ -89,8 +101,8 @@ namespace algorithms {
             }
         }
 
-        AlignmentPath path;
-        path.reserve(combined.size());
+        AlignmentPath &path = workspace.path;
+        path.clear();
 
         size_t maxi = size_t(std::max_element(values.cbegin(), values.cend()) - values.cbegin());
         // Sasha, is it ok that score is integer here? Looks like a potential error
@@ -113,6 +125,6 @@ namespace algorithms {
         // Path should be correct, all edges should be
         VERIFY(std::is_sorted(path.cbegin(), path.cend(), has_edge));
 
-        return { path, score };
+        return score;
     }
 }
\ No newline at end of file
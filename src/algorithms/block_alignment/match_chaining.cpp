@@ -0,0 +1,31 @@
+#include <verify.hpp>
+
+#include "match_chaining.hpp"
+
+namespace algorithms {
+    bool operator==(const BlockAlignmentScoringScheme &a, const BlockAlignmentScoringScheme &b) {
+        return a.max_global_gap == b.max_global_gap and a.max_local_deletions == b.max_local_deletions and
+                a.max_local_insertions == b.max_local_insertions and a.gap_opening_cost == b.gap_opening_cost and
+                a.gap_extention_cost == b.gap_extention_cost and a.match_reward == b.match_reward and
+                a.mismatch_extention_cost == b.mismatch_extention_cost and
+                a.mismatch_opening_cost == b.mismatch_opening_cost;
+    }
+
+    void ChainValueTree::Set(size_t pos, double key, size_t index) {
+        pos += size_;
+        tree_[pos] = {key, index};
+        for(pos /= 2; pos > 0; pos /= 2)
+            tree_[pos] = Best(tree_[2 * pos], tree_[2 * pos + 1]);
+    }
+
+    ChainValueTree::Entry ChainValueTree::Query(size_t begin, size_t end) const {
+        Entry best = Empty();
+        for(begin += size_, end += size_; begin < end; begin /= 2, end /= 2) {
+            if(begin & 1)
+                best = Best(best, tree_[begin++]);
+            if(end & 1)
+                best = Best(best, tree_[--end]);
+        }
+        return best;
+    }
+}
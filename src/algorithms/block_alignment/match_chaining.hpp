@@ -0,0 +1,283 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+#include <verify.hpp>
+
+#include "block_alignment_primitives.hpp"
+
+namespace algorithms {
+    struct BlockAlignmentScoringScheme {
+        int max_global_gap;
+        int max_local_deletions;
+        int max_local_insertions;
+        int gap_opening_cost;
+        int gap_extention_cost;
+        int match_reward;
+        int mismatch_extention_cost;
+        int mismatch_opening_cost;
+    };
+
+    bool operator==(const BlockAlignmentScoringScheme &a, const BlockAlignmentScoringScheme &b);
+
+    // scoring scheme with compile-time costs, it has the same fields as BlockAlignmentScoringScheme,
+    // so templates that access fields of scoring_ member can be instantiated with any of them
+    template<int MaxGlobalGap, int MaxLocalDeletions, int MaxLocalInsertions, int GapOpeningCost,
+             int GapExtentionCost, int MatchReward, int MismatchExtentionCost, int MismatchOpeningCost>
+    struct StaticBlockAlignmentScoring {
+        static constexpr int max_global_gap = MaxGlobalGap;
+        static constexpr int max_local_deletions = MaxLocalDeletions;
+        static constexpr int max_local_insertions = MaxLocalInsertions;
+        static constexpr int gap_opening_cost = GapOpeningCost;
+        static constexpr int gap_extention_cost = GapExtentionCost;
+        static constexpr int match_reward = MatchReward;
+        static constexpr int mismatch_extention_cost = MismatchExtentionCost;
+        static constexpr int mismatch_opening_cost = MismatchOpeningCost;
+
+        static BlockAlignmentScoringScheme Scheme() {
+            return {max_global_gap, max_local_deletions, max_local_insertions, gap_opening_cost,
+                    gap_extention_cost, match_reward, mismatch_extention_cost, mismatch_opening_cost};
+        }
+    };
+
+#define STATIC_BLOCK_ALIGNMENT_SCORING_MEMBER(name) \
+    template<int MaxGlobalGap, int MaxLocalDeletions, int MaxLocalInsertions, int GapOpeningCost, \
+             int GapExtentionCost, int MatchReward, int MismatchExtentionCost, int MismatchOpeningCost> \
+    constexpr int StaticBlockAlignmentScoring<MaxGlobalGap, MaxLocalDeletions, MaxLocalInsertions, GapOpeningCost, \
+            GapExtentionCost, MatchReward, MismatchExtentionCost, MismatchOpeningCost>::name;
+
+    STATIC_BLOCK_ALIGNMENT_SCORING_MEMBER(max_global_gap)
+    STATIC_BLOCK_ALIGNMENT_SCORING_MEMBER(max_local_deletions)
+    STATIC_BLOCK_ALIGNMENT_SCORING_MEMBER(max_local_insertions)
+    STATIC_BLOCK_ALIGNMENT_SCORING_MEMBER(gap_opening_cost)
+    STATIC_BLOCK_ALIGNMENT_SCORING_MEMBER(gap_extention_cost)
+    STATIC_BLOCK_ALIGNMENT_SCORING_MEMBER(match_reward)
+    STATIC_BLOCK_ALIGNMENT_SCORING_MEMBER(mismatch_extention_cost)
+    STATIC_BLOCK_ALIGNMENT_SCORING_MEMBER(mismatch_opening_cost)
+
+#undef STATIC_BLOCK_ALIGNMENT_SCORING_MEMBER
+
+    // range maximum of (key, match index) pairs, larger key wins, smaller index wins among equal keys
+    class ChainValueTree {
+    public:
+        struct Entry {
+            double key;
+            size_t index;
+        };
+
+    private:
+        size_t size_;
+        std::vector<Entry> tree_;
+
+        static Entry Empty() { return {-std::numeric_limits<double>::infinity(), size_t(-1)}; }
+
+        static const Entry& Best(const Entry &a, const Entry &b) {
+            if(a.key != b.key)
+                return a.key > b.key ? a : b;
+            return a.index < b.index ? a : b;
+        }
+
+    public:
+        ChainValueTree() : size_(0) { }
+
+        void Reset(size_t size) {
+            size_ = size;
+            tree_.assign(2 * size, Empty());
+        }
+
+        void Set(size_t pos, double key, size_t index);
+
+        // maximum over positions [begin, end)
+        Entry Query(size_t begin, size_t end) const;
+    };
+
+    // computes the heaviest chain of matches (the longest path in DAG of matches), result is the same as
+    // weighted_longest_path_in_DAG with HasEdge, EdgeWeight and VertexWeight, including choice among equal chains
+    //
+    // predecessors of a match lie on diagonals (read_pos - subject_pos) of the band allowed by
+    // max_local_insertions and max_local_deletions. For the fixed diagonal, edge weight is a linear function of
+    // subject position of the successor on two ranges: where matches overlap and where they are separated by
+    // mismatches. So the best successor on each range is found by a range maximum query over matches of
+    // the diagonal, that takes O(n * b * log n) time instead of O(n^2), where b is the number of distinct diagonals
+    // in the band (usually a few)
+    //
+    // Scoring is either BlockAlignmentScoringScheme or StaticBlockAlignmentScoring
+    // chainer keeps buffers that are reused across calls, so it should not be shared between threads
+    template<typename Scoring>
+    class BasicSparseMatchChainer {
+        const Scoring scoring_;
+
+        // workspace
+        std::vector<double> values_;
+        std::vector<size_t> next_;
+        // indices of matches sorted by diagonal, subject position and index
+        std::vector<size_t> order_;
+        // position of match in order_
+        std::vector<size_t> rank_;
+        // distinct diagonals in increasing order, k-th diagonal occupies [diagonal_starts_[k], diagonal_starts_[k + 1])
+        std::vector<int> diagonals_;
+        std::vector<size_t> diagonal_starts_;
+        // key of match j is values_[j] + subject_pos, it is used for overlapping successors
+        ChainValueTree overlap_tree_;
+        // key of match j is values_[j] - mismatch_extention_cost * subject_pos, it is used for distant successors
+        ChainValueTree mismatch_tree_;
+        AlignmentPath path_;
+
+        static int Diagonal(const Match &m) { return m.read_pos - m.subject_pos; }
+
+        void InitializeDiagonals(const std::vector<Match> &combined) {
+            order_.resize(combined.size());
+            std::iota(order_.begin(), order_.end(), 0);
+            std::sort(order_.begin(), order_.end(), [&combined](size_t a, size_t b) {
+                int diagonal_a = Diagonal(combined[a]);
+                int diagonal_b = Diagonal(combined[b]);
+                if(diagonal_a != diagonal_b)
+                    return diagonal_a < diagonal_b;
+                if(combined[a].subject_pos != combined[b].subject_pos)
+                    return combined[a].subject_pos < combined[b].subject_pos;
+                return a < b;
+            });
+            rank_.resize(combined.size());
+            diagonals_.clear();
+            diagonal_starts_.clear();
+            for(size_t p = 0; p < order_.size(); p++) {
+                rank_[order_[p]] = p;
+                int diagonal = Diagonal(combined[order_[p]]);
+                if(diagonals_.empty() or diagonals_.back() != diagonal) {
+                    diagonals_.push_back(diagonal);
+                    diagonal_starts_.push_back(p);
+                }
+            }
+            diagonal_starts_.push_back(order_.size());
+        }
+
+        // first position of diagonal k in order_ such that subject position of match is at least subject_pos
+        size_t LowerBound(const std::vector<Match> &combined, size_t k, int subject_pos) const {
+            auto begin = order_.cbegin() + diagonal_starts_[k];
+            auto end = order_.cbegin() + diagonal_starts_[k + 1];
+            return size_t(std::lower_bound(begin, end, subject_pos, [&combined](size_t index, int pos) {
+                return combined[index].subject_pos < pos;
+            }) - order_.cbegin());
+        }
+
+        // updates best successor of match i by matches of k-th diagonal
+        void UpdateBySuccessorsOnDiagonal(const std::vector<Match> &combined, size_t i, size_t k,
+                                          double &best_value, size_t &best_index) const {
+            const Match &a = combined[i];
+            int gap = diagonals_[k] - Diagonal(a);
+            // for successor b on the diagonal, m = min(read gap, subject gap) - a.length:
+            // if m <= 0, matches overlap by -m positions, otherwise they are separated by m mismatches
+            // m = b.subject_pos - shift
+            int shift = a.subject_pos - std::min(0, gap) + int(a.length);
+            double base_value = VertexWeight(a) - GapCost(gap);
+            // crossing check: b.subject_pos > a.subject_pos and b.read_pos > a.read_pos
+            int min_subject_pos = a.subject_pos + std::max(0, -gap) + 1;
+            size_t overlap_begin = LowerBound(combined, k, min_subject_pos);
+            size_t mismatch_begin = std::max(overlap_begin, LowerBound(combined, k, shift + 1));
+            size_t diagonal_end = diagonal_starts_[k + 1];
+            auto update = [&best_value, &best_index](double value, size_t index) {
+                if(value > best_value or (value == best_value and index < best_index)) {
+                    best_value = value;
+                    best_index = index;
+                }
+            };
+            if(overlap_begin < mismatch_begin) {
+                auto entry = overlap_tree_.Query(overlap_begin, mismatch_begin);
+                if(entry.index != size_t(-1))
+                    update(base_value + entry.key - shift, entry.index);
+            }
+            if(mismatch_begin < diagonal_end) {
+                auto entry = mismatch_tree_.Query(mismatch_begin, diagonal_end);
+                if(entry.index != size_t(-1))
+                    update(base_value + entry.key + double(scoring_.mismatch_extention_cost) * shift -
+                           scoring_.mismatch_opening_cost, entry.index);
+            }
+        }
+
+        void ComputePath(const std::vector<Match> &combined) {
+            path_.clear();
+            size_t maxi = size_t(std::max_element(values_.cbegin(), values_.cend()) - values_.cbegin());
+            while (true) {
+                path_.push_back(combined[maxi]);
+                if (next_[maxi] == maxi)
+                    break;
+                maxi = next_[maxi];
+            }
+            // Fix overlaps (truncate tail of left match)
+            for (size_t i = 0; i + 1 < path_.size(); ++i) {
+                VERIFY_MSG(HasEdge(path_[i], path_[i + 1]), "Chain of matches is not consistent");
+                path_[i].length -= Match::overlap(path_[i], path_[i + 1]);
+            }
+        }
+
+    public:
+        BasicSparseMatchChainer(const Scoring &scoring) : scoring_(scoring) { }
+
+        bool HasEdge(const Match &a, const Match &b) const {
+            int read_gap = b.read_pos - a.read_pos;
+            int needle_gap = b.subject_pos - a.subject_pos;
+            int gap = read_gap - needle_gap;
+            if (gap > scoring_.max_local_insertions || -gap > scoring_.max_local_deletions) return false;
+            // Crossing check
+            if (a.subject_pos >= b.subject_pos || a.read_pos >= b.read_pos) return false;
+            return true;
+        }
+
+        double VertexWeight(const Match &m) const {
+            return double(m.length) * double(scoring_.match_reward);
+        }
+
+        double GapCost(int gap) const {
+            return gap ? scoring_.gap_opening_cost + std::abs(gap) * scoring_.gap_extention_cost : 0;
+        }
+
+        double EdgeWeight(const Match &a, const Match &b) const {
+            int read_gap = b.read_pos - a.read_pos;
+            int needle_gap = b.subject_pos - a.subject_pos;
+            int gap = read_gap - needle_gap;
+            int mmatch = std::min(b.read_pos - a.read_pos - int(a.length),
+                                  b.subject_pos - a.subject_pos - int(a.length));
+            mmatch = std::max(0, mmatch);
+            return - Match::overlap(a, b)
+                   - GapCost(gap)
+                   - ((mmatch) ? scoring_.mismatch_opening_cost + mmatch * scoring_.mismatch_extention_cost : 0);
+        }
+
+        // matches should be sorted by subject positions, the heaviest chain is stored in Path(), its score is returned
+        int Chain(const std::vector<Match> &combined) {
+            VERIFY(combined.size() > 0);
+            VERIFY(std::is_sorted(combined.cbegin(), combined.cend(), Match::less_subject_pos));
+            InitializeDiagonals(combined);
+            values_.assign(combined.size(), 0.);
+            next_.resize(combined.size());
+            overlap_tree_.Reset(combined.size());
+            mismatch_tree_.Reset(combined.size());
+            // successors of a match have larger subject positions, i.e., larger indices
+            for (size_t i = combined.size() - 1; i + 1 > 0; --i) {
+                const Match &a = combined[i];
+                // as in weighted_longest_path_in_DAG, successor is used only if it strictly improves the match alone
+                double best_value = VertexWeight(a);
+                size_t best_index = i;
+                auto first = std::lower_bound(diagonals_.cbegin(), diagonals_.cend(),
+                                              Diagonal(a) - scoring_.max_local_deletions);
+                for(size_t k = size_t(first - diagonals_.cbegin());
+                    k < diagonals_.size() and diagonals_[k] <= Diagonal(a) + scoring_.max_local_insertions; k++)
+                    UpdateBySuccessorsOnDiagonal(combined, i, k, best_value, best_index);
+                values_[i] = best_value;
+                next_[i] = best_index;
+                overlap_tree_.Set(rank_[i], values_[i] + a.subject_pos, i);
+                mismatch_tree_.Set(rank_[i], values_[i] - double(scoring_.mismatch_extention_cost) * a.subject_pos, i);
+            }
+            // Sasha, is it ok that score is integer here? Looks like a potential error
+            int score = int(*std::max_element(values_.cbegin(), values_.cend()));
+            ComputePath(combined);
+            return score;
+        }
+
+        const AlignmentPath& Path() const { return path_; }
+    };
+
+    typedef BasicSparseMatchChainer<BlockAlignmentScoringScheme> SparseMatchChainer;
+}
@@ -3,25 +3,38 @@
 namespace algorithms {
     std::vector<Match> combine_sequential_kmer_matches(std::vector<KmerMatch> &matches,
                                                        size_t K) {
-        std::sort(matches.begin(), matches.end(), KmerMatch::less_shift);
         std::vector<Match> res;
         res.reserve(matches.size()); // TODO Is it really necessary?
+        combine_sequential_kmer_matches(matches, K, res);
+        return res;
+    }
+
+    void combine_sequential_kmer_matches(std::vector<KmerMatch> &matches,
+                                         size_t K,
+                                         std::vector<Match> &res) {
+        // comparator is wrapped into lambda, so it is inlined into sort instead of being called by pointer
+        std::sort(matches.begin(), matches.end(),
+                  [](const KmerMatch &a, const KmerMatch &b) { return KmerMatch::less_shift(a, b); });
+        res.clear();
 
         if (matches.size() == 0) {
-            return res;
+            return;
         }
 
+        // k-mer matches on the same diagonal that overlap or abut the current match are merged into it,
+        // so sampled k-mers (e.g., minimizers) are combined as well as consecutive ones
         Match cur = { matches[0].needle_pos, matches[0].read_pos, K }; // start first match
         for (size_t i = 1; i < matches.size(); ++i) {
-            if (matches[i].needle_pos == matches[i-1].needle_pos + 1 &&
-                matches[i].read_pos == matches[i-1].read_pos + 1) { // extend current match
-                cur.length += 1;
+            int cur_read_end = cur.read_pos + static_cast<int>(cur.length);
+            if (matches[i].shift() == matches[i-1].shift() &&
+                matches[i].read_pos <= cur_read_end) { // extend current match
+                cur.length = std::max(cur.length, static_cast<size_t>(matches[i].read_pos + static_cast<int>(K) -
+                                                                      cur.read_pos));
             } else { // save match and start new one
                 res.push_back(cur);
                 cur = { matches[i].needle_pos, matches[i].read_pos, K };
             }
         }
         res.push_back(cur); // save last match
-        return res;
     }
 }
\ No newline at end of file
@@ -1,20 +1,12 @@
 #pragma once
 
+#include <memory>
+
 #include "pairwise_block_alignment.hpp"
+#include "match_chaining.hpp"
 #include "../hashes/subject_query_kmer_index.hpp"
 
 namespace algorithms {
-    struct BlockAlignmentScoringScheme {
-        int max_global_gap;
-        int max_local_deletions;
-        int max_local_insertions;
-        int gap_opening_cost;
-        int gap_extention_cost;
-        int match_reward;
-        int mismatch_extention_cost;
-        int mismatch_opening_cost;
-    };
-
     struct BlockAlignerParams {
         size_t min_kmer_coverage;
         size_t max_candidates;
@@ -24,92 +16,255 @@ namespace algorithms {
                 max_candidates(max_candidates) { }
     };
 
+    // compile-time parameters of PairwiseBlockAligner:
+    // Accessor - type of accessor of subjects of k-mer index (KmerIndexHelper or its final descendant)
+    // ScoringType - BlockAlignmentScoringScheme or StaticBlockAlignmentScoring
+    // K - size of k-mers of the index, 0 means that it is known at run time only
+    template<typename Accessor, typename ScoringType = BlockAlignmentScoringScheme, size_t K = 0>
+    struct BlockAlignerPolicy {
+        typedef Accessor SubjectAccessor;
+        typedef ScoringType Scoring;
+        static const size_t k = K;
+    };
+
+    template<typename Accessor, typename ScoringType, size_t K>
+    const size_t BlockAlignerPolicy<Accessor, ScoringType, K>::k;
+
+    // interface that allows to select specialization of aligner at run time
+    template<typename SubjectDatabase, typename StringType>
+    class BlockAligner {
+    public:
+        virtual BlockAlignmentHits<SubjectDatabase> Align(const StringType &query) = 0;
+
+        // aligns suffix of query starting at window_start without copying it,
+        // positions of alignment are relative to window_start
+        virtual BlockAlignmentHits<SubjectDatabase> AlignWindow(const StringType &query, size_t window_start) = 0;
+
+        // aligns query_index-th query of batch that was resolved by the k-mer index of the aligner
+        virtual BlockAlignmentHits<SubjectDatabase> Align(const StringType &query,
+                                                          const KmerLookupBatch &batch,
+                                                          size_t query_index) = 0;
+
+        // the same as above, but alignments replace previous content of hits,
+        // so the caller can reuse memory of hits across queries
+        virtual void Align(const StringType &query, BlockAlignmentHits<SubjectDatabase> &hits) = 0;
+
+        virtual void AlignWindow(const StringType &query, size_t window_start,
+                                 BlockAlignmentHits<SubjectDatabase> &hits) = 0;
+
+        virtual void Align(const StringType &query, const KmerLookupBatch &batch, size_t query_index,
+                           BlockAlignmentHits<SubjectDatabase> &hits) = 0;
+
+        virtual ~BlockAligner() { }
+    };
+
     std::vector<Match> combine_sequential_kmer_matches(std::vector<KmerMatch> &matches,
                                                        size_t K);
 
-    template<typename SubjectDatabase, typename StringType>
-    class PairwiseBlockAligner {
-        const SubjectQueryKmerIndex<SubjectDatabase, StringType> &kmer_index_;
-        KmerIndexHelper<SubjectDatabase, StringType> &kmer_index_helper_;
-        const BlockAlignmentScoringScheme scoring_;
+    // combined matches replace previous content of res
+    void combine_sequential_kmer_matches(std::vector<KmerMatch> &matches,
+                                         size_t K,
+                                         std::vector<Match> &res);
+
+    // aligner keeps buffers that are reused across queries, so it should not be shared between threads
+    template<typename SubjectDatabase, typename StringType,
+             typename Policy = BlockAlignerPolicy<KmerIndexHelper<SubjectDatabase, StringType>>>
+    class PairwiseBlockAligner : public BlockAligner<SubjectDatabase, StringType> {
+    public:
+        typedef typename Policy::SubjectAccessor SubjectAccessor;
+        typedef typename Policy::Scoring Scoring;
+        typedef SubjectQueryKmerIndex<SubjectDatabase, StringType, SubjectAccessor> KmerIndex;
+
+    private:
+        const KmerIndex &kmer_index_;
+        const SubjectAccessor &kmer_index_helper_;
+        const Scoring scoring_;
         const BlockAlignerParams params_;
 
-        PairwiseBlockAlignment MakeAlignment(const std::vector<Match> &combined,
-                                          const StringType &query,
-                                          size_t subject_index) const {
-            auto has_edge = [this](const Match &a, const Match &b) -> bool {
-                int read_gap = b.read_pos - a.read_pos;
-                int needle_gap = b.subject_pos - a.subject_pos;
-                int gap = read_gap - needle_gap;
-                if (gap > scoring_.max_local_insertions || -gap > scoring_.max_local_deletions) return false;
-                // Crossing check
-                if (a.subject_pos >= b.subject_pos || a.read_pos >= b.read_pos) return false;
-                return true;
-            };
-
-            auto vertex_weight = [this](const Match &m) -> double {
-                return double(m.length) * double(scoring_.match_reward);
-            };
-
-            auto edge_weight = [this](const Match &a, const Match &b) -> double {
-                int read_gap = b.read_pos - a.read_pos;
-                int needle_gap = b.subject_pos - a.subject_pos;
-                int gap = read_gap - needle_gap;
-                int mmatch = std::min(b.read_pos - a.read_pos - int(a.length),
-                                      b.subject_pos - a.subject_pos - int(a.length));
-                mmatch = std::max(0, mmatch);
-                return - Match::overlap(a, b)
-                       - ((gap) ? (scoring_.gap_opening_cost + std::abs(gap) * scoring_.gap_extention_cost) : 0)
-                       - ((mmatch) ? scoring_.mismatch_opening_cost + mmatch * scoring_.mismatch_extention_cost : 0);
-            };
-
-            auto longest_path = weighted_longest_path_in_DAG(combined, has_edge, edge_weight, vertex_weight);
-            return PairwiseBlockAlignment(longest_path.first,
-                                          kmer_index_helper_.GetStringLength(
-                                                  kmer_index_helper_.GetDbRecordByIndex(subject_index)),
-                                          kmer_index_helper_.GetStringLength(query),
-                                          longest_path.second);
+        // workspace
+        SubjectKmerMatches subject_matches_;
+        MinimizerQueue minimizer_queue_;
+        std::vector<Match> combined_;
+        BasicSparseMatchChainer<Scoring> chainer_;
+        // pairs (-upper bound of score, subject index) of subjects that share k-mers with the query
+        std::vector<std::pair<int, size_t>> bounds_;
+        // pairs (-score, subject index) of top subjects with correct alignment paths,
+        // it is a max-heap, so the worst of top subjects is at the front
+        std::vector<std::pair<int, size_t>> candidates_;
+
+        size_t K() const { return Policy::k != 0 ? Policy::k : kmer_index_.k(); }
+
+        // upper bounds are valid only if edge weights of alignment path are not positive
+        bool PruningEnabled() const {
+            return params_.max_candidates != 0 and scoring_.match_reward >= 0 and
+                    scoring_.gap_opening_cost >= 0 and scoring_.gap_extention_cost >= 0 and
+                    scoring_.mismatch_opening_cost >= 0 and scoring_.mismatch_extention_cost >= 0;
         }
 
-        bool CheckAlignment(const PairwiseBlockAlignment &alignment) const {
-            // TODO split into 2 args (ins/dels) positive gap is deletion here
-            if (std::abs(alignment.path.global_gap()) > scoring_.max_global_gap)
-                return false; // Omit such match
-            return alignment.path.kplus_length() >= params_.min_kmer_coverage;
+        // matches of alignment path do not overlap in the query after truncation of overlaps, so for match reward
+        // at most 1 score does not exceed match_reward * (number of query positions covered by k-mer matches);
+        // otherwise the path is not longer than all combined matches
+        int ScoreUpperBound(size_t subject_index) {
+            const auto &matches = subject_matches_[subject_index];
+            int k = int(K());
+            if(scoring_.match_reward > 1)
+                return scoring_.match_reward * k * int(matches.size());
+            // k-mer matches are added in the order of their query positions
+            int covered = 0;
+            int covered_end = std::numeric_limits<int>::min();
+            for(auto it = matches.cbegin(); it != matches.cend(); it++) {
+                int start = std::max(it->read_pos, covered_end);
+                int end = it->read_pos + k;
+                if(end > start) {
+                    covered += end - start;
+                    covered_end = end;
+                }
+            }
+            return scoring_.match_reward * covered;
         }
 
-        BlockAlignmentHits<SubjectDatabase> QueryUnordered(const StringType &query) {
-            SubjectKmerMatches subj_matches = kmer_index_.GetSubjectKmerMatchesForQuery(query);
-            BlockAlignmentHits<SubjectDatabase> result(kmer_index_.Db());
-            for(size_t i = 0; i < subj_matches.size(); i++) {
-                auto &matches = subj_matches[i];
-                if(matches.empty())
+        // subjects are aligned in the order of decreasing upper bounds of their scores,
+        // alignment stops as soon as the bound is below the score of the worst of top max_candidates subjects
+        void SelectCandidates() {
+            const auto &matched_subjects = subject_matches_.MatchedSubjects();
+            bounds_.clear();
+            for(auto it = matched_subjects.cbegin(); it != matched_subjects.cend(); it++)
+                bounds_.push_back(std::make_pair(-ScoreUpperBound(*it), *it));
+            bool pruning_enabled = PruningEnabled();
+            if(pruning_enabled)
+                std::sort(bounds_.begin(), bounds_.end());
+            candidates_.clear();
+            for(auto it = bounds_.cbegin(); it != bounds_.cend(); it++) {
+                bool top_is_full = params_.max_candidates != 0 and candidates_.size() == params_.max_candidates;
+                // subjects with equal scores are ordered by indices, so the bound should be strictly less
+                if(pruning_enabled and top_is_full and -it->first < -candidates_.front().first)
+                    break;
+                int score = 0;
+                if(!ComputeAlignmentPath(it->second, score))
                     continue;
-                std::vector<Match> combined = combine_sequential_kmer_matches(matches, kmer_index_.k());
-                std::sort(combined.begin(), combined.end(),
-                          [](const Match &a, const Match &b) -> bool { return a.subject_pos < b.subject_pos; });
-                assert(combined.size() > 0);
-                PairwiseBlockAlignment align = MakeAlignment(combined, query, i);
-                if (CheckAlignment(align)) {
-                    result.Add(std::move(align), i);
+                auto candidate = std::make_pair(-score, it->second);
+                if(!top_is_full) {
+                    candidates_.push_back(candidate);
+                    std::push_heap(candidates_.begin(), candidates_.end());
+                }
+                else if(candidate < candidates_.front()) {
+                    std::pop_heap(candidates_.begin(), candidates_.end());
+                    candidates_.back() = candidate;
+                    std::push_heap(candidates_.begin(), candidates_.end());
                 }
             }
-            return result;
+        }
+
+        // computes alignment path to the subject in workspace, returns false if the path does not pass the check
+        bool ComputeAlignmentPath(size_t subject_index, int &score) {
+            auto &matches = subject_matches_[subject_index];
+            combine_sequential_kmer_matches(matches, K(), combined_);
+            std::sort(combined_.begin(), combined_.end(),
+                      [](const Match &a, const Match &b) -> bool { return a.subject_pos < b.subject_pos; });
+            score = chainer_.Chain(combined_);
+            return CheckAlignmentPath(chainer_.Path());
+        }
+
+        // constructs alignment from the path that was computed last
+        PairwiseBlockAlignment MakeAlignment(size_t query_length, size_t subject_index, int score) const {
+            AlignmentPath path = chainer_.Path();
+            return PairwiseBlockAlignment(path,
+                                          kmer_index_.SubjectLength(subject_index),
+                                          query_length,
+                                          score);
+        }
+
+        bool CheckAlignmentPath(const AlignmentPath &path) const {
+            // TODO split into 2 args (ins/dels) positive gap is deletion here
+            if (std::abs(path.global_gap()) > scoring_.max_global_gap)
+                return false; // Omit such match
+            return path.kplus_length() >= params_.min_kmer_coverage;
+        }
+
+        // scores of subjects that share k-mers with the query (subject_matches_) are computed first,
+        // alignments are constructed only for the top candidates
+        void AlignMatchedSubjects(size_t query_length, BlockAlignmentHits<SubjectDatabase> &hits) {
+            SelectCandidates();
+            // zero max_candidates means that all hits are reported, the same as in BlockAlignmentHits::SelectTopRecords
+            size_t limit = candidates_.size();
+            hits.Clear();
+            hits.Reserve(limit);
+            for(size_t i = 0; i < limit; i++) {
+                size_t subject_index = candidates_[i].second;
+                int score = 0;
+                ComputeAlignmentPath(subject_index, score);
+                hits.Add(MakeAlignment(query_length, subject_index, score), subject_index);
+            }
+            hits.SelectTopRecords(params_.max_candidates);
         }
 
     public:
-        PairwiseBlockAligner(const SubjectQueryKmerIndex<SubjectDatabase, StringType> &kmer_index,
-                             KmerIndexHelper<SubjectDatabase, StringType> &kmer_index_helper,
-                             BlockAlignmentScoringScheme scoring, BlockAlignerParams params) :
+        PairwiseBlockAligner(const KmerIndex &kmer_index,
+                             const SubjectAccessor &kmer_index_helper,
+                             Scoring scoring, BlockAlignerParams params) :
                 kmer_index_(kmer_index),
                 kmer_index_helper_(kmer_index_helper),
                 scoring_(scoring),
-                params_(params) { }
+                params_(params),
+                subject_matches_(kmer_index.NumSubjects()),
+                chainer_(scoring) {
+            VERIFY_MSG(Policy::k == 0 or Policy::k == kmer_index.k(), "Aligner is specialized for k = " <<
+                    Policy::k << ", but k-mer index is constructed for k = " << kmer_index.k());
+        }
+
+        BlockAlignmentHits<SubjectDatabase> Align(const StringType &query) final {
+            BlockAlignmentHits<SubjectDatabase> hits(kmer_index_.Db());
+            Align(query, hits);
+            return hits;
+        }
+
+        BlockAlignmentHits<SubjectDatabase> AlignWindow(const StringType &query, size_t window_start) final {
+            BlockAlignmentHits<SubjectDatabase> hits(kmer_index_.Db());
+            AlignWindow(query, window_start, hits);
+            return hits;
+        }
+
+        BlockAlignmentHits<SubjectDatabase> Align(const StringType &query,
+                                                  const KmerLookupBatch &batch,
+                                                  size_t query_index) final {
+            BlockAlignmentHits<SubjectDatabase> hits(kmer_index_.Db());
+            Align(query, batch, query_index, hits);
+            return hits;
+        }
+
+        void Align(const StringType &query, BlockAlignmentHits<SubjectDatabase> &hits) final {
+            kmer_index_.GetSubjectKmerMatchesForQuery(query, subject_matches_, minimizer_queue_);
+            AlignMatchedSubjects(kmer_index_helper_.GetStringLength(query), hits);
+        }
 
-        BlockAlignmentHits<SubjectDatabase> Align(const StringType &query) {
-            auto result = QueryUnordered(query);
-            result.SelectTopRecords(params_.max_candidates);
-            return result;
+        void AlignWindow(const StringType &query, size_t window_start,
+                         BlockAlignmentHits<SubjectDatabase> &hits) final {
+            size_t query_length = kmer_index_helper_.GetStringLength(query);
+            VERIFY_MSG(window_start <= query_length, "Window start " << window_start <<
+                    " exceeds length of query " << query_length);
+            kmer_index_.GetSubjectKmerMatchesForQuery(query, subject_matches_, minimizer_queue_, window_start);
+            AlignMatchedSubjects(query_length - window_start, hits);
+        }
+
+        void Align(const StringType &query, const KmerLookupBatch &batch, size_t query_index,
+                   BlockAlignmentHits<SubjectDatabase> &hits) final {
+            batch.FillSubjectKmerMatches(query_index, subject_matches_);
+            AlignMatchedSubjects(kmer_index_helper_.GetStringLength(query), hits);
         }
     };
+
+    // returns aligner specialized by StaticPolicy if k of the index and scoring scheme coincide with its
+    // compile-time parameters, otherwise returns aligner that uses the run-time parameters
+    template<typename SubjectDatabase, typename StringType, typename StaticPolicy>
+    std::shared_ptr<BlockAligner<SubjectDatabase, StringType>> CreateSpecializedBlockAligner(
+            const SubjectQueryKmerIndex<SubjectDatabase, StringType, typename StaticPolicy::SubjectAccessor> &kmer_index,
+            const typename StaticPolicy::SubjectAccessor &kmer_index_helper,
+            BlockAlignmentScoringScheme scoring, BlockAlignerParams params) {
+        typedef typename StaticPolicy::SubjectAccessor SubjectAccessor;
+        if(kmer_index.k() == StaticPolicy::k and scoring == StaticPolicy::Scoring::Scheme())
+            return std::make_shared<PairwiseBlockAligner<SubjectDatabase, StringType, StaticPolicy>>(
+                    kmer_index, kmer_index_helper, typename StaticPolicy::Scoring(), params);
+        return std::make_shared<PairwiseBlockAligner<SubjectDatabase, StringType,
+                BlockAlignerPolicy<SubjectAccessor>>>(kmer_index, kmer_index_helper, scoring, params);
+    }
 }
@@ -115,9 +115,17 @@ namespace algorithms {
             return *this;
         }
 
+        void Reserve(size_t num_alignments) { alignment_indices_.reserve(num_alignments); }
+
+        // removes all alignments but keeps allocated memory, so the object can be reused for the next query
+        void Clear() {
+            alignment_indices_.clear();
+            sorted_ = false;
+        }
+
         void Add(PairwiseBlockAlignment block_alignment, size_t db_index) {
             VERIFY(db_index < db_.size()); // use Helper?
-            alignment_indices_.push_back(std::make_pair(block_alignment, db_index));
+            alignment_indices_.push_back(std::make_pair(std::move(block_alignment), db_index));
         }
 
         typedef std::vector<std::pair<PairwiseBlockAlignment, size_t>>::const_iterator
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+#include <seqan/sequence.h>
+
+namespace algorithms {
+    // k-mer is encoded by 2 bits per nucleotide (A = 0, C = 1, G = 2, T = 3), so encoding is exact for k <= 32
+    // pos is start position of k-mer in the sequence
+    struct EncodedKmer {
+        uint64_t code;
+        size_t pos;
+    };
+
+    const size_t max_encoded_kmer_size = 32;
+
+    inline uint64_t EncodedKmerMask(size_t k) {
+        return k >= max_encoded_kmer_size ? std::numeric_limits<uint64_t>::max() : (uint64_t(1) << (2 * k)) - 1;
+    }
+
+    // rolling encoder of k-mers of a nucleotide sequence, k-mers containing N (any symbol with ordinal value > 3)
+    // are skipped. Iterator keeps a pointer to the sequence and does not allocate memory
+    // if window [start, length) of the sequence is encoded, positions of k-mers are relative to start
+    // StringType should support [] that returns value convertible to unsigned, e.g., seqan::Dna5String
+    template<typename StringType>
+    class KmerIterator {
+        const StringType *s_;
+        size_t start_;
+        size_t length_;
+        size_t k_;
+        uint64_t mask_;
+        // position of the next nucleotide that will be read, length_ + 1 for end iterator
+        size_t next_;
+        // number of consecutive non-N nucleotides before next_
+        size_t num_valid_;
+        EncodedKmer kmer_;
+
+        void Advance() {
+            while(next_ < length_) {
+                unsigned nucl = unsigned((*s_)[next_++]);
+                if(nucl > 3) {
+                    num_valid_ = 0;
+                    kmer_.code = 0;
+                    continue;
+                }
+                kmer_.code = ((kmer_.code << 2) | nucl) & mask_;
+                if(++num_valid_ >= k_) {
+                    kmer_.pos = next_ - k_ - start_;
+                    return;
+                }
+            }
+            next_ = length_ + 1;
+        }
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef EncodedKmer value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const EncodedKmer* pointer;
+        typedef const EncodedKmer& reference;
+
+        // end iterator
+        KmerIterator(const StringType &s, size_t length) :
+                s_(&s), start_(0), length_(length), k_(0), mask_(0), next_(length + 1), num_valid_(0),
+                kmer_({0, 0}) { }
+
+        KmerIterator(const StringType &s, size_t start, size_t length, size_t k) :
+                s_(&s), start_(start), length_(length), k_(k), mask_(EncodedKmerMask(k)), next_(start),
+                num_valid_(0), kmer_({0, 0}) {
+            Advance();
+        }
+
+        KmerIterator(const StringType &s, size_t length, size_t k) : KmerIterator(s, 0, length, k) { }
+
+        const EncodedKmer& operator*() const { return kmer_; }
+
+        const EncodedKmer* operator->() const { return &kmer_; }
+
+        KmerIterator& operator++() {
+            Advance();
+            return *this;
+        }
+
+        KmerIterator operator++(int) {
+            KmerIterator tmp = *this;
+            Advance();
+            return tmp;
+        }
+
+        bool operator==(const KmerIterator &other) const { return s_ == other.s_ and next_ == other.next_; }
+
+        bool operator!=(const KmerIterator &other) const { return !(*this == other); }
+    };
+
+    // range of k-mers of a sequence, e.g.:
+    //   for(const EncodedKmer &kmer : KmerRange<seqan::Dna5String>(read, k)) ...
+    template<typename StringType>
+    class KmerRange {
+        const StringType &s_;
+        size_t start_;
+        size_t length_;
+        size_t k_;
+
+    public:
+        // k-mers of window [start, length) of s
+        KmerRange(const StringType &s, size_t start, size_t length, size_t k) :
+                s_(s), start_(start), length_(length), k_(k) { }
+
+        KmerRange(const StringType &s, size_t length, size_t k) : KmerRange(s, 0, length, k) { }
+
+        // WARNING: requires seqan::length() for StringType
+        KmerRange(const StringType &s, size_t k) : KmerRange(s, seqan::length(s), k) { }
+
+        KmerIterator<StringType> begin() const { return KmerIterator<StringType>(s_, start_, length_, k_); }
+
+        KmerIterator<StringType> end() const { return KmerIterator<StringType>(s_, length_); }
+    };
+
+    template<typename StringType>
+    KmerRange<StringType> Kmers(const StringType &s, size_t k) {
+        return KmerRange<StringType>(s, k);
+    }
+
+    // calls kmer_handler(kmer_code, start_position) for every k-mer of window [start, length) of s
+    // that does not contain N, positions are relative to start
+    template<typename StringType, typename KmerHandler>
+    void ForEachKmer(const StringType &s, size_t start, size_t length, size_t k, KmerHandler kmer_handler) {
+        for(const EncodedKmer &kmer : KmerRange<StringType>(s, start, length, k))
+            kmer_handler(kmer.code, kmer.pos);
+    }
+
+    template<typename StringType, typename KmerHandler>
+    void ForEachKmer(const StringType &s, size_t length, size_t k, KmerHandler kmer_handler) {
+        ForEachKmer(s, 0, length, k, kmer_handler);
+    }
+
+    // order of k-mers for selection of minimizers, the mixing is invertible, so distinct k-mers have distinct orders
+    // and low-complexity k-mers (e.g., poly-A) are not preferred
+    inline uint64_t MinimizerOrder(uint64_t code) {
+        code ^= code >> 33;
+        code *= 0xff51afd7ed558ccdULL;
+        code ^= code >> 33;
+        code *= 0xc4ceb9fe1a85ec53ULL;
+        code ^= code >> 33;
+        return code;
+    }
+
+    // k-mer with its order in the monotone queue of ForEachMinimizer
+    struct OrderedKmer {
+        uint64_t order;
+        EncodedKmer kmer;
+    };
+
+    // workspace of ForEachMinimizer, it can be reused between calls to avoid allocation of the queue for every query
+    typedef std::vector<OrderedKmer> MinimizerQueue;
+
+    // calls kmer_handler(kmer_code, start_position) for every (w, k)-minimizer of s, i.e., for k-mer of the minimal
+    // order among each w consecutive k-mer positions (the leftmost one in case of ties)
+    // k-mers containing N are skipped, a sequence shorter than k + w - 1 contributes its minimal k-mer
+    // minimizers are reported once in the increasing order of positions, w = 1 gives all k-mers
+    // two sequences sharing a substring of length at least k + w - 1 share at least one minimizer
+    // only window [start, length) of s is sampled, positions are relative to start
+    // queue is the workspace, its content is replaced
+    template<typename StringType, typename KmerHandler>
+    void ForEachMinimizer(const StringType &s, size_t start, size_t length, size_t k, size_t w,
+                          MinimizerQueue &queue, KmerHandler kmer_handler) {
+        if(w <= 1) {
+            ForEachKmer(s, start, length, k, kmer_handler);
+            return;
+        }
+        // monotone queue of k-mers of the current window, orders increase from head to tail
+        queue.resize(w);
+        size_t head = 0;
+        size_t size = 0;
+        size_t last_reported = std::numeric_limits<size_t>::max();
+        for(const EncodedKmer &kmer : KmerRange<StringType>(s, start, length, k)) {
+            uint64_t order = MinimizerOrder(kmer.code);
+            while(size > 0 and queue[(head + size - 1) % w].order > order)
+                size--;
+            while(size > 0 and queue[head].kmer.pos + w <= kmer.pos) {
+                head = (head + 1) % w;
+                size--;
+            }
+            queue[(head + size) % w] = {order, kmer};
+            size++;
+            const EncodedKmer &minimizer = queue[head].kmer;
+            if(kmer.pos + 1 >= w and minimizer.pos != last_reported) {
+                kmer_handler(minimizer.code, minimizer.pos);
+                last_reported = minimizer.pos;
+            }
+        }
+        if(last_reported == std::numeric_limits<size_t>::max() and size > 0)
+            kmer_handler(queue[head].kmer.code, queue[head].kmer.pos);
+    }
+
+    template<typename StringType, typename KmerHandler>
+    void ForEachMinimizer(const StringType &s, size_t start, size_t length, size_t k, size_t w,
+                          KmerHandler kmer_handler) {
+        MinimizerQueue queue;
+        ForEachMinimizer(s, start, length, k, w, queue, kmer_handler);
+    }
+
+    template<typename StringType, typename KmerHandler>
+    void ForEachMinimizer(const StringType &s, size_t length, size_t k, size_t w, KmerHandler kmer_handler) {
+        ForEachMinimizer(s, 0, length, k, w, kmer_handler);
+    }
+}
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <verify.hpp>
 
+#include "kmer_generator.hpp"
+
 namespace algorithms {
 
     struct KmerMatch {
@@ -21,6 +24,8 @@ namespace algorithms {
     class SubjectKmerMatches {
         std::vector<std::vector<KmerMatch>> kmer_matches_;
         size_t num_subjects_;
+        // indices of subjects that have at least one match
+        std::vector<size_t> matched_subjects_;
 
     public:
         SubjectKmerMatches(size_t num_subjects) :
@@ -29,11 +34,23 @@ namespace algorithms {
 
         void Update(size_t subject_index, KmerMatch kmer_match) {
             VERIFY(subject_index < num_subjects_);
+            if(kmer_matches_[subject_index].empty())
+                matched_subjects_.push_back(subject_index);
             kmer_matches_[subject_index].push_back(kmer_match);
         }
 
+        // removes all matches but keeps allocated memory, so the object can be reused for the next query
+        void Clear() {
+            for(auto it = matched_subjects_.begin(); it != matched_subjects_.end(); it++)
+                kmer_matches_[*it].clear();
+            matched_subjects_.clear();
+        }
+
         size_t size() const { return kmer_matches_.size(); }
 
+        // subjects are listed in the order of their first matches
+        const std::vector<size_t>& MatchedSubjects() const { return matched_subjects_; }
+
         std::vector<KmerMatch>& operator[](size_t subject_index) {
             VERIFY(subject_index < num_subjects_);
             return kmer_matches_[subject_index];
@@ -46,6 +63,105 @@ namespace algorithms {
         SubjectKmerMatchesIterator cend() const { return kmer_matches_.cend(); }
     };
 
+    // occurrence of k-mer in subject database
+    struct KmerSubjectPosition {
+        uint32_t subject_index;
+        uint32_t position;
+    };
+
+    // view of positions of a single k-mer, does not own the memory
+    class KmerSubjectPositionRange {
+        const KmerSubjectPosition *begin_;
+        const KmerSubjectPosition *end_;
+
+    public:
+        KmerSubjectPositionRange(const KmerSubjectPosition *begin, const KmerSubjectPosition *end) :
+                begin_(begin), end_(end) { }
+
+        const KmerSubjectPosition* begin() const { return begin_; }
+
+        const KmerSubjectPosition* end() const { return end_; }
+
+        size_t size() const { return size_t(end_ - begin_); }
+
+        bool empty() const { return begin_ == end_; }
+    };
+
+    // hint to load memory at address into cache before it is accessed
+    inline void PrefetchForRead(const void *address) {
+#if defined(__GNUC__)
+        __builtin_prefetch(address, 0, 3);
+#else
+        (void)address;
+#endif
+    }
+
+    // k-mer lookups of a block of queries that are resolved in bulk by the k-mer index (see LookupQueries),
+    // positions of k-mers refer to memory of the index, so the batch is valid while the index exists
+    // the batch is a workspace: its memory is reused by the next lookup, so it should not be shared between threads
+    class KmerLookupBatch {
+    public:
+        struct ResolvedKmer {
+            uint64_t code;
+            size_t query_pos;
+            const KmerSubjectPosition *begin;
+            const KmerSubjectPosition *end;
+        };
+
+    private:
+        std::vector<ResolvedKmer> kmers_;
+        // k-mers of i-th query are [query_offsets_[i], query_offsets_[i + 1])
+        std::vector<size_t> query_offsets_;
+        MinimizerQueue minimizer_queue_;
+
+    public:
+        KmerLookupBatch() : query_offsets_(1, 0) { }
+
+        void Clear() {
+            kmers_.clear();
+            query_offsets_.assign(1, 0);
+        }
+
+        // k-mer of the current query, its positions are unresolved until the index resolves the batch
+        void AddKmer(uint64_t code, size_t query_pos) {
+            kmers_.push_back({code, query_pos, nullptr, nullptr});
+        }
+
+        void FinishQuery() { query_offsets_.push_back(kmers_.size()); }
+
+        size_t NumQueries() const { return query_offsets_.size() - 1; }
+
+        std::vector<ResolvedKmer>& Kmers() { return kmers_; }
+
+        // workspace of sampling of minimizers of queries
+        MinimizerQueue& Queue() { return minimizer_queue_; }
+
+        // total number of occurrences of k-mers of query in subjects
+        size_t NumKmerHits(size_t query_index) const {
+            VERIFY(query_index < NumQueries());
+            size_t num_hits = 0;
+            for(size_t i = query_offsets_[query_index]; i < query_offsets_[query_index + 1]; i++)
+                num_hits += size_t(kmers_[i].end - kmers_[i].begin);
+            return num_hits;
+        }
+
+        // matches of query replace previous content of subj_kmer_matches, order of matches is the same as in
+        // SubjectQueryKmerIndex::GetSubjectKmerMatchesForQuery
+        void FillSubjectKmerMatches(size_t query_index, SubjectKmerMatches &subj_kmer_matches) const {
+            VERIFY(query_index < NumQueries());
+            subj_kmer_matches.Clear();
+            for(size_t i = query_offsets_[query_index]; i < query_offsets_[query_index + 1]; i++) {
+                const ResolvedKmer &kmer = kmers_[i];
+                for(auto it = kmer.begin; it != kmer.end; it++)
+                    subj_kmer_matches.Update(it->subject_index, {static_cast<int>(it->position),
+                                                                 static_cast<int>(kmer.query_pos)});
+            }
+        }
+    };
+
+    // accessor of subjects of k-mer index, records are returned as views of the database without copying
+    // indices and aligners are parameterized by the type of accessor, so if the derived accessor is final,
+    // calls are resolved at compile time
     template<typename SubjectDatabase, typename StringType>
     class KmerIndexHelper {
     protected:
@@ -54,7 +170,9 @@ namespace algorithms {
     public:
         KmerIndexHelper(const SubjectDatabase &db) : db_(db) { }
 
-        virtual StringType GetDbRecordByIndex(size_t index) const = 0;// {
+        virtual ~KmerIndexHelper() { }
+
+        virtual const StringType& GetDbRecordByIndex(size_t index) const = 0;// {
         //    return db_[index];
         //}
 
@@ -1,91 +1,232 @@
 #pragma once
 
-#include "polyhashes.hpp"
 #include "kmer_index_primitives.hpp"
+#include "kmer_generator.hpp"
 
-#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
 
 namespace algorithms {
     // SubjectDatabase - type of sequence storage
     // StringType - type of sequences
     // QueryType - type of query object
+    // SubjectAccessor - KmerIndexHelper or its final descendant that allows to devirtualize access to subjects
     // default implementation works for any type of simple collections that support [] and .size(), e.g., std::vector
     // and StringType and QueryType are standard types of sequences, e.g., c-style, std::string and seqan sequences
-    template<typename SubjectDatabase, typename StringType>
+    //
+    // k-mers are encoded by 2 bits per nucleotide (k <= 32), k-mers containing N are not indexed
+    // if minimizer window w > 1, only (w, k)-minimizers of subjects are indexed and only minimizers of query
+    // are looked up, so the index and the number of k-mer matches shrink roughly w / 2 times
+    // index is stored in CSR layout: positions of all k-mers are kept in one contiguous array sorted by k-mer code,
+    // offsets of k-mers are stored either in direct-address table (small k) or along with a sorted array of codes
+    template<typename SubjectDatabase, typename StringType,
+             typename SubjectAccessor = KmerIndexHelper<SubjectDatabase, StringType>>
     class SubjectQueryKmerIndex {
     public:
-        struct SubjectPosition {
-            size_t subject_index;
-            size_t position;
-        };
+        typedef KmerSubjectPosition SubjectPosition;
+        typedef KmerSubjectPositionRange SubjectPositionRange;
+
+        static const size_t max_k = max_encoded_kmer_size;
+        // direct-address table is used if it contains at most 4^max_direct_address_k entries
+        static const size_t max_direct_address_k = 10;
+        // number of k-mers between prefetch of offsets of k-mer and its lookup in LookupQueries
+        static const size_t lookup_prefetch_distance = 16;
 
     private:
         // input parameters
         const SubjectDatabase & db_;
         size_t k_;
-        KmerIndexHelper<SubjectDatabase, StringType>& kmer_index_helper_;
+        const SubjectAccessor& kmer_index_helper_;
+        size_t minimizer_window_;
 
         // inner structure
-        std::unordered_map<size_t, std::vector<SubjectPosition>> kmer_query_pos_map_;
+        bool direct_address_;
+        // direct-address mode: positions of k-mer c are [offsets_[c], offsets_[c + 1])
+        // sorted mode: positions of kmer_codes_[i] are [offsets_[i], offsets_[i + 1])
+        std::vector<uint32_t> offsets_;
+        std::vector<uint64_t> kmer_codes_;
+        std::vector<SubjectPosition> positions_;
+        std::vector<size_t> subject_lengths_;
+
+        // calls kmer_handler(kmer_code, start_position) for every sampled k-mer of suffix of s starting at start
+        // that does not contain N, positions are relative to start, queue is the workspace of sampling
+        template<typename KmerHandler>
+        void ForEachKmer(const StringType &s, size_t start, MinimizerQueue &queue, KmerHandler kmer_handler) const {
+            size_t length = kmer_index_helper_.GetStringLength(s);
+            if(minimizer_window_ <= 1)
+                algorithms::ForEachKmer(s, start, length, k_, kmer_handler);
+            else
+                ForEachMinimizer(s, start, length, k_, minimizer_window_, queue, kmer_handler);
+        }
+
+        template<typename KmerHandler>
+        void ForEachKmer(const StringType &s, KmerHandler kmer_handler) const {
+            MinimizerQueue queue;
+            ForEachKmer(s, 0, queue, kmer_handler);
+        }
 
-        void UpdateMap(const std::vector<size_t>& str_hashes, size_t str_length, size_t str_index) {
-            for (size_t start = 0; start + k_ <= str_length; ++start) {
-                kmer_query_pos_map_[str_hashes[start]].push_back({str_index, start});
+        void InitializeDirectAddress() {
+            size_t num_codes = size_t(1) << (2 * k_);
+            offsets_.assign(num_codes + 1, 0);
+            for (size_t j = 0; j < kmer_index_helper_.GetDbSize(); ++j) {
+                ForEachKmer(kmer_index_helper_.GetDbRecordByIndex(j), [this](uint64_t code, size_t) {
+                    offsets_[code + 1]++;
+                });
+            }
+            for(size_t c = 0; c < num_codes; c++)
+                offsets_[c + 1] += offsets_[c];
+            positions_.resize(offsets_[num_codes]);
+            std::vector<uint32_t> fill_pos(offsets_.begin(), offsets_.end() - 1);
+            for (size_t j = 0; j < kmer_index_helper_.GetDbSize(); ++j) {
+                ForEachKmer(kmer_index_helper_.GetDbRecordByIndex(j), [this, j, &fill_pos](uint64_t code,
+                                                                                        size_t pos) {
+                    positions_[fill_pos[code]++] = {static_cast<uint32_t>(j), static_cast<uint32_t>(pos)};
+                });
             }
         }
 
-        void Initialize() {
+        void InitializeSorted() {
+            std::vector<std::pair<uint64_t, SubjectPosition>> kmer_positions;
             for (size_t j = 0; j < kmer_index_helper_.GetDbSize(); ++j) {
-                auto s = kmer_index_helper_.GetDbRecordByIndex(j);
-                auto hashes = polyhashes(s, k_);
-                UpdateMap(hashes, kmer_index_helper_.GetStringLength(s), j);
+                ForEachKmer(kmer_index_helper_.GetDbRecordByIndex(j), [j, &kmer_positions](uint64_t code,
+                                                                                        size_t pos) {
+                    kmer_positions.push_back({code, {static_cast<uint32_t>(j), static_cast<uint32_t>(pos)}});
+                });
+            }
+            // stable sort keeps positions of each k-mer in the order of subjects and positions in subjects
+            std::stable_sort(kmer_positions.begin(), kmer_positions.end(),
+                             [](const std::pair<uint64_t, SubjectPosition> &a,
+                                const std::pair<uint64_t, SubjectPosition> &b) { return a.first < b.first; });
+            positions_.reserve(kmer_positions.size());
+            for(size_t i = 0; i < kmer_positions.size(); i++) {
+                if(i == 0 or kmer_positions[i].first != kmer_positions[i - 1].first) {
+                    kmer_codes_.push_back(kmer_positions[i].first);
+                    offsets_.push_back(static_cast<uint32_t>(i));
+                }
+                positions_.push_back(kmer_positions[i].second);
             }
+            offsets_.push_back(static_cast<uint32_t>(positions_.size()));
+        }
+
+        void Initialize() {
+            VERIFY_MSG(k_ > 0 and k_ <= max_k, "k-mer size " << k_ << " is not in range [1, 32]");
+            subject_lengths_.reserve(kmer_index_helper_.GetDbSize());
+            for(size_t j = 0; j < kmer_index_helper_.GetDbSize(); j++)
+                subject_lengths_.push_back(kmer_index_helper_.GetStringLength(kmer_index_helper_.GetDbRecordByIndex(j)));
+            direct_address_ = k_ <= max_direct_address_k;
+            if(direct_address_)
+                InitializeDirectAddress();
+            else
+                InitializeSorted();
+            VERIFY_MSG(positions_.size() < std::numeric_limits<uint32_t>::max(), "Too many k-mers in the index");
         }
 
     public:
         SubjectQueryKmerIndex(const SubjectDatabase &db,
                               size_t k,
-                              KmerIndexHelper<SubjectDatabase, StringType>& kmer_index_helper) :
+                              const SubjectAccessor& kmer_index_helper,
+                              size_t minimizer_window = 1) :
                 db_(db),
                 k_(k),
-                kmer_index_helper_(kmer_index_helper) {
+                kmer_index_helper_(kmer_index_helper),
+                minimizer_window_(minimizer_window),
+                direct_address_(true) {
             Initialize();
         }
 
         const SubjectDatabase & Db() const { return db_; }
 
-        bool SubjectsContainKmer(size_t kmer) const {
-            return kmer_query_pos_map_.find(kmer) != kmer_query_pos_map_.end();
+        // returns empty range if subjects do not contain kmer
+        SubjectPositionRange GetSubjectPositions(uint64_t kmer) const {
+            if(direct_address_)
+                return SubjectPositionRange(positions_.data() + offsets_[kmer],
+                                            positions_.data() + offsets_[kmer + 1]);
+            auto it = std::lower_bound(kmer_codes_.cbegin(), kmer_codes_.cend(), kmer);
+            if(it == kmer_codes_.cend() or *it != kmer)
+                return SubjectPositionRange(positions_.data(), positions_.data());
+            size_t index = size_t(it - kmer_codes_.cbegin());
+            return SubjectPositionRange(positions_.data() + offsets_[index],
+                                        positions_.data() + offsets_[index + 1]);
         }
 
-        const std::vector<SubjectPosition>& GetSubjectPositions(size_t kmer) const {
-            VERIFY_MSG(SubjectsContainKmer(kmer), "Subjects do not contain kmer " << kmer);
-            return kmer_query_pos_map_.at(kmer);
+        bool SubjectsContainKmer(uint64_t kmer) const {
+            return !GetSubjectPositions(kmer).empty();
         }
 
         size_t NumSubjects() const { return kmer_index_helper_.GetDbSize(); }
 
+        size_t NumPositions() const { return positions_.size(); }
+
+        size_t SubjectLength(size_t subject_index) const {
+            VERIFY(subject_index < subject_lengths_.size());
+            return subject_lengths_[subject_index];
+        }
+
         size_t k() const { return k_; }
 
-        SubjectKmerMatches GetSubjectKmerMatchesForQuery(const StringType &query_str) const {
-            SubjectKmerMatches subj_kmer_matches(NumSubjects());
-            auto query_hashes = polyhashes(query_str, k());
-            size_t start = 0;
-            size_t finish = kmer_index_helper_.GetStringLength(query_str);
-            for(size_t j = start; j < finish - k() + 1; ++j) {
-                auto kmer = query_hashes[j];
-                if(!SubjectsContainKmer(kmer))
-                    continue;
+        // 1 means that all k-mers are indexed
+        size_t MinimizerWindow() const { return minimizer_window_; }
+
+        // total number of occurrences of sampled k-mers of query in subjects
+        size_t NumKmerHits(const StringType &query_str) const {
+            size_t num_hits = 0;
+            ForEachKmer(query_str, [this, &num_hits](uint64_t kmer, size_t) {
+                num_hits += GetSubjectPositions(kmer).size();
+            });
+            return num_hits;
+        }
+
+        // matches of query replace previous content of subj_kmer_matches, its memory and queue are reused
+        // if query_start > 0, only suffix of query starting at query_start is searched without copying it,
+        // positions of matches are relative to query_start
+        void GetSubjectKmerMatchesForQuery(const StringType &query_str, SubjectKmerMatches &subj_kmer_matches,
+                                           MinimizerQueue &queue, size_t query_start = 0) const {
+            VERIFY_MSG(subj_kmer_matches.size() == NumSubjects(), "Matches are created for " <<
+                    subj_kmer_matches.size() << " subjects instead of " << NumSubjects());
+            subj_kmer_matches.Clear();
+            ForEachKmer(query_str, query_start, queue, [this, &subj_kmer_matches](uint64_t kmer,
+                                                                                  size_t kmer_pos_in_query) {
                 auto subj_pos = GetSubjectPositions(kmer);
-                //for (const auto &p : subj_it.second) {
                 for(auto it = subj_pos.begin(); it != subj_pos.end(); it++) {
-                    size_t kmer_pos_in_query = j;
-                    size_t kmer_pos_in_subject = it->position; // p.position;
-                    subj_kmer_matches.Update(it->subject_index, {static_cast<int>(kmer_pos_in_subject),
-                                                             static_cast<int>(kmer_pos_in_query)});
+                    subj_kmer_matches.Update(it->subject_index, {static_cast<int>(it->position),
+                                                                 static_cast<int>(kmer_pos_in_query)});
                 }
+            });
+        }
+
+        void GetSubjectKmerMatchesForQuery(const StringType &query_str, SubjectKmerMatches &subj_kmer_matches,
+                                           size_t query_start = 0) const {
+            MinimizerQueue queue;
+            GetSubjectKmerMatchesForQuery(query_str, subj_kmer_matches, queue, query_start);
+        }
+
+        // resolves k-mers of num_queries queries in bulk: k-mers of all queries are encoded first, then their
+        // positions are looked up while the lookups of k-mers that are lookup_prefetch_distance k-mers ahead
+        // are prefetched, so cache misses of independent k-mers overlap instead of being paid one by one
+        void LookupQueries(const StringType *const *queries, size_t num_queries, KmerLookupBatch &batch) const {
+            batch.Clear();
+            for(size_t i = 0; i < num_queries; i++) {
+                ForEachKmer(*queries[i], 0, batch.Queue(), [&batch](uint64_t kmer, size_t kmer_pos_in_query) {
+                    batch.AddKmer(kmer, kmer_pos_in_query);
+                });
+                batch.FinishQuery();
             }
+            auto &kmers = batch.Kmers();
+            for(size_t i = 0; i < kmers.size(); i++) {
+                if(direct_address_ and i + lookup_prefetch_distance < kmers.size())
+                    PrefetchForRead(offsets_.data() + kmers[i + lookup_prefetch_distance].code);
+                SubjectPositionRange range = GetSubjectPositions(kmers[i].code);
+                kmers[i].begin = range.begin();
+                kmers[i].end = range.end();
+                PrefetchForRead(range.begin());
+            }
+        }
+
+        SubjectKmerMatches GetSubjectKmerMatchesForQuery(const StringType &query_str) const {
+            SubjectKmerMatches subj_kmer_matches(NumSubjects());
+            GetSubjectKmerMatchesForQuery(query_str, subj_kmer_matches);
             return subj_kmer_matches;
         }
     };
-}
\ No newline at end of file
+}
@@ -24,17 +24,20 @@ namespace cdr_labeler {
         INFO("Generation of DB for join segments...");
         germline_utils::CustomGeneDatabase j_db = db_generator.GenerateJoinDb();
         INFO("CDR labeling for V gene segments");
-        auto v_labeling = GermlineDbLabeler(v_db, config_.cdrs_params).ComputeLabeling();
+        const auto &germline_params = config_.vj_finder_config.algorithm_params.germline_params;
+        auto v_labeling = GermlineDbLabeler(v_db, config_.cdrs_params, germline_params.cache_dir).ComputeLabeling();
         INFO("CDR labeling for J gene segments");
-        auto j_labeling = GermlineDbLabeler(j_db, config_.cdrs_params).ComputeLabeling();
+        auto j_labeling = GermlineDbLabeler(j_db, config_.cdrs_params, germline_params.cache_dir).ComputeLabeling();
         INFO("Creation of labeled V and J databases");
         auto labeled_v_db = v_labeling.CreateFilteredDb();
         INFO("Labeled DB of V segments consists of " << labeled_v_db.size() << " records");
         auto labeled_j_db = j_labeling.CreateFilteredDb();
         INFO("Labeled DB of J segments consists of " << labeled_j_db.size() << " records");
         INFO("Alignment against VJ germline segments");
+        vj_finder::VJGermlineIndex germline_index(labeled_v_db, labeled_j_db,
+                                                  config_.vj_finder_config.algorithm_params.aligner_params);
         vj_finder::VJParallelProcessor processor(read_archive, config_.vj_finder_config.algorithm_params,
-                                                 labeled_v_db, labeled_j_db,
+                                                 germline_index,
                                                  config_.run_params.num_threads);
         vj_finder::VJAlignmentInfo alignment_info = processor.Process();
         INFO(alignment_info.NumVJHits() << " reads were aligned; " << alignment_info.NumFilteredReads() <<
@@ -1,4 +1,8 @@
 #include <verify.hpp>
+#include <path_helper.hpp>
+#include <io/mmapped_reader.hpp>
+
+#include <cstring>
 
 #include "immunoglobulin_cdr_labeling/immune_gene_labeling_helper.hpp"
 #include "germline_db_labeler.hpp"
@@ -18,9 +22,141 @@ namespace cdr_labeler {
         return "";
     }
 
+    namespace {
+        const char labeling_magic[8] = {'I', 'G', 'C', 'D', 'R', 'L', 'B', 'L'};
+        const uint64_t labeling_version = 1;
+
+        // CDR ranges and ORF of a single gene
+        struct CDRLabelingRecord {
+            uint64_t cdr1_start;
+            uint64_t cdr1_end;
+            uint64_t cdr2_start;
+            uint64_t cdr2_end;
+            uint64_t cdr3_start;
+            uint64_t cdr3_end;
+            uint64_t orf;
+        };
+
+        void UpdateHasher(germline_utils::ContentHasher &hasher, const germline_utils::GermlineDbCache &cache,
+                          std::string annotation_fname) {
+            hasher.Update(annotation_fname);
+            if(path::FileExists(annotation_fname))
+                hasher.Update(cache.FileContentHash(annotation_fname));
+        }
+
+        template<typename RegionParams>
+        void UpdateHasher(germline_utils::ContentHasher &hasher, const RegionParams &params) {
+            hasher.Update(uint64_t(params.min_length));
+            hasher.Update(uint64_t(params.max_length));
+            hasher.Update(params.residues_before);
+            hasher.Update(params.residues_after);
+        }
+    }
+
+    uint64_t GermlineDbLabeler::ComputeCacheKey() const {
+        germline_utils::ContentHasher hasher;
+        hasher.Update(labeling_version);
+        hasher.Update(uint64_t(gene_db_.Segment()));
+        for(size_t i = 0; i < gene_db_.size(); i++) {
+            hasher.Update(uint64_t(gene_db_[i].Chain().Chain()));
+            hasher.Update(std::string(seqan::toCString(gene_db_[i].name())));
+            hasher.Update(std::string(seqan::toCString(seqan::CharString(gene_db_[i].seq()))));
+        }
+        hasher.Update(uint64_t(cdr_params_.cdr_search_algorithm));
+        const auto &search_params = cdr_params_.annotated_search_params;
+        hasher.Update(uint64_t(search_params.domain_system));
+        UpdateHasher(hasher, cache_, search_params.v_gene_annotation.imgt_v_annotation);
+        UpdateHasher(hasher, cache_, search_params.v_gene_annotation.kabat_v_annotation);
+        for(size_t index : {search_params.v_gene_annotation.v_gene_line_index,
+                            search_params.v_gene_annotation.cdr1_start_line_index,
+                            search_params.v_gene_annotation.cdr1_end_line_index,
+                            search_params.v_gene_annotation.cdr2_start_line_index,
+                            search_params.v_gene_annotation.cdr2_end_line_index,
+                            search_params.v_gene_annotation.fr3_end_index,
+                            search_params.j_gene_annotation.j_gene_line_index,
+                            search_params.j_gene_annotation.cdr3_end_index})
+            hasher.Update(uint64_t(index));
+        UpdateHasher(hasher, cache_, search_params.j_gene_annotation.imgt_j_annotation);
+        UpdateHasher(hasher, cache_, search_params.j_gene_annotation.kabat_j_annotation);
+        UpdateHasher(hasher, cdr_params_.hcdr1_params);
+        hasher.Update(uint64_t(cdr_params_.hcdr1_params.start_pos));
+        hasher.Update(uint64_t(cdr_params_.hcdr1_params.start_shift));
+        UpdateHasher(hasher, cdr_params_.hcdr2_params);
+        hasher.Update(uint64_t(cdr_params_.hcdr2_params.distance_from_cdr1_end));
+        hasher.Update(uint64_t(cdr_params_.hcdr2_params.distance_shift));
+        UpdateHasher(hasher, cdr_params_.hcdr3_params);
+        hasher.Update(uint64_t(cdr_params_.hcdr3_params.distance_from_cdr2_end));
+        hasher.Update(uint64_t(cdr_params_.hcdr3_params.distance_shift));
+        return hasher.Hash();
+    }
+
+    std::string GermlineDbLabeler::CacheBundleFname(uint64_t cache_key) const {
+        std::stringstream prefix;
+        prefix << "cdr_labeling_" << gene_db_.Segment();
+        return cache_.BundleFname(prefix.str(), cache_key);
+    }
+
+    bool GermlineDbLabeler::LoadLabeling(uint64_t cache_key, DbCDRLabeling &cdr_labeling) {
+        std::string fname = CacheBundleFname(cache_key);
+        if(!path::FileExists(fname))
+            return false;
+        MMappedReader reader(fname, false, size_t(-1));
+        const char *data = static_cast<const char*>(reader.data());
+        size_t header_size = sizeof(labeling_magic) + 3 * sizeof(uint64_t);
+        VERIFY_MSG(reader.size() >= header_size and memcmp(data, labeling_magic, sizeof(labeling_magic)) == 0,
+                   fname << " is not a CDR labeling bundle");
+        uint64_t header[3];
+        memcpy(header, data + sizeof(labeling_magic), sizeof(header));
+        VERIFY_MSG(header[0] == labeling_version and header[1] == cache_key and header[2] == gene_db_.size() and
+                   reader.size() == header_size + gene_db_.size() * sizeof(CDRLabelingRecord),
+                   "CDR labeling bundle " << fname << " does not match germline DB");
+        const char *records = data + header_size;
+        for(auto it = gene_db_.cbegin(); it != gene_db_.cend(); it++) {
+            germline_utils::ImmuneGeneDatabase& specific_gene_db = gene_db_.GetDbByGeneType(*it);
+            for(size_t i = 0; i < specific_gene_db.size(); i++) {
+                CDRLabelingRecord record;
+                memcpy(&record, records, sizeof(record));
+                records += sizeof(record);
+                annotation_utils::CDRLabeling gene_labeling(
+                        annotation_utils::CDRRange(size_t(record.cdr1_start), size_t(record.cdr1_end)),
+                        annotation_utils::CDRRange(size_t(record.cdr2_start), size_t(record.cdr2_end)),
+                        annotation_utils::CDRRange(size_t(record.cdr3_start), size_t(record.cdr3_end)),
+                        unsigned(record.orf));
+                specific_gene_db.GetImmuneGeneByIndex(i).SetORF(gene_labeling.orf);
+                cdr_labeling.AddGeneLabeling(specific_gene_db[i], gene_labeling);
+            }
+        }
+        INFO("CDR labeling of " << gene_db_.size() << " records was loaded from " << fname);
+        return true;
+    }
+
+    void GermlineDbLabeler::SaveLabeling(uint64_t cache_key,
+                                         const std::vector<annotation_utils::CDRLabeling> &labelings) const {
+        std::string buffer(labeling_magic, sizeof(labeling_magic));
+        uint64_t header[3] = {labeling_version, cache_key, uint64_t(labelings.size())};
+        buffer.append(reinterpret_cast<const char*>(header), sizeof(header));
+        for(auto it = labelings.begin(); it != labelings.end(); it++) {
+            CDRLabelingRecord record = {it->cdr1.start_pos, it->cdr1.end_pos, it->cdr2.start_pos, it->cdr2.end_pos,
+                                        it->cdr3.start_pos, it->cdr3.end_pos, it->orf};
+            buffer.append(reinterpret_cast<const char*>(&record), sizeof(record));
+        }
+        std::string fname = CacheBundleFname(cache_key);
+        cache_.WriteBundle(fname, buffer);
+        INFO("CDR labeling of " << labelings.size() << " records was saved to " << fname);
+    }
+
     DbCDRLabeling GermlineDbLabeler::ComputeLabeling() {
         DbCDRLabeling cdr_labeling(gene_db_);
         INFO("Algorithm of CDR computation: " << cdr_search_algorithm_to_str(cdr_params_.cdr_search_algorithm));
+        uint64_t cache_key = 0;
+        if(cache_.Enabled()) {
+            cache_key = ComputeCacheKey();
+            if(LoadLabeling(cache_key, cdr_labeling)) {
+                INFO("# records from DB with empty CDR labelings: " << cdr_labeling.NumEmptyLabelings());
+                return cdr_labeling;
+            }
+        }
+        std::vector<annotation_utils::CDRLabeling> labelings;
         for(auto it = gene_db_.cbegin(); it != gene_db_.cend(); it++) {
             germline_utils::ImmuneGeneDatabase& specific_gene_db = gene_db_.GetDbByGeneType(*it);
             auto cdr_labeler = GetImmuneGeneLabeler(specific_gene_db.GeneType());
@@ -28,8 +164,11 @@ namespace cdr_labeler {
                 auto gene_labeling = cdr_labeler->ComputeLabeling(specific_gene_db[i]);
                 specific_gene_db.GetImmuneGeneByIndex(i).SetORF(gene_labeling.orf);
                 cdr_labeling.AddGeneLabeling(specific_gene_db[i], gene_labeling);
+                labelings.push_back(gene_labeling);
             }
         }
+        if(cache_.Enabled())
+            SaveLabeling(cache_key, labelings);
         INFO("# records from DB with empty CDR labelings: " << cdr_labeling.NumEmptyLabelings());
         return cdr_labeling;
     }
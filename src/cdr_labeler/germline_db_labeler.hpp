@@ -1,5 +1,7 @@
 #pragma once
 
+#include <germline_utils/germline_db_cache.hpp>
+
 #include "germline_db_labeling.hpp"
 #include "cdr_config.hpp"
 
@@ -10,13 +12,26 @@ namespace cdr_labeler {
     protected:
         germline_utils::CustomGeneDatabase &gene_db_;
         const CDRLabelerConfig::CDRsParams &cdr_params_;
+        germline_utils::GermlineDbCache cache_;
 
         std::shared_ptr<BaseImmuneGeneCDRLabeler> GetImmuneGeneLabeler(germline_utils::ImmuneGeneType gene_type);
 
+        // key depends on sequences of DB, CDR search parameters and content of annotation files
+        uint64_t ComputeCacheKey() const;
+
+        std::string CacheBundleFname(uint64_t cache_key) const;
+
+        // returns false if labeling was not cached, labelings are stored in the order of ComputeLabeling
+        bool LoadLabeling(uint64_t cache_key, DbCDRLabeling &cdr_labeling);
+
+        void SaveLabeling(uint64_t cache_key, const std::vector<annotation_utils::CDRLabeling> &labelings) const;
+
     public:
+        // labelings are cached in cache_dir if it is not empty
         GermlineDbLabeler(germline_utils::CustomGeneDatabase &gene_db,
-                          const CDRLabelerConfig::CDRsParams &cdr_params) :
-                gene_db_(gene_db), cdr_params_(cdr_params) { }
+                          const CDRLabelerConfig::CDRsParams &cdr_params,
+                          std::string cache_dir = "") :
+                gene_db_(gene_db), cdr_params_(cdr_params), cache_(cache_dir) { }
 
         DbCDRLabeling ComputeLabeling();
     };
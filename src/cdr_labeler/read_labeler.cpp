@@ -35,7 +35,7 @@ namespace cdr_labeler {
     }
 
     annotation_utils::AnnotatedClone ReadCDRLabeler::CreateAnnotatedClone(const vj_finder::VJHits &vj_hits) {
-        auto v_hit = vj_hits.GetVHitByIndex(0);
+        const auto &v_hit = vj_hits.GetVHitByIndex(0);
         auto v_alignment = alignment_converter_.ConvertToAlignment(v_hit.ImmuneGene(),
                                                                    vj_hits.Read(),
                                                                    v_hit.BlockAlignment());
@@ -44,7 +44,7 @@ namespace cdr_labeler {
                                              v_alignment.QueryPositionBySubjectPosition(v_cdr_labeling.cdr1.end_pos));
         annotation_utils::CDRRange read_cdr2(v_alignment.QueryPositionBySubjectPosition(v_cdr_labeling.cdr2.start_pos),
                                              v_alignment.QueryPositionBySubjectPosition(v_cdr_labeling.cdr2.end_pos));
-        auto j_hit = vj_hits.GetJHitByIndex(0);
+        const auto &j_hit = vj_hits.GetJHitByIndex(0);
         auto j_alignment = alignment_converter_.ConvertToAlignment(j_hit.ImmuneGene(),
                                                                    vj_hits.Read(),
                                                                    j_hit.BlockAlignment());
@@ -12,6 +12,9 @@ endif()
 # Define option for turning on/off debug logging
 option(IGREC_DEBUG_LOGGING "Turn on debug / trace logging" ON)
 
+# Define option for counting of heap allocations (profiling builds)
+option(IGREC_COUNT_ALLOCATIONS "Count heap allocations made via operator new" OFF)
+
 # Define option for static / dynamic build.
 option(IGREC_STATIC_BUILD "Link IgReC statically" OFF)
 if (IGREC_STATIC_BUILD)
@@ -0,0 +1,50 @@
+#include <allocation_counter.hpp>
+
+#ifdef IGREC_COUNT_ALLOCATIONS
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+    thread_local size_t thread_allocations = 0;
+
+    void* CountedAllocation(size_t size) {
+        thread_allocations++;
+        void *ptr = std::malloc(size ? size : 1);
+        if(!ptr)
+            throw std::bad_alloc();
+        return ptr;
+    }
+}
+
+void* operator new(size_t size) {
+    return CountedAllocation(size);
+}
+
+void* operator new[](size_t size) {
+    return CountedAllocation(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    std::free(ptr);
+}
+
+namespace allocation_counter {
+    bool Enabled() { return true; }
+
+    size_t ThreadAllocations() { return thread_allocations; }
+}
+
+#else
+
+namespace allocation_counter {
+    bool Enabled() { return false; }
+
+    size_t ThreadAllocations() { return 0; }
+}
+
+#endif
@@ -35,6 +35,31 @@ namespace core {
         INFO(size() << " reads were extracted from " << fastq_file_fname);
     }
 
+    size_t ReadArchive::ExtractChunkFromFile(seqan::SeqFileIn &seq_file, size_t max_num_reads) {
+        reads_.clear();
+        name_index_map_.clear();
+        std::vector <seqan::CharString> read_headers;
+        std::vector <seqan::Dna5String> read_seqs;
+        if(!seqan::atEnd(seq_file))
+            seqan::readRecords(read_headers, read_seqs, seq_file, max_num_reads);
+        for (size_t i = 0; i < read_seqs.size(); i++) {
+            std::string header = std::string(seqan::toCString(read_headers[i]));
+            reads_.push_back(Read(header, read_seqs[i], i));
+            name_index_map_[header] = i;
+        }
+        return size();
+    }
+
+    void ReadArchive::AddRead(std::string name, seqan::Dna5String seq) {
+        name_index_map_[name] = reads_.size();
+        reads_.push_back(Read(name, seq, reads_.size()));
+    }
+
+    void ReadArchive::Clear() {
+        reads_.clear();
+        name_index_map_.clear();
+    }
+
     size_t ReadArchive::size() const {
         return reads_.size();
     }
@@ -60,7 +85,7 @@ namespace core {
             std::replace(it->name.begin(), it->name.end(), ' ', '_');
     }
 
-    void ReadArchive::UpdateReadByIndex(size_t index, seqan::Dna5String new_seq) {
+    void ReadArchive::UpdateReadByIndex(size_t index, const seqan::Dna5String &new_seq) {
         VERIFY_MSG(index < reads_.size(), "Index " << index << " exceeds archive size");
         reads_[index].seq = new_seq;
     }
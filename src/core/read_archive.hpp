@@ -3,6 +3,7 @@
 #include <unordered_map>
 #include <seqan/sequence.h>
 #include <seqan/modifier.h>
+#include <seqan/seq_io.h>
 
 namespace core {
 
@@ -52,6 +53,15 @@ namespace core {
 
         void ExtractFromFile(std::string fastq_file_fname);
 
+        // replaces content of the archive by at most max_num_reads next records of the opened file
+        // read ids are local indices in the archive; returns number of extracted reads
+        size_t ExtractChunkFromFile(seqan::SeqFileIn &seq_file, size_t max_num_reads);
+
+        // read id is index of the read in the archive
+        void AddRead(std::string name, seqan::Dna5String seq);
+
+        void Clear();
+
         size_t size() const;
 
         typedef std::vector<Read>::const_iterator read_iterator;
@@ -68,6 +78,6 @@ namespace core {
 
         void FixSpacesInHeaders();
 
-        void UpdateReadByIndex(size_t index, seqan::Dna5String new_seq);
+        void UpdateReadByIndex(size_t index, const seqan::Dna5String &new_seq);
     };
 }
\ No newline at end of file
@@ -9,6 +9,8 @@
 #include <cassert>
 #include <vector>
 #include <algorithm>
+#include <cstdint>
+#include <limits>
 
 
 template<typename Ts1, typename Ts2, typename Tf>
@@ -81,4 +83,125 @@ int half_sw_banded(const Ts1 &s1, const Ts2 &s2,
     return max(-INF, base[max_indels]); // Score is always finite due to possibility to align using mismatches
 }
 
+
+// Bit-parallel version of -half_sw_banded(s1, s2, 0, -1, -1, lizard_tail, max_indels), i.e., unit cost distance
+// between s1 and s2 where the alignment stops at the end of any of sequences and the rest of the other one
+// costs -lizard_tail(length of rest). lizard_tail should be non-positive.
+// Rows of DP matrix (prefixes of s1) are computed one by one, the band of 2 * max_indels + 1 cells of a row
+// is encoded by bit vectors of horizontal differences like in Myers/Hyyro algorithm, so a row takes O(1) word
+// operations for any length of reads. Cells on the left of the band (negative prefixes of s2) are filled by i - j,
+// that does not change the others.
+// Computation stops once the distance is known to exceed tau, and then some distance greater than tau is returned.
+// Bands wider than 64 cells are processed by half_sw_banded.
+template<typename Ts1, typename Ts2, typename Tf>
+int half_edit_distance_banded(const Ts1 &s1, const Ts2 &s2,
+                              const Tf &lizard_tail,
+                              int max_indels,
+                              int tau = std::numeric_limits<int>::max() / 4) {
+    using seqan::length;
+    using seqan::ordValue;
+
+    const int INF = std::numeric_limits<int>::max() / 4;
+    const int len1 = static_cast<int>(length(s1));
+    const int len2 = static_cast<int>(length(s2));
+    const int m = max_indels;
+    if (m < 0 || 2 * m + 1 > 64) {
+        return -half_sw_banded(s1, s2, 0, -1, -1, lizard_tail, max_indels);
+    }
+    auto tail = [&lizard_tail](int l) -> int { return -lizard_tail(l); };
+    if (len1 == 0 || len2 == 0) {
+        return tail(std::max(len1, len2));
+    }
+
+    // bit k of band of row i corresponds to cell (i, j = i + k - m)
+    const uint64_t band_mask = (uint64_t(1) << (2 * m + 1)) - 1;
+    const uint64_t top_bit = uint64_t(1) << (2 * m);
+    const uint64_t center_mask = (uint64_t(2) << m) - 1; // bits [0, m]
+
+    // bit k of window[c] is set iff s2[i - 1 + k - m] == c for the current row i, the window slides along s2
+    uint64_t window[5] = {0, 0, 0, 0, 0};
+    for (int k = m; k <= 2 * m && k - m < len2; ++k) {
+        window[ordValue(s2[k - m])] |= uint64_t(1) << k;
+    }
+
+    // horizontal differences D[i][j] - D[i][j - 1] of the current row, row 0 contains |j|
+    uint64_t ph = band_mask & ~center_mask;
+    uint64_t mh = center_mask;
+    int center = 0; // D[i][i]
+
+    auto popcount = [](uint64_t x) -> int { return __builtin_popcountll(x); };
+    auto value_at = [&](int k) -> int {
+        if (k >= m) {
+            uint64_t bits = ((uint64_t(2) << k) - 1) & ~center_mask;
+            return center + popcount(ph & bits) - popcount(mh & bits);
+        }
+        uint64_t bits = center_mask & ~((uint64_t(2) << k) - 1);
+        return center - popcount(ph & bits) + popcount(mh & bits);
+    };
+    auto mismatch = [&s1, &s2](int i1, int i2) -> int { return s1[i1] == s2[i2] ? 0 : 1; };
+
+    int best = INF;
+    int prev_last_column = INF; // D[i - 1][len2 - 1]
+    for (int i = 0; i < len1; ++i) {
+        if (i > 0) {
+            // Myers/Hyyro step with roles of rows and columns swapped: differences of the previous row are inputs,
+            // vertical differences propagate along the row, upper neighbour of the top cell is out of band
+            uint64_t eq = window[ordValue(s1[i - 1])];
+            uint64_t pv_in = (ph >> 1) | top_bit;
+            uint64_t mv_in = mh >> 1;
+            uint64_t xv = eq | mv_in;
+            uint64_t xh = (((eq & pv_in) + pv_in) ^ pv_in) | eq;
+            uint64_t p_out = mv_in | ~(xh | pv_in);
+            uint64_t m_out = pv_in & xh;
+            center += static_cast<int>((p_out >> m) & 1) - static_cast<int>((m_out >> m) & 1) +
+                      static_cast<int>((pv_in >> m) & 1) - static_cast<int>((mv_in >> m) & 1);
+            // left neighbour of the bottom cell is out of band
+            p_out = (p_out << 1) | 1;
+            m_out <<= 1;
+            ph = (m_out | ~(xv | p_out)) & band_mask;
+            mh = (p_out & xv) & band_mask;
+
+            for (auto &letter_window : window) {
+                letter_window >>= 1;
+            }
+            if (i + m < len2) {
+                window[ordValue(s2[i + m])] |= top_bit;
+            }
+        }
+
+        // the alignment reaches the end of s2 in row i
+        int last_column_k = len2 - 1 - i + m;
+        int last_column = (last_column_k >= 0 && last_column_k <= 2 * m) ? value_at(last_column_k) : INF;
+        if (std::abs(len2 - i) <= m) {
+            int cost = INF;
+            if (i > 0) {
+                cost = std::min(cost, prev_last_column + mismatch(i - 1, len2 - 1));
+            }
+            if (last_column_k >= 0) {
+                cost = std::min(cost, last_column + 1);
+            }
+            best = std::min(best, cost + tail(len1 - i));
+        }
+        prev_last_column = last_column;
+
+        // distances in the band differ by at most one between neighbours
+        if (best > tau && center - m > tau) {
+            return std::min(best, center - m);
+        }
+    }
+
+    // the alignment reaches the end of s1 after row len1 - 1
+    for (int j = std::max(0, len1 - m); j <= std::min(len2, len1 + m); ++j) {
+        int cost = INF;
+        if (j > 0) {
+            cost = std::min(cost, value_at(j - len1 + m) + mismatch(len1 - 1, j - 1));
+        }
+        if (j < len2 && j - len1 + 1 <= m) {
+            cost = std::min(cost, value_at(j - len1 + 1 + m) + 1);
+        }
+        best = std::min(best, cost + tail(len2 - j));
+    }
+    return best;
+}
+
 // vim: ts=4:sw=4
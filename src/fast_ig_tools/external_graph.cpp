@@ -0,0 +1,314 @@
+#include "external_graph.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <queue>
+
+#include <csr_graph_format.hpp>
+#include <verify.hpp>
+
+namespace {
+
+// buffered sequential reader of a sorted run
+class RunReader {
+    std::ifstream in_;
+    std::vector<ExternalEdge> buffer_;
+    size_t pos_ = 0;
+
+    void Fill() {
+        buffer_.resize(buffer_.capacity());
+        in_.read(reinterpret_cast<char*>(buffer_.data()),
+                 static_cast<std::streamsize>(buffer_.size() * sizeof(ExternalEdge)));
+        buffer_.resize(static_cast<size_t>(in_.gcount()) / sizeof(ExternalEdge));
+        pos_ = 0;
+    }
+
+public:
+    RunReader(const std::string &filename, size_t buffer_capacity) : in_(filename, std::ios::binary) {
+        VERIFY_MSG(in_.good(), "Cannot open run file " << filename);
+        buffer_.reserve(std::max<size_t>(buffer_capacity, 1));
+        Fill();
+    }
+
+    bool Empty() const { return pos_ == buffer_.size(); }
+
+    const ExternalEdge& Top() const { return buffer_[pos_]; }
+
+    void Pop() {
+        if (++pos_ == buffer_.size()) {
+            Fill();
+        }
+    }
+};
+
+template <typename T>
+void write_array(std::ostream &out, const std::vector<T> &values) {
+    out.write(reinterpret_cast<const char*>(values.data()),
+              static_cast<std::streamsize>(values.size() * sizeof(T)));
+}
+
+// copies temporary file of a section of binary CSR graph and pads it to 8 bytes
+void copy_section(std::ostream &out, const std::string &section_filename, size_t size) {
+    if (size > 0) {
+        std::ifstream section(section_filename, std::ios::binary);
+        out << section.rdbuf();
+    }
+    const char zeros[8] = {};
+    out.write(zeros, static_cast<std::streamsize>(csr_graph::PaddedSize(size) - size));
+}
+
+// passes edges of runs to handler in sorted order without duplicates
+template <typename EdgeHandler>
+void merge_runs(const std::vector<std::string> &run_files, size_t reader_capacity, EdgeHandler handle_edge) {
+    std::vector<RunReader> readers;
+    readers.reserve(run_files.size());
+    for (const auto &run_file : run_files) {
+        readers.emplace_back(run_file, reader_capacity);
+    }
+
+    auto greater = [&readers](size_t a, size_t b) { return readers[b].Top() < readers[a].Top(); };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(greater);
+    for (size_t i = 0; i < readers.size(); ++i) {
+        if (!readers[i].Empty()) {
+            heap.push(i);
+        }
+    }
+
+    bool has_last = false;
+    ExternalEdge last = {0, 0, 0};
+    while (!heap.empty()) {
+        size_t reader_index = heap.top();
+        heap.pop();
+        ExternalEdge edge = readers[reader_index].Top();
+        readers[reader_index].Pop();
+        if (!readers[reader_index].Empty()) {
+            heap.push(reader_index);
+        }
+
+        if (has_last && edge == last) {
+            continue;
+        }
+        has_last = true;
+        last = edge;
+        handle_edge(edge);
+    }
+}
+
+void write_vertex_prefix(std::ostream &out, const std::vector<size_t> &weights, size_t vertex) {
+    if (!weights.empty()) {
+        out << weights[vertex] << " ";
+    }
+}
+
+} // namespace
+
+
+const size_t ExternalEdgeRuns::max_merge_fan_in;
+const size_t ExternalEdgeRuns::min_reader_capacity;
+
+
+ExternalEdgeRuns::ExternalEdgeRuns(const std::string &tmp_prefix, size_t ram_budget, size_t num_threads)
+        : tmp_prefix_(tmp_prefix),
+          ram_budget_(ram_budget),
+          buffers_(std::max<size_t>(num_threads, 1)),
+          num_created_runs_(0),
+          num_spilled_edges_(0) {
+    buffer_capacity_ = std::max<size_t>(ram_budget_ / (buffers_.size() * sizeof(ExternalEdge)), 1);
+    for (auto &buffer : buffers_) {
+        buffer.reserve(buffer_capacity_);
+    }
+}
+
+
+ExternalEdgeRuns::~ExternalEdgeRuns() {
+    RemoveRuns();
+}
+
+
+std::string ExternalEdgeRuns::NewRunFilename() {
+    return tmp_prefix_ + ".run" + std::to_string(num_created_runs_++);
+}
+
+
+void ExternalEdgeRuns::SpillBuffer(size_t thread_id) {
+    auto &buffer = buffers_[thread_id];
+    if (buffer.empty()) {
+        return;
+    }
+    std::sort(buffer.begin(), buffer.end());
+
+    std::string filename;
+    {
+        std::lock_guard<std::mutex> lock(runs_mutex_);
+        filename = NewRunFilename();
+        run_files_.push_back(filename);
+        num_spilled_edges_ += buffer.size();
+    }
+
+    std::ofstream out(filename, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(buffer.data()),
+              static_cast<std::streamsize>(buffer.size() * sizeof(ExternalEdge)));
+    VERIFY_MSG(out.good(), "Cannot write run file " << filename);
+    buffer.clear();
+}
+
+
+void ExternalEdgeRuns::RemoveRuns() {
+    for (const auto &filename : run_files_) {
+        std::remove(filename.c_str());
+    }
+    run_files_.clear();
+}
+
+
+void ExternalEdgeRuns::MergeRunGroup(size_t begin, size_t end, size_t reader_capacity) {
+    std::vector<std::string> group(run_files_.cbegin() + begin, run_files_.cbegin() + end);
+    std::string filename = NewRunFilename();
+    {
+        std::ofstream out(filename, std::ios::binary);
+        merge_runs(group, reader_capacity, [&out](const ExternalEdge &edge) {
+            out.write(reinterpret_cast<const char*>(&edge), sizeof(edge));
+        });
+        VERIFY_MSG(out.good(), "Cannot write run file " << filename);
+    }
+    for (const auto &run_file : group) {
+        std::remove(run_file.c_str());
+    }
+    run_files_.erase(run_files_.begin() + begin + 1, run_files_.begin() + end);
+    run_files_[begin] = filename;
+}
+
+
+template <typename EdgeHandler>
+void ExternalEdgeRuns::MergeRuns(size_t num_vertices, EdgeHandler handle_edge) {
+    VERIFY_MSG(num_vertices < std::numeric_limits<uint32_t>::max(),
+               "Number of vertices " << num_vertices << " exceeds limit of 32-bit vertex ids");
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+        SpillBuffer(i);
+        std::vector<ExternalEdge>().swap(buffers_[i]);
+    }
+
+    // budget is shared by readers of runs merged at once, but every reader gets at least min_reader_capacity edges
+    size_t fan_in = ram_budget_ / (min_reader_capacity * sizeof(ExternalEdge));
+    fan_in = std::min<size_t>(std::max<size_t>(fan_in, 2), max_merge_fan_in);
+    size_t reader_capacity = std::max<size_t>(ram_budget_ / (fan_in * sizeof(ExternalEdge)), min_reader_capacity);
+
+    // every pass merges groups of fan_in consecutive runs into single runs, until all runs can be merged at once
+    while (run_files_.size() > fan_in) {
+        size_t num_groups = (run_files_.size() + fan_in - 1) / fan_in;
+        for (size_t group = 0; group < num_groups; ++group) {
+            // runs of previous groups are already replaced by single runs
+            MergeRunGroup(group, std::min(group + fan_in, run_files_.size()), reader_capacity);
+        }
+    }
+
+    merge_runs(run_files_, reader_capacity, [&](const ExternalEdge &edge) {
+        VERIFY_MSG(edge.from < num_vertices && edge.to < num_vertices,
+                   "Edge " << edge.from << " - " << edge.to << " refers to missing vertex");
+        handle_edge(edge);
+    });
+    RemoveRuns();
+}
+
+
+size_t ExternalEdgeRuns::WriteMetisGraph(size_t num_vertices,
+                                         const std::string &filename,
+                                         const std::vector<size_t> &weights,
+                                         bool undirected) {
+    VERIFY(weights.empty() || weights.size() == num_vertices);
+
+    // the number of edges is written in the header, so adjacency lists are written to the temporary body first
+    std::string body_filename = tmp_prefix_ + ".body";
+    size_t num_edges = 0;
+    {
+        std::ofstream body(body_filename);
+        size_t current_vertex = 0;
+        if (num_vertices > 0) {
+            write_vertex_prefix(body, weights, 0);
+        }
+        MergeRuns(num_vertices, [&](const ExternalEdge &edge) {
+            while (current_vertex < edge.from) {
+                body << "\n";
+                write_vertex_prefix(body, weights, ++current_vertex);
+            }
+            body << edge.to + 1 << " " << edge.weight << " ";
+            ++num_edges;
+        });
+        while (num_vertices > 0 && current_vertex + 1 < num_vertices) {
+            body << "\n";
+            write_vertex_prefix(body, weights, ++current_vertex);
+        }
+        if (num_vertices > 0) {
+            body << "\n";
+        }
+        VERIFY_MSG(body.good(), "Cannot write " << body_filename);
+    }
+
+    if (undirected) {
+        num_edges /= 2;
+    }
+
+    {
+        std::ofstream out(filename);
+        // See http://glaros.dtc.umn.edu/gkhome/fetch/sw/metis/manual.pdf
+        out << num_vertices << " " << num_edges << (weights.empty() ? " 001\n" : " 011\n");
+        std::ifstream body(body_filename);
+        if (body.peek() != std::ifstream::traits_type::eof()) {
+            out << body.rdbuf();
+        }
+        VERIFY_MSG(out.good(), "Cannot write " << filename);
+    }
+    std::remove(body_filename.c_str());
+
+    return num_edges;
+}
+
+
+size_t ExternalEdgeRuns::WriteBinaryGraph(size_t num_vertices,
+                                          const std::string &filename,
+                                          const std::vector<size_t> &weights,
+                                          bool undirected) {
+    VERIFY(weights.empty() || weights.size() == num_vertices);
+
+    // row offsets precede adjacency lists, so neighbours and edge weights are written to temporary files first
+    std::string neighbours_filename = tmp_prefix_ + ".neighbours";
+    std::string edge_weights_filename = tmp_prefix_ + ".weights";
+    std::vector<uint64_t> offsets(num_vertices + 1, 0);
+    {
+        std::ofstream neighbours(neighbours_filename, std::ios::binary);
+        std::ofstream edge_weights(edge_weights_filename, std::ios::binary);
+        MergeRuns(num_vertices, [&](const ExternalEdge &edge) {
+            neighbours.write(reinterpret_cast<const char*>(&edge.to), sizeof(edge.to));
+            edge_weights.write(reinterpret_cast<const char*>(&edge.weight), sizeof(edge.weight));
+            ++offsets[edge.from + 1];
+        });
+        VERIFY_MSG(neighbours.good() && edge_weights.good(), "Cannot write temporary files " <<
+                   neighbours_filename << " and " << edge_weights_filename);
+    }
+    for (size_t i = 0; i < num_vertices; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+    size_t num_entries = static_cast<size_t>(offsets.back());
+    size_t num_edges = undirected ? num_entries / 2 : num_entries;
+
+    {
+        std::ofstream out(filename, std::ios::binary);
+        auto header = csr_graph::MakeHeader(num_vertices, num_edges, num_entries, !weights.empty());
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        write_array(out, offsets);
+        copy_section(out, neighbours_filename, num_entries * sizeof(uint32_t));
+        copy_section(out, edge_weights_filename, num_entries * sizeof(int32_t));
+        if (!weights.empty()) {
+            write_array(out, std::vector<uint64_t>(weights.cbegin(), weights.cend()));
+        }
+        VERIFY_MSG(out.good(), "Cannot write " << filename);
+    }
+    std::remove(neighbours_filename.c_str());
+    std::remove(edge_weights_filename.c_str());
+
+    return num_edges;
+}
+
+// vim: ts=4:sw=4
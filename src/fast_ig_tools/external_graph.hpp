@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <verify.hpp>
+
+// Out-of-core construction of undirected weighted graphs.
+// Edges are collected into per-thread buffers of bounded size, each full buffer is sorted and spilled to disk
+// as a run. Runs are merged by k-way merge that writes adjacency lists of the graph in METIS or binary CSR format
+// directly to the output file, so neither the graph nor the edge list is kept in memory
+// (binary CSR writer keeps only row offsets, i.e., 8 bytes per vertex).
+// If there are too many runs to read all of them at once with reasonable buffers, groups of runs are merged
+// into longer runs first, so every merge pass reads at most max_merge_fan_in runs.
+// Vertex ids are 32-bit, so the graph can contain at most 2^32 - 1 vertices.
+
+struct ExternalEdge {
+    uint32_t from;
+    uint32_t to;
+    int32_t weight;
+
+    bool operator<(const ExternalEdge &other) const {
+        if (from != other.from) return from < other.from;
+        if (to != other.to) return to < other.to;
+        return weight < other.weight;
+    }
+
+    bool operator==(const ExternalEdge &other) const {
+        return from == other.from && to == other.to && weight == other.weight;
+    }
+};
+
+class ExternalEdgeRuns {
+public:
+    // the maximal number of runs merged at once
+    static const size_t max_merge_fan_in = 64;
+    // the minimal capacity of buffer of run reader in edges
+    static const size_t min_reader_capacity = 1 << 12;
+
+private:
+    std::string tmp_prefix_;
+    size_t ram_budget_;
+    // capacity of buffer of each thread in edges
+    size_t buffer_capacity_;
+
+    std::vector<std::vector<ExternalEdge>> buffers_;
+
+    std::mutex runs_mutex_;
+    std::vector<std::string> run_files_;
+    // the number of run files created so far, used for their names
+    size_t num_created_runs_;
+    size_t num_spilled_edges_;
+
+    std::string NewRunFilename();
+
+    void SpillBuffer(size_t thread_id);
+
+    void RemoveRuns();
+
+    // merges runs [begin, end) of run_files_ into a single run that replaces them, duplicated edges are removed
+    void MergeRunGroup(size_t begin, size_t end, size_t reader_capacity);
+
+    // spills the rest of buffers and passes merged edges to handler in sorted order without duplicates
+    template <typename EdgeHandler>
+    void MergeRuns(size_t num_vertices, EdgeHandler handle_edge);
+
+public:
+    // tmp_prefix - prefix of names of temporary files of runs
+    // ram_budget - total size of memory in bytes used for edge buffers during construction and for run readers
+    // during merging; buffers of num_threads threads split the budget equally,
+    // but a run reader never gets less than min_reader_capacity edges
+    ExternalEdgeRuns(const std::string &tmp_prefix, size_t ram_budget, size_t num_threads);
+
+    ExternalEdgeRuns(const ExternalEdgeRuns&) = delete;
+
+    ExternalEdgeRuns& operator=(const ExternalEdgeRuns&) = delete;
+
+    ~ExternalEdgeRuns();
+
+    // adds directed edge, should be called by thread thread_id only
+    void AddEdge(size_t thread_id, size_t from, size_t to, int weight) {
+        VERIFY(thread_id < buffers_.size());
+        auto &buffer = buffers_[thread_id];
+        buffer.push_back({static_cast<uint32_t>(from), static_cast<uint32_t>(to), static_cast<int32_t>(weight)});
+        if (buffer.size() == buffer_capacity_) {
+            SpillBuffer(thread_id);
+        }
+    }
+
+    // adds edge in both directions
+    void AddUndirectedEdge(size_t thread_id, size_t from, size_t to, int weight) {
+        AddEdge(thread_id, from, to, weight);
+        AddEdge(thread_id, to, from, weight);
+    }
+
+    size_t NumRuns() const { return run_files_.size(); }
+
+    size_t NumSpilledEdges() const { return num_spilled_edges_; }
+
+    // spills the rest of buffers and merges all runs into METIS graph with num_vertices vertices,
+    // duplicated edges are removed, adjacency lists are sorted by (neighbour, weight) like in tauDistGraph
+    // if weights is not empty, vertex weights are written as well
+    // returns the number of undirected (undirected = true) or directed edges
+    size_t WriteMetisGraph(size_t num_vertices,
+                           const std::string &filename,
+                           const std::vector<size_t> &weights = {},
+                           bool undirected = true);
+
+    // the same as WriteMetisGraph, but the graph is written in binary CSR format (see csr_graph_format.hpp)
+    size_t WriteBinaryGraph(size_t num_vertices,
+                            const std::string &filename,
+                            const std::vector<size_t> &weights = {},
+                            bool undirected = true);
+};
+
+// vim: ts=4:sw=4
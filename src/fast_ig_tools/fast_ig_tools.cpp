@@ -1,5 +1,13 @@
 #include "fast_ig_tools.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <limits>
+#include <sstream>
+
+#include <csr_graph_format.hpp>
+#include <io/mmapped_reader.hpp>
+#include <verify.hpp>
 
 size_t numEdges(const Graph &graph,
                 bool undirected) {
@@ -60,6 +68,171 @@ void write_metis_graph(const Graph &graph,
     }
 }
 
+namespace {
+
+template <typename T>
+void write_array(std::ostream &out, const std::vector<T> &values) {
+    out.write(reinterpret_cast<const char*>(values.data()),
+              static_cast<std::streamsize>(values.size() * sizeof(T)));
+}
+
+void write_padding(std::ostream &out, size_t size) {
+    const char zeros[8] = {};
+    out.write(zeros, static_cast<std::streamsize>(csr_graph::PaddedSize(size) - size));
+}
+
+void write_binary_graph_impl(const Graph &graph,
+                             const std::vector<size_t> &weights,
+                             const std::string &filename,
+                             bool undirected) {
+    VERIFY_MSG(graph.size() < std::numeric_limits<uint32_t>::max(),
+               "Number of vertices " << graph.size() << " exceeds limit of 32-bit vertex ids");
+    std::ofstream out(filename, std::ios::binary);
+
+    size_t num_entries = numEdges(graph, false);
+    auto header = csr_graph::MakeHeader(graph.size(), numEdges(graph, undirected), num_entries, !weights.empty());
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<uint64_t> offsets;
+    offsets.reserve(graph.size() + 1);
+    offsets.push_back(0);
+    for (const auto &edges : graph) {
+        offsets.push_back(offsets.back() + edges.size());
+    }
+    write_array(out, offsets);
+
+    // neighbours and edge weights are written by adjacency lists, so the graph is not copied
+    std::vector<uint32_t> neighbours;
+    for (const auto &edges : graph) {
+        neighbours.clear();
+        for (const auto &edge : edges) {
+            neighbours.push_back(static_cast<uint32_t>(edge.first));
+        }
+        write_array(out, neighbours);
+    }
+    write_padding(out, num_entries * sizeof(uint32_t));
+
+    std::vector<int32_t> edge_weights;
+    for (const auto &edges : graph) {
+        edge_weights.clear();
+        for (const auto &edge : edges) {
+            edge_weights.push_back(static_cast<int32_t>(edge.second));
+        }
+        write_array(out, edge_weights);
+    }
+    write_padding(out, num_entries * sizeof(int32_t));
+
+    if (!weights.empty()) {
+        write_array(out, std::vector<uint64_t>(weights.cbegin(), weights.cend()));
+    }
+    VERIFY_MSG(out.good(), "Cannot write " << filename);
+}
+
+} // namespace
+
+
+void write_binary_graph(const Graph &graph,
+                        const std::string &filename,
+                        bool undirected) {
+    write_binary_graph_impl(graph, {}, filename, undirected);
+}
+
+
+void write_binary_graph(const Graph &graph,
+                        const std::vector<size_t> &weights,
+                        const std::string &filename,
+                        bool undirected) {
+    VERIFY(graph.size() == weights.size());
+    write_binary_graph_impl(graph, weights, filename, undirected);
+}
+
+
+bool is_binary_graph(const std::string &filename) {
+    std::ifstream in(filename, std::ios::binary);
+    char data[sizeof(csr_graph::magic)];
+    in.read(data, sizeof(data));
+    return csr_graph::HasMagic(data, static_cast<size_t>(in.gcount()));
+}
+
+
+size_t read_metis_graph(const std::string &filename,
+                        Graph &graph,
+                        std::vector<size_t> &weights) {
+    std::ifstream in(filename);
+    VERIFY_MSG(in.good(), "Cannot open graph file " << filename);
+    std::string line;
+    std::getline(in, line);
+    std::istringstream header(line);
+    size_t nV = 0, nE = 0;
+    std::string format;
+    header >> nV >> nE >> format;
+    VERIFY_MSG(format == "" || format == "001" || format == "011", "Unsupported METIS format " << format);
+    bool edge_weighted = format != "";
+    bool vertex_weighted = format == "011";
+
+    graph.assign(nV, {});
+    weights.clear();
+    if (vertex_weighted) {
+        weights.assign(nV, 1);
+    }
+    std::vector<long long> tokens;
+    for (size_t i = 0; i < nV && std::getline(in, line); ++i) {
+        tokens.clear();
+        const char *pos = line.c_str();
+        char *end = nullptr;
+        for (long long token = std::strtoll(pos, &end, 10); end != pos; token = std::strtoll(pos, &end, 10)) {
+            tokens.push_back(token);
+            pos = end;
+        }
+        size_t first = 0;
+        if (vertex_weighted && !tokens.empty()) {
+            weights[i] = static_cast<size_t>(tokens[0]);
+            first = 1;
+        }
+        size_t step = edge_weighted ? 2 : 1;
+        VERIFY_MSG((tokens.size() - first) % step == 0, "Line of vertex " << i + 1 << " in " << filename <<
+                   " contains odd number of elements");
+        for (size_t j = first; j < tokens.size(); j += step) {
+            int edge_weight = edge_weighted ? static_cast<int>(tokens[j + 1]) : 1;
+            graph[i].push_back({static_cast<size_t>(tokens[j] - 1), edge_weight});
+        }
+    }
+    return nE;
+}
+
+
+size_t read_binary_graph(const std::string &filename,
+                         Graph &graph,
+                         std::vector<size_t> &weights) {
+    MMappedReader reader(filename, false, size_t(-1));
+    const char *data = static_cast<const char*>(reader.data());
+    size_t size = reader.size();
+    VERIFY_MSG(size >= sizeof(csr_graph::Header) && csr_graph::HasMagic(data, size),
+               filename << " is not a binary CSR graph");
+    csr_graph::Header header;
+    memcpy(&header, data, sizeof(header));
+    VERIFY_MSG(header.version == csr_graph::version, "Binary CSR graph " << filename << " has unsupported version");
+    csr_graph::Sections sections(header);
+    VERIFY_MSG(size >= sections.file_size, "Binary CSR graph " << filename << " is truncated");
+
+    const uint64_t *offsets = reinterpret_cast<const uint64_t*>(data + sections.offsets);
+    const uint32_t *neighbours = reinterpret_cast<const uint32_t*>(data + sections.neighbours);
+    const int32_t *edge_weights = reinterpret_cast<const int32_t*>(data + sections.edge_weights);
+    graph.assign(header.num_vertices, {});
+    for (size_t i = 0; i < graph.size(); ++i) {
+        graph[i].reserve(offsets[i + 1] - offsets[i]);
+        for (size_t j = offsets[i]; j < offsets[i + 1]; ++j) {
+            graph[i].push_back({neighbours[j], edge_weights[j]});
+        }
+    }
+    weights.clear();
+    if (header.flags & csr_graph::vertex_weights_flag) {
+        const uint64_t *vertex_weights = reinterpret_cast<const uint64_t*>(data + sections.vertex_weights);
+        weights.assign(vertex_weights, vertex_weights + header.num_vertices);
+    }
+    return header.num_edges;
+}
+
 bool check_repr_kmers_consistancy(const std::vector<size_t> &answer,
                                   const std::vector<size_t> &multiplicities,
                                   size_t K, size_t n) {
@@ -82,46 +255,50 @@ bool check_repr_kmers_consistancy(const std::vector<size_t> &answer,
 }
 
 // TODO cover by tests
-// and then, refactor it!!!!!!!!111111111111oneoneone
 // TODO Rename it to be consistent with the paper
-std::vector<size_t> optimal_coverage(const std::vector<size_t> &multiplicities,
-                                     size_t K, size_t n) {
+void optimal_coverage(const std::vector<size_t> &multiplicities,
+                      size_t K, size_t n,
+                      std::vector<size_t> &table,
+                      std::vector<size_t> &result) {
     assert(n >= 1);
     assert(multiplicities.size() + K - 1 >= n * K);
 
     const size_t INF = std::numeric_limits<size_t>::max() / 2;
 
-    std::vector<std::vector<size_t>> mults(n, std::vector<size_t>(multiplicities.size()));
+    // mults[j][i] is the minimal total multiplicity of j + 1 non-overlapping k-mers among the first i + 1 ones
+    const size_t len = multiplicities.size();
+    table.resize(n * len);
+    auto mults = [&table, len](size_t j, size_t i) -> size_t& { return table[j * len + i]; };
 
     // Fill by cummin
-    mults[0][0] = multiplicities[0];
-    for (size_t i = 1; i < mults[0].size(); ++i) {
-        mults[0][i] = std::min(multiplicities[i], mults[0][i - 1]);
+    mults(0, 0) = multiplicities[0];
+    for (size_t i = 1; i < len; ++i) {
+        mults(0, i) = std::min(multiplicities[i], mults(0, i - 1));
     }
 
     for (size_t j = 1; j < n; ++j) { // n == 1 is useless
         // Kill first K*j elements
         for (size_t i = 0; i < K*j; ++i) {
-            mults[j][i] = INF;
+            mults(j, i) = INF;
         }
 
-        for (size_t i = K*j; i < mults[j].size(); ++i) {
-            mults[j][i] = std::min(mults[j][i - 1],
-                                   multiplicities[i] + mults[j - 1][i - K]);
+        for (size_t i = K*j; i < len; ++i) {
+            mults(j, i) = std::min(mults(j, i - 1),
+                                   multiplicities[i] + mults(j - 1, i - K));
         }
     }
 
-    auto ans = mults[n - 1][mults[n - 1].size() - 1];
+    auto ans = mults(n - 1, len - 1);
 
     VERIFY(ans < INF);
 
-    std::vector<size_t> result(n);
+    result.resize(n);
     // Backward reconstruction
-    size_t i = mults[n - 1].size() - 1;
+    size_t i = len - 1;
     size_t j = n - 1;
 
     while (j > 0) {
-        if (mults[j][i] == multiplicities[i] + mults[j - 1][i - K]) { // Take i-th element
+        if (mults(j, i) == multiplicities[i] + mults(j - 1, i - K)) { // Take i-th element
             result[j] = i;
             i -= K;
             j -= 1;
@@ -132,7 +309,7 @@ std::vector<size_t> optimal_coverage(const std::vector<size_t> &multiplicities,
     assert(j == 0);
     // Find first element
     size_t ii = i;
-    while (mults[0][i] != multiplicities[ii]) {
+    while (mults(0, i) != multiplicities[ii]) {
         --ii;
     }
     result[0] = ii;
@@ -146,6 +323,13 @@ std::vector<size_t> optimal_coverage(const std::vector<size_t> &multiplicities,
     assert(ans == sum);
 
     assert(check_repr_kmers_consistancy(result, multiplicities, K, n));
+}
+
+std::vector<size_t> optimal_coverage(const std::vector<size_t> &multiplicities,
+                                     size_t K, size_t n) {
+    std::vector<size_t> table;
+    std::vector<size_t> result;
+    optimal_coverage(multiplicities, K, n, table, result);
 
     return result;
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <limits>
 #include <string>
 #include <path_helper.hpp>
 #include <perfcounter.hpp>
@@ -25,7 +26,43 @@ void write_metis_graph(const Graph &graph,
                        const std::string &filename,
                        bool undirected = true);
 
+// writes graph in binary CSR format described in csr_graph_format.hpp
+void write_binary_graph(const Graph &graph,
+                        const std::string &filename,
+                        bool undirected = true);
+
+void write_binary_graph(const Graph &graph,
+                        const std::vector<size_t> &weights,
+                        const std::string &filename,
+                        bool undirected = true);
+
+// checks magic of binary CSR format
+bool is_binary_graph(const std::string &filename);
+
+// read graphs written by write_metis_graph and write_binary_graph,
+// weights are empty if the graph has no vertex weights, the number of edges from the header is returned
+size_t read_metis_graph(const std::string &filename,
+                        Graph &graph,
+                        std::vector<size_t> &weights);
+
+size_t read_binary_graph(const std::string &filename,
+                         Graph &graph,
+                         std::vector<size_t> &weights);
+
 std::vector<size_t> optimal_coverage(const std::vector<size_t> &multiplicities,
                                      size_t K, size_t n = 3);
 
+// multiplicity of k-mers containing N for optimal_coverage of n k-mers: such k-mers are not indexed, but reads with
+// Ns at the same positions still match, so they are chosen only if there is no coverage without them
+inline size_t n_kmer_multiplicity(size_t n) {
+    return std::numeric_limits<size_t>::max() / 2 / (n + 1);
+}
+
+// the same, but the DP table and the result are kept in the given vectors,
+// so repeated calls do not allocate memory once the vectors are large enough
+void optimal_coverage(const std::vector<size_t> &multiplicities,
+                      size_t K, size_t n,
+                      std::vector<size_t> &table,
+                      std::vector<size_t> &result);
+
 // vim: ts=4:sw=4
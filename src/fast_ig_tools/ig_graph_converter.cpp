@@ -0,0 +1,104 @@
+#include <iostream>
+using std::cout;
+
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+#include "fast_ig_tools.hpp"
+#include "utils.hpp"
+#include <build_info.hpp>
+
+// Converts graphs between METIS text format and binary CSR format (see csr_graph_format.hpp).
+// Format of the input graph is detected by its content, the output graph is written in the other format,
+// so conversion to binary format and back reproduces METIS file written by ig_swgraph_construct.
+
+struct GraphConverterParam {
+    std::string input_file = "";
+    std::string output_file = "";
+};
+
+
+bool parse_cmd_line_arguments(int argc, char **argv, GraphConverterParam &args) {
+    po::options_description generic("Allowed options");
+    generic.add_options()
+            ("version,v", "print version string")
+            ("help,h", "produce help message")
+            ("input-file,i", po::value<std::string>(&args.input_file),
+             "input graph file in METIS or binary CSR format")
+            ("output-file,o", po::value<std::string>(&args.output_file),
+             "output graph file in the other format")
+            ;
+
+    po::positional_options_description p;
+    p.add("input-file", 1);
+    p.add("output-file", 1);
+
+    po::variables_map vm;
+    store(po::command_line_parser(argc, argv).options(generic).positional(p).run(), vm);
+    notify(vm);
+
+    if (vm.count("version")) {
+        cout << bformat("Graph Converter, part of IgReC version %s; git version: %s") % build_info::version % build_info::git_hash7 << std::endl;
+        return false;
+    }
+
+    if (vm.count("help") || args.input_file == "" || args.output_file == "") {
+        cout << generic << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+int main(int argc, char **argv) {
+    perf_counter pc;
+    create_console_logger("");
+
+    GraphConverterParam args;
+    try {
+        if (!parse_cmd_line_arguments(argc, argv, args)) {
+            return 0;
+        }
+    } catch(std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    INFO("Command line: " << join_cmd_line(argc, argv));
+    Graph graph;
+    std::vector<size_t> weights;
+    size_t num_edges;
+    bool to_binary = !is_binary_graph(args.input_file);
+    if (to_binary) {
+        INFO("Reading METIS graph from " << args.input_file);
+        num_edges = read_metis_graph(args.input_file, graph, weights);
+    } else {
+        INFO("Reading binary CSR graph from " << args.input_file);
+        num_edges = read_binary_graph(args.input_file, graph, weights);
+    }
+    INFO("Graph contains " << graph.size() << " vertices and " << num_edges << " edges");
+
+    // the number of edges in the header is the number of adjacency entries for directed graphs
+    bool undirected = numEdges(graph, false) != num_edges || num_edges == 0;
+    if (to_binary) {
+        INFO("Writing binary CSR graph to " << args.output_file);
+        if (weights.empty()) {
+            write_binary_graph(graph, args.output_file, undirected);
+        } else {
+            write_binary_graph(graph, weights, args.output_file, undirected);
+        }
+    } else {
+        INFO("Writing METIS graph to " << args.output_file);
+        if (weights.empty()) {
+            write_metis_graph(graph, args.output_file, undirected);
+        } else {
+            write_metis_graph(graph, weights, args.output_file, undirected);
+        }
+    }
+
+    INFO("Running time: " << running_time_format(pc));
+    return 0;
+}
+
+// vim: ts=4:sw=4
@@ -31,17 +31,18 @@ std::pair<size_t, std::vector<size_t>> find_candidates_num(const T &read,
         return { 0, {} };
     }
 
-    std::vector<size_t> costs;
-
-    auto hashes = polyhashes(read, K);
-
-    costs.reserve(hashes.size());
-    for (size_t hash : hashes) {
-        auto it = kmer2reads.find(hash);
-        if (it != kmer2reads.cend()) // TODO check it
-            costs.push_back(it->second.size());
-        else
-            costs.push_back(0);
+    // k-mers absent in the index have zero cost, k-mers containing N are not indexed and keep the cost
+    // that makes optimal_coverage avoid them; lists of both are null
+    std::vector<size_t> costs(length(read) - K + 1, n_kmer_multiplicity(static_cast<size_t>(tau) + 1));
+    std::vector<const std::vector<size_t>*> lists(costs.size(), nullptr);
+
+    for (const auto &kmer : algorithms::Kmers(read, K)) {
+        costs[kmer.pos] = 0;
+        auto it = kmer2reads.find(kmer.code);
+        if (it != kmer2reads.cend()) { // TODO check it
+            costs[kmer.pos] = it->second.size();
+            lists[kmer.pos] = &it->second;
+        }
     }
 
     std::vector<size_t> ind = optimal_coverage(costs, K, tau + 1);
@@ -49,10 +50,8 @@ std::pair<size_t, std::vector<size_t>> find_candidates_num(const T &read,
     size_t result = 0;
 
     for (size_t i : ind) {
-        size_t hash = hashes[i];
-        auto it = kmer2reads.find(hash);
-        if (it != kmer2reads.cend()) {
-            result += it->second.size();
+        if (lists[i]) {
+            result += lists[i]->size();
         }
     }
 
@@ -2,46 +2,26 @@
 
 #include <cassert>
 #include <algorithm>
+#include <atomic>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <utility>
 #include <vector>
 #include <unordered_map>
 #include <fstream>
 #include <exception>
 #include <verify.hpp>
+#include <omp.h>
 
 #include <seqan/seq_io.h>
 #include "fast_ig_tools.hpp"
+#include "external_graph.hpp"
+#include "persistent_kmer_index.hpp"
+#include "../algorithms/hashes/kmer_generator.hpp"
 using seqan::length;
 
 
-// TODO Reimplement it as "generator" with O(1) memory consumption
-template<typename T>
-std::vector<size_t> polyhashes(const T &s, size_t K) {
-    if (length(s) < K) {
-        return {  };
-    }
-
-    const size_t p = 7;
-    std::vector<size_t> result(length(s) - K + 1);
-
-    size_t first = 0;
-    size_t p_pow_K = 1;
-    for (size_t i = 0; i < K; ++i) {
-        first *= p;
-        first += unsigned(s[i]);
-        p_pow_K *= p;
-    }
-
-    result[0] = first;
-    for (size_t i = 1; i < result.size(); ++i) {
-        first *= p;
-        first += unsigned(s[K + i - 1]); //size_t(s[K + i - 1]);
-        first -= unsigned(s[i - 1]) * p_pow_K; //size_t(s[i - 1]) * p_pow_K;
-        result[i] = first;
-    }
-
-    return result;
-}
-
 template<typename T1, typename T2 = T1>
 int hamming_rtrim(const T1& s1, const T2 &s2) {
     size_t len = std::min<size_t>(length(s1), length(s2));
@@ -66,17 +46,20 @@ void remove_duplicates(std::vector<T> &v, bool sorted = false) {
 }
 
 
-using KmerIndex = std::unordered_map<size_t, std::vector<size_t>>;
+// k-mers are encoded by algorithms::KmerIterator (2 bits per nucleotide), k-mers containing N are not indexed
+using KmerIndex = std::unordered_map<uint64_t, std::vector<size_t>>;
 
 
+// reads get ids starting from first_read_id
 template<typename T>
-KmerIndex kmerIndexConstruction(const std::vector<T> &input_reads, size_t K) {
+KmerIndex kmerIndexConstruction(const std::vector<T> &input_reads, size_t K, size_t first_read_id = 0) {
     size_t initial_hashtable_size = (K <= 13) ? (1 << (2*K)) : (input_reads.size() * 200);
+    VERIFY_MSG(K > 0 && K <= algorithms::max_encoded_kmer_size, "K = " << K << " is not in range [1, 32]");
     KmerIndex kmer2reads(initial_hashtable_size);
 
     for (size_t j = 0; j < input_reads.size(); ++j) {
-        for (size_t hash : polyhashes(input_reads[j], K)) {
-            kmer2reads[hash].push_back(j); // Already sorted. Nice!
+        for (const auto &kmer : algorithms::Kmers(input_reads[j], K)) {
+            kmer2reads[kmer.code].push_back(first_read_id + j); // Already sorted. Nice!
         }
     }
 
@@ -88,6 +71,22 @@ KmerIndex kmerIndexConstruction(const std::vector<T> &input_reads, size_t K) {
 }
 
 
+// checksum of sequences of reads in their order (FNV-1a of nucleotides with end-of-read marks),
+// checksum of reads followed by other reads is reads_checksum(other, reads_checksum(reads))
+template<typename T>
+uint64_t reads_checksum(const std::vector<T> &reads, uint64_t checksum = 14695981039346656037ULL) {
+    const uint64_t prime = 1099511628211ULL;
+    const uint64_t end_of_read = 0xff;
+    for (const auto &read : reads) {
+        for (size_t i = 0; i < length(read); ++i) {
+            checksum = (checksum ^ ordValue(read[i])) * prime;
+        }
+        checksum = (checksum ^ end_of_read) * prime;
+    }
+    return checksum;
+}
+
+
 template<typename T>
 size_t count_unique(std::vector<T> v) {
    remove_duplicates(v);
@@ -96,61 +95,318 @@ size_t count_unique(std::vector<T> v) {
 }
 
 
+// buffers of candidate search reused between reads, so that the search does not allocate memory
+// once they are large enough; every thread should use its own buffers
+struct CandidateBuffers {
+    std::vector<size_t> multiplicities;
+    std::vector<uint64_t> kmer_codes;
+    std::vector<const std::vector<size_t>*> kmer_postings;
+    std::vector<size_t> coverage_table;
+    std::vector<size_t> coverage;
+    std::vector<std::pair<const size_t*, const size_t*>> cursors;
+};
+
+
+// chooses k-mers of the read by optimal_coverage and stores pointers to their posting lists to postings
+// (tau + strategy slots, nullptr for unused ones), returns the cost of the read, i.e., the total size of
+// the posting lists, or target_size for the simple strategy; reads that are too short have zero cost
+// code of the k-mer of slot k is buffers.kmer_codes[buffers.coverage[k]]
+template<typename T>
+size_t select_candidate_kmers(const T &read,
+                              const KmerIndex &kmer2reads,
+                              size_t target_size,
+                              unsigned tau, size_t K,
+                              unsigned strategy,
+                              const std::vector<size_t> **postings,
+                              CandidateBuffers &buffers) {
+    if (strategy == 0) { // Simple O(N*M) strategy
+        return target_size;
+    }
+
+    size_t required_read_length = K * (tau + strategy);
+    if (length(read) < required_read_length) {
+        return 0;
+    }
+
+    // k-mers absent in the index have zero multiplicity, k-mers containing N are not indexed and keep
+    // the multiplicity that makes optimal_coverage avoid them; postings of both are null
+    auto &multiplicities = buffers.multiplicities;
+    auto &kmer_postings = buffers.kmer_postings;
+    multiplicities.assign(length(read) - K + 1, n_kmer_multiplicity(tau + strategy));
+    buffers.kmer_codes.resize(multiplicities.size());
+    kmer_postings.assign(multiplicities.size(), nullptr);
+
+    for (const auto &kmer : algorithms::Kmers(read, K)) {
+        multiplicities[kmer.pos] = 0;
+        auto it = kmer2reads.find(kmer.code);
+        if (it != kmer2reads.cend()) {
+            multiplicities[kmer.pos] = it->second.size();
+            buffers.kmer_codes[kmer.pos] = kmer.code;
+            kmer_postings[kmer.pos] = &it->second;
+        }
+    }
+
+    optimal_coverage(multiplicities, K, tau + strategy, buffers.coverage_table, buffers.coverage);
+
+    size_t cost = 0;
+    for (size_t k = 0; k < buffers.coverage.size(); ++k) {
+        postings[k] = kmer_postings[buffers.coverage[k]];
+        cost += postings[k] ? postings[k]->size() : 0;
+    }
+
+    return cost;
+}
+
+
+// sorted candidates of the read with k-mers chosen by select_candidate_kmers:
+// posting lists are sorted, so they are merged and targets occurring in at least strategy lists are taken
+inline void collect_candidates(const std::vector<size_t> * const *postings,
+                               size_t target_size,
+                               unsigned tau,
+                               unsigned strategy,
+                               CandidateBuffers &buffers,
+                               std::vector<size_t> &cand) {
+    cand.clear();
+
+    if (strategy == 0) {
+        cand.resize(target_size);
+        std::iota(cand.begin(), cand.end(), 0);
+        return;
+    }
+
+    auto &cursors = buffers.cursors;
+    cursors.clear();
+    for (size_t k = 0; k < tau + strategy; ++k) {
+        if (postings[k] && !postings[k]->empty()) {
+            cursors.push_back({ postings[k]->data(), postings[k]->data() + postings[k]->size() });
+        }
+    }
+
+    // a target cannot occur in more lists than there are unfinished ones
+    while (cursors.size() >= strategy) {
+        size_t next = *cursors.front().first;
+        for (const auto &cursor : cursors) {
+            next = std::min(next, *cursor.first);
+        }
+
+        size_t hits = 0;
+        for (size_t c = 0; c < cursors.size(); ) {
+            if (*cursors[c].first == next) {
+                ++hits;
+                if (++cursors[c].first == cursors[c].second) {
+                    cursors[c] = cursors.back();
+                    cursors.pop_back();
+                    continue;
+                }
+            }
+            ++c;
+        }
+
+        if (hits >= strategy) {
+            cand.push_back(next);
+        }
+    }
+}
+
+
 template<typename T>
 std::vector<size_t> find_candidates(const T &read,
                                     const KmerIndex &kmer2reads,
                                     size_t target_size,
                                     unsigned tau, size_t K,
                                     unsigned strategy) {
-    size_t required_read_length = (strategy != 0) ? (K * (tau + strategy)) : 0;
-    if (length(read) < required_read_length) {
-        return {  };
-    }
+    CandidateBuffers buffers;
+    std::vector<const std::vector<size_t>*> postings(tau + strategy, nullptr);
+    select_candidate_kmers(read, kmer2reads, target_size, tau, K, strategy, postings.data(), buffers);
 
     std::vector<size_t> cand;
+    collect_candidates(postings.data(), target_size, tau, strategy, buffers, cand);
 
-    if (strategy == 0) { // Simple O(N*M) strategy
-        cand.resize(target_size);
-        std::iota(cand.begin(), cand.end(), 0);
-    } else { // Minimizers strategy
-        std::vector<size_t> multiplicities;
+    return cand;
+}
 
-        auto hashes = polyhashes(read, K);
 
-        multiplicities.reserve(hashes.size());
-        for (size_t hash : hashes) {
-            auto it = kmer2reads.find(hash);
-            if (it != kmer2reads.cend()) {
-                multiplicities.push_back(it->second.size());
-            } else {
-                multiplicities.push_back(0);
+// k-mers chosen for reads by for_each_candidate (see selections of PersistentKmerIndex),
+// reads get ids starting from first_read_id
+struct KmerSelections {
+    size_t first_read_id;
+    KmerIndex index;
+
+    explicit KmerSelections(size_t first_read_id = 0) : first_read_id(first_read_id) { }
+};
+
+
+// Calls fun(j, i, thread_id) for every candidate i of every read j.
+// Reads are processed by chunks of chunk_size reads, so that k-mers chosen for reads are kept for one chunk only.
+// The cost of every read of the chunk is computed first (see select_candidate_kmers), then reads are dispatched
+// to threads in decreasing order of cost. Heavy reads, e.g., reads of public clonotypes with long posting lists,
+// are split into ranges of candidates processed by different threads, so fun should not assume that all candidates
+// of a read are processed by the same thread. Busy and idle time of every thread is reported.
+// If selections is not null, the chosen k-mers of reads are added to it, so they are not chosen once again
+// for the persistent index. Tasks are not made cheaper than min_task_cost.
+template<typename T, typename Tf>
+void for_each_candidate(const std::vector<T> &input_reads,
+                        const KmerIndex &kmer2reads,
+                        size_t target_size,
+                        unsigned tau, unsigned K,
+                        unsigned strategy,
+                        const Tf &fun,
+                        KmerSelections *selections = nullptr,
+                        size_t min_task_cost = 1024,
+                        size_t chunk_size = 1 << 16) {
+    VERIFY(chunk_size > 0);
+    const size_t num_reads = input_reads.size();
+    const size_t num_slots = tau + strategy;
+    const size_t num_threads = static_cast<size_t>(omp_get_max_threads());
+
+    // candidates [begin, end) of the heavy read
+    struct CandidateRange {
+        size_t heavy_index;
+        size_t begin;
+        size_t end;
+    };
+
+    std::vector<const std::vector<size_t>*> postings;
+    std::vector<uint64_t> codes;
+    std::vector<size_t> costs;
+    std::vector<size_t> order;
+    std::vector<std::vector<size_t>> heavy_candidates;
+    std::vector<CandidateRange> ranges;
+    size_t total_heavy_reads = 0;
+    size_t total_heavy_tasks = 0;
+
+    // idle time of a thread is the wall time of dispatching minus its busy time,
+    // so waiting at barriers, including the one at the end of every chunk, is counted
+    std::vector<double> busy_time(num_threads, 0.);
+    double wall_time = 0.;
+
+    for (size_t chunk_begin = 0; chunk_begin < num_reads; chunk_begin += chunk_size) {
+        const size_t chunk_reads = std::min(chunk_size, num_reads - chunk_begin);
+        postings.assign(chunk_reads * num_slots, nullptr);
+        codes.resize(selections ? chunk_reads * num_slots : 0);
+        costs.assign(chunk_reads, 0);
+
+        SEQAN_OMP_PRAGMA(parallel)
+        {
+            CandidateBuffers buffers;
+            SEQAN_OMP_PRAGMA(for schedule(dynamic, 8))
+            for (size_t j = 0; j < chunk_reads; ++j) {
+                const std::vector<size_t> **read_postings = postings.data() + j * num_slots;
+                costs[j] = select_candidate_kmers(input_reads[chunk_begin + j], kmer2reads, target_size, tau, K,
+                                                  strategy, read_postings, buffers);
+                for (size_t k = 0; selections && k < num_slots; ++k) {
+                    if (read_postings[k]) {
+                        codes[j * num_slots + k] = buffers.kmer_codes[buffers.coverage[k]];
+                    }
+                }
             }
         }
 
-        std::vector<size_t> ind = optimal_coverage(multiplicities, K, tau + strategy);
-
-        std::unordered_map<size_t, size_t> hits;
-        for (size_t i : ind) {
-            size_t hash = hashes[i];
-            auto it = kmer2reads.find(hash);
-            if (it != kmer2reads.cend()) {
-                for (size_t candidate_index : it->second) {
-                    ++hits[candidate_index];
+        if (selections) {
+            for (size_t j = 0; j < chunk_reads; ++j) {
+                for (size_t k = j * num_slots; k < (j + 1) * num_slots; ++k) {
+                    if (postings[k]) {
+                        selections->index[codes[k]].push_back(selections->first_read_id + chunk_begin + j);
+                    }
                 }
             }
         }
 
-        for (const auto &kv : hits) {
-            if (kv.second >= strategy) {
-                cand.push_back(kv.first);
+        order.resize(chunk_reads);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+                         [&costs](size_t j1, size_t j2) { return costs[j1] > costs[j2]; });
+
+        // every thread should get many tasks, heavy reads are split into tasks of about task_cost
+        const size_t total_cost = std::accumulate(costs.cbegin(), costs.cend(), size_t(0));
+        const size_t task_cost = std::max<size_t>(total_cost / (num_threads * 128), min_task_cost);
+        size_t num_heavy_reads = 0;
+        while (num_heavy_reads < chunk_reads && costs[order[num_heavy_reads]] > 4 * task_cost) {
+            ++num_heavy_reads;
+        }
+        heavy_candidates.resize(num_heavy_reads);
+        ranges.clear();
+
+        double start_time = omp_get_wtime();
+
+        SEQAN_OMP_PRAGMA(parallel)
+        {
+            size_t thread_id = static_cast<size_t>(omp_get_thread_num());
+            double &busy = busy_time[thread_id];
+            CandidateBuffers buffers;
+
+            SEQAN_OMP_PRAGMA(for schedule(dynamic, 1))
+            for (size_t h = 0; h < num_heavy_reads; ++h) {
+                double task_start_time = omp_get_wtime();
+                size_t j = order[h];
+                collect_candidates(postings.data() + j * num_slots, target_size, tau, strategy, buffers,
+                                   heavy_candidates[h]);
+                busy += omp_get_wtime() - task_start_time;
+            }
+
+            SEQAN_OMP_PRAGMA(single)
+            {
+                for (size_t h = 0; h < num_heavy_reads; ++h) {
+                    size_t num_cand = heavy_candidates[h].size();
+                    size_t num_parts = (costs[order[h]] + task_cost - 1) / task_cost;
+                    size_t part_size = std::max<size_t>((num_cand + num_parts - 1) / num_parts, 1);
+                    for (size_t begin = 0; begin < num_cand; begin += part_size) {
+                        ranges.push_back({ h, begin, std::min(begin + part_size, num_cand) });
+                    }
+                }
+            }
+
+            // ranges of heavy reads go first, then light reads in decreasing order of cost
+            const size_t num_tasks = ranges.size() + chunk_reads - num_heavy_reads;
+            std::vector<size_t> cand;
+            SEQAN_OMP_PRAGMA(for schedule(dynamic, 1) nowait)
+            for (size_t t = 0; t < num_tasks; ++t) {
+                double task_start_time = omp_get_wtime();
+                if (t < ranges.size()) {
+                    const CandidateRange &range = ranges[t];
+                    size_t j = order[range.heavy_index];
+                    const auto &heavy_cand = heavy_candidates[range.heavy_index];
+                    for (size_t k = range.begin; k < range.end; ++k) {
+                        fun(chunk_begin + j, heavy_cand[k], thread_id);
+                    }
+                } else {
+                    size_t j = order[num_heavy_reads + t - ranges.size()];
+                    collect_candidates(postings.data() + j * num_slots, target_size, tau, strategy, buffers, cand);
+                    for (size_t i : cand) {
+                        fun(chunk_begin + j, i, thread_id);
+                    }
+                }
+                busy += omp_get_wtime() - task_start_time;
             }
         }
+
+        wall_time += omp_get_wtime() - start_time;
+        total_heavy_reads += num_heavy_reads;
+        total_heavy_tasks += ranges.size();
     }
 
-    return cand;
+    INFO(total_heavy_reads << " heavy reads were split into " << total_heavy_tasks << " tasks");
+    std::stringstream ss;
+    for (size_t thread_id = 0; thread_id < num_threads; ++thread_id) {
+        ss << (thread_id ? ", " : "") <<
+                bformat("%d: %.2f/%.2f") % thread_id % busy_time[thread_id] %
+                std::max(wall_time - busy_time[thread_id], 0.);
+    }
+    INFO("Busy/idle time of threads (s): " << ss.str());
 }
 
 
+// edges found by threads in for_each_candidate
+struct CandidateEdge {
+    size_t from;
+    size_t to;
+    int dist;
+};
+
+
+// dist_fun(j, i) returns the distance between reads with indices j and i, so distance functions may use
+// preprocessed reads (e.g., PackedReads) without looking them up
+// if selections is not null, k-mers chosen for reads are stored to it (see for_each_candidate)
 template<typename T, typename Tf>
 Graph tauDistGraph(const std::vector<T> &input_reads,
                    const KmerIndex &kmer2reads,
@@ -158,40 +414,37 @@ Graph tauDistGraph(const std::vector<T> &input_reads,
                    unsigned tau,
                    unsigned K,
                    unsigned strategy,
-                   size_t &num_of_dist_computations) {
-    Graph g(input_reads.size());
-
+                   size_t &num_of_dist_computations,
+                   KmerSelections *selections = nullptr) {
     std::atomic<size_t> atomic_num_of_dist_computations;
     atomic_num_of_dist_computations = 0;
 
-    SEQAN_OMP_PRAGMA(parallel for schedule(dynamic, 8))
-    for (size_t j = 0; j < input_reads.size(); ++j) {
-        auto cand = find_candidates(input_reads[j], kmer2reads, input_reads.size(), tau, K, strategy);
+    std::vector<std::vector<CandidateEdge>> thread_edges(omp_get_max_threads());
 
+    for_each_candidate(input_reads, kmer2reads, input_reads.size(), tau, K, strategy,
+                       [&](size_t j, size_t i, size_t thread_id) {
         size_t len_j = length(input_reads[j]);
+        size_t len_i = length(input_reads[i]);
+        if (len_j < len_i || (len_i == len_j && j < i)) {
+            size_t dist = dist_fun(j, i);
 
-        for (size_t i : cand) {
-            size_t len_i = length(input_reads[i]);
-            if (len_j < len_i || (len_i == len_j && j < i)) {
-                size_t dist = dist_fun(input_reads[j], input_reads[i]);
-
-                atomic_num_of_dist_computations += 1;
+            atomic_num_of_dist_computations += 1;
 
-                if (dist <= tau) {
-                    g[j].push_back( { i, dist } );
-                }
+            if (dist <= tau) {
+                thread_edges[thread_id].push_back( { j, i, static_cast<int>(dist) } );
             }
         }
-    }
+    }, selections);
 
     // Undirecting
-    auto gg = g;
-    for (size_t i = 0; i < gg.size(); ++i) {
-        for (const auto &_ : gg[i]) {
-            g[_.first].push_back( { i, _.second } );
+    Graph g(input_reads.size());
+    for (auto &edges : thread_edges) {
+        for (const auto &edge : edges) {
+            g[edge.from].push_back( { edge.to, edge.dist } );
+            g[edge.to].push_back( { edge.from, edge.dist } );
         }
+        std::vector<CandidateEdge>().swap(edges); // Free memory
     }
-    gg.clear(); // Free memory
 
     SEQAN_OMP_PRAGMA(parallel for schedule(guided, 8))
     for (size_t j = 0; j < g.size(); ++j) {
@@ -204,6 +457,45 @@ Graph tauDistGraph(const std::vector<T> &input_reads,
 }
 
 
+// out-of-core version of tauDistGraph: edges are added in both directions to runs that are spilled to disk,
+// the graph is produced by the merge of runs (see ExternalEdgeRuns::WriteMetisGraph)
+template<typename T, typename Tf>
+void tauDistGraphExternal(const std::vector<T> &input_reads,
+                          const KmerIndex &kmer2reads,
+                          const Tf &dist_fun,
+                          unsigned tau,
+                          unsigned K,
+                          unsigned strategy,
+                          ExternalEdgeRuns &edge_runs,
+                          size_t &num_of_dist_computations,
+                          KmerSelections *selections = nullptr) {
+    VERIFY_MSG(input_reads.size() < std::numeric_limits<uint32_t>::max(),
+               "Number of reads " << input_reads.size() << " exceeds limit of 32-bit vertex ids");
+
+    std::atomic<size_t> atomic_num_of_dist_computations;
+    atomic_num_of_dist_computations = 0;
+
+    for_each_candidate(input_reads, kmer2reads, input_reads.size(), tau, K, strategy,
+                       [&](size_t j, size_t i, size_t thread_id) {
+        size_t len_j = length(input_reads[j]);
+        size_t len_i = length(input_reads[i]);
+        if (len_j < len_i || (len_i == len_j && j < i)) {
+            size_t dist = dist_fun(j, i);
+
+            atomic_num_of_dist_computations += 1;
+
+            if (dist <= tau) {
+                edge_runs.AddUndirectedEdge(thread_id, j, i, static_cast<int>(dist));
+            }
+        }
+    }, selections);
+
+    num_of_dist_computations = atomic_num_of_dist_computations;
+}
+
+
+// adjacency lists are sorted by neighbour, since candidates of a read may be processed by several threads;
+// dist_fun(j, i) is called with index j of input read and index i of reference read
 template<typename T, typename Tf>
 Graph tauMatchGraph(const std::vector<T> &input_reads,
                     const std::vector<T> &reference_reads,
@@ -213,26 +505,160 @@ Graph tauMatchGraph(const std::vector<T> &input_reads,
                     unsigned K,
                     unsigned strategy,
                     size_t &num_of_dist_computations) {
+    std::atomic<size_t> atomic_num_of_dist_computations;
+    atomic_num_of_dist_computations = 0;
+
+    std::vector<std::vector<CandidateEdge>> thread_edges(omp_get_max_threads());
+
+    for_each_candidate(input_reads, kmer2reads, reference_reads.size(), tau, K, strategy,
+                       [&](size_t j, size_t i, size_t thread_id) {
+        unsigned dist = dist_fun(j, i);
+
+        atomic_num_of_dist_computations += 1;
+
+        if (dist <= tau) {
+            thread_edges[thread_id].push_back( { j, i, static_cast<int>(dist) } );
+        }
+    });
+
     Graph g(input_reads.size());
+    for (auto &edges : thread_edges) {
+        for (const auto &edge : edges) {
+            g[edge.from].push_back( { edge.to, edge.dist } );
+        }
+        std::vector<CandidateEdge>().swap(edges); // Free memory
+    }
+
+    SEQAN_OMP_PRAGMA(parallel for schedule(guided, 8))
+    for (size_t j = 0; j < g.size(); ++j) {
+        std::sort(g[j].begin(), g[j].end());
+    }
+
+    num_of_dist_computations = atomic_num_of_dist_computations;
+
+    return g;
+}
+
+// Edges incident to new reads in the graph of base_reads followed by new_reads, i.e., the edges of tauDistGraph
+// of concatenated reads that are absent in the graph of base reads; adjacency lists are sorted.
+// Pairs where a new read is the query (the shorter read, see tauDistGraph) are checked using postings of k-mers
+// of new reads among all reads. Pairs where a base read is the query are checked using k-mers chosen for base reads
+// (selections of base_index), so base reads are not queried again. K, tau and strategy should be the ones of
+// base_index. new_postings and new_selections are tables of new reads for the update of base_index.
+// dist_fun is called with indices of reads in the concatenation of base_reads and new_reads.
+template<typename T, typename Tf>
+Graph tauDistGraphAppend(const std::vector<T> &base_reads,
+                         const std::vector<T> &new_reads,
+                         const PersistentKmerIndex &base_index,
+                         const Tf &dist_fun,
+                         unsigned tau,
+                         unsigned K,
+                         unsigned strategy,
+                         KmerIndex &new_postings,
+                         KmerIndex &new_selections,
+                         size_t &num_of_dist_computations) {
+    const size_t num_base_reads = base_reads.size();
+    VERIFY_MSG(base_index.NumReads() == num_base_reads,
+               "K-mer index contains " << base_index.NumReads() << " reads, but there are " << num_base_reads <<
+               " base reads");
+    VERIFY(base_index.K() == K && base_index.Tau() == tau && base_index.Strategy() == strategy);
+    VERIFY_MSG(num_base_reads + new_reads.size() < std::numeric_limits<uint32_t>::max(),
+               "Number of reads " << num_base_reads + new_reads.size() << " exceeds limit of 32-bit read ids");
+
+    auto read = [&](size_t i) -> const T& {
+        return i < num_base_reads ? base_reads[i] : new_reads[i - num_base_reads];
+    };
+    auto is_query = [&](size_t j, size_t i) -> bool {
+        size_t len_j = length(read(j));
+        size_t len_i = length(read(i));
+        return len_j < len_i || (len_i == len_j && j < i);
+    };
+
+    new_postings = kmerIndexConstruction(new_reads, K, num_base_reads);
+    KmerIndex kmer2reads(new_postings.size());
+    for (const auto &kv : new_postings) {
+        auto base_list = base_index.Postings().Find(kv.first);
+        auto &list = kmer2reads[kv.first];
+        list.reserve(static_cast<size_t>(base_list.second - base_list.first) + kv.second.size());
+        list.assign(base_list.first, base_list.second);
+        list.insert(list.end(), kv.second.cbegin(), kv.second.cend());
+    }
 
     std::atomic<size_t> atomic_num_of_dist_computations;
     atomic_num_of_dist_computations = 0;
 
-    SEQAN_OMP_PRAGMA(parallel for schedule(dynamic, 8))
-    for (size_t j = 0; j < input_reads.size(); ++j) {
-        auto cand = find_candidates(input_reads[j], kmer2reads, reference_reads.size(), tau, K, strategy);
+    std::vector<std::vector<CandidateEdge>> thread_edges(omp_get_max_threads());
+    auto check_pair = [&](size_t j, size_t i, size_t thread_id) {
+        size_t dist = dist_fun(j, i);
 
-        for (size_t i : cand) {
-            unsigned dist = dist_fun(input_reads[j], reference_reads[i]);
+        atomic_num_of_dist_computations += 1;
 
-            atomic_num_of_dist_computations += 1;
+        if (dist <= tau) {
+            thread_edges[thread_id].push_back( { j, i, static_cast<int>(dist) } );
+        }
+    };
+
+    KmerSelections selections(num_base_reads);
+    for_each_candidate(new_reads, kmer2reads, num_base_reads + new_reads.size(), tau, K, strategy,
+                       [&](size_t j, size_t i, size_t thread_id) {
+        j += num_base_reads;
+        if (is_query(j, i)) {
+            check_pair(j, i, thread_id);
+        }
+    }, &selections);
+    new_selections = std::move(selections.index);
+
+    // base read is a candidate for the new read if the new read contains at least strategy of its chosen k-mers
+    SEQAN_OMP_PRAGMA(parallel)
+    {
+        size_t thread_id = static_cast<size_t>(omp_get_thread_num());
+        std::vector<uint64_t> codes;
+        std::vector<uint32_t> hits;
+        SEQAN_OMP_PRAGMA(for schedule(dynamic, 8))
+        for (size_t n = 0; n < new_reads.size(); ++n) {
+            hits.clear();
+            if (strategy == 0) {
+                hits.resize(num_base_reads);
+                std::iota(hits.begin(), hits.end(), 0);
+            } else {
+                codes.clear();
+                for (const auto &kmer : algorithms::Kmers(new_reads[n], K)) {
+                    codes.push_back(kmer.code);
+                }
+                remove_duplicates(codes);
+                for (uint64_t code : codes) {
+                    auto list = base_index.Selections().Find(code);
+                    hits.insert(hits.end(), list.first, list.second);
+                }
+                std::sort(hits.begin(), hits.end());
+            }
 
-            if (dist <= tau) {
-                g[j].push_back( { i, dist } );
+            size_t j = num_base_reads + n;
+            for (size_t begin = 0, end = 0; begin < hits.size(); begin = end) {
+                while (end < hits.size() && hits[end] == hits[begin]) {
+                    ++end;
+                }
+                if (end - begin >= strategy && is_query(hits[begin], j)) {
+                    check_pair(hits[begin], j, thread_id);
+                }
             }
         }
     }
 
+    Graph g(num_base_reads + new_reads.size());
+    for (auto &edges : thread_edges) {
+        for (const auto &edge : edges) {
+            g[edge.from].push_back( { edge.to, edge.dist } );
+            g[edge.to].push_back( { edge.from, edge.dist } );
+        }
+        std::vector<CandidateEdge>().swap(edges); // Free memory
+    }
+
+    SEQAN_OMP_PRAGMA(parallel for schedule(guided, 8))
+    for (size_t j = 0; j < g.size(); ++j) {
+        remove_duplicates(g[j]);
+    }
+
     num_of_dist_computations = atomic_num_of_dist_computations;
 
     return g;
@@ -1,5 +1,6 @@
 #include <chrono>
 #include <atomic>
+#include <memory>
 
 #include <boost/program_options.hpp>
 namespace po = boost::program_options;
@@ -19,6 +20,8 @@ using seqan::CharString;
 
 #include "ig_matcher.hpp"
 #include "banded_half_smith_waterman.hpp"
+#include "packed_hamming.hpp"
+#include "persistent_kmer_index.hpp"
 #include "ig_final_alignment.hpp"
 #include "utils.hpp"
 #include <build_info.hpp>
@@ -34,6 +37,13 @@ struct SWGCParam {
     unsigned max_indels = 0;
     bool export_abundances = false;
     bool ignore_tails = true;
+    size_t ram_budget = 0;
+    std::string tmp_dir = "";
+    std::string output_format = "metis";
+    std::string kmer_index_file = "";
+    bool append = false;
+    std::string base_reads_file = "";
+    std::string base_graph_file = "";
 };
 
 
@@ -75,6 +85,22 @@ bool parse_cmd_line_arguments(int argc, char **argv, SWGCParam &args) {
              "maximum number of indels in Levenshtein distance")
             ("threads,t", po::value<unsigned>(&args.nthreads)->default_value(args.nthreads),
              "the number of parallel threads")
+            ("ram-budget", po::value<size_t>(&args.ram_budget)->default_value(args.ram_budget),
+             "RAM budget (in Mb) for edges of the graph; if it is positive, the graph is constructed out-of-core "
+             "using temporary files, otherwise it is constructed in memory")
+            ("tmp-dir", po::value<std::string>(&args.tmp_dir)->default_value(args.tmp_dir),
+             "directory for temporary files of out-of-core construction (default: directory of output file)")
+            ("output-format", po::value<std::string>(&args.output_format)->default_value(args.output_format),
+             "format of output graph: 'metis' (text) or 'binary' (CSR, loaded by dense_sgraph_finder without parsing)")
+            ("kmer-index", po::value<std::string>(&args.kmer_index_file)->default_value(args.kmer_index_file),
+             "file of persistent k-mer index of reads of the graph; if it is set, the index is saved after "
+             "graph construction and is updated in append mode")
+            ("append", "append mode: input reads are added to the graph of base reads, only edges incident to "
+             "input reads are computed; vertices of output graph are base reads followed by input reads")
+            ("base-reads", po::value<std::string>(&args.base_reads_file)->default_value(args.base_reads_file),
+             "reads of the graph extended in append mode (FASTA|FASTQ)")
+            ("base-graph", po::value<std::string>(&args.base_graph_file)->default_value(args.base_graph_file),
+             "graph extended in append mode (METIS or binary CSR)")
             ;
 
     // Hidden options, will be allowed both on command line and
@@ -144,10 +170,68 @@ bool parse_cmd_line_arguments(int argc, char **argv, SWGCParam &args) {
         args.export_abundances = false;
     }
 
+    if (args.output_format != "metis" && args.output_format != "binary") {
+        throw po::validation_error(po::validation_error::invalid_option_value, "output-format", args.output_format);
+    }
+
+    if (vm.count("append")) {
+        args.append = true;
+    }
+
+    if (args.append && (args.kmer_index_file == "" || args.base_reads_file == "" || args.base_graph_file == "")) {
+        throw po::error("append mode requires --kmer-index, --base-reads and --base-graph");
+    }
+
+    if ((args.append || args.kmer_index_file != "") && args.reference_file != "") {
+        throw po::error("k-mer index and append mode cannot be used with --reference-file");
+    }
+
+    if (args.append && args.ram_budget > 0) {
+        throw po::error("append mode cannot be used with --ram-budget");
+    }
+
     return true;
 }
 
 
+// weights are not written if they are empty
+void save_graph(const Graph &graph,
+                const std::vector<size_t> &weights,
+                const SWGCParam &args,
+                bool undirected = true) {
+    if (args.output_format == "binary") {
+        if (weights.empty()) {
+            write_binary_graph(graph, args.output_file, undirected);
+        } else {
+            write_binary_graph(graph, weights, args.output_file, undirected);
+        }
+    } else {
+        if (weights.empty()) {
+            write_metis_graph(graph, args.output_file, undirected);
+        } else {
+            write_metis_graph(graph, weights, args.output_file, undirected);
+        }
+    }
+}
+
+
+KmerIndexParams kmer_index_params(const SWGCParam &args) {
+    return { args.k, args.tau, args.strategy, args.max_indels, args.ignore_tails };
+}
+
+
+// selections are the k-mers chosen for reads during graph construction
+template<typename T>
+void save_kmer_index(const std::vector<T> &input_reads,
+                     const KmerIndex &kmer2reads,
+                     const KmerSelections &selections,
+                     const SWGCParam &args) {
+    INFO("Saving k-mer index to " << args.kmer_index_file);
+    write_kmer_index(args.kmer_index_file, kmer_index_params(args), input_reads.size(), reads_checksum(input_reads),
+                     kmer2reads, selections.index);
+}
+
+
 int main(int argc, char **argv) {
     segfault_handler sh;
     perf_counter pc;
@@ -175,6 +259,21 @@ int main(int argc, char **argv) {
     readRecords(input_ids, input_reads, seqFileIn_input);
     INFO(input_reads.size() << " reads were extracted from " << args.input_file);
 
+    // k-mers of the index are chosen with its parameters, so they cannot be changed in append mode
+    std::unique_ptr<PersistentKmerIndex> base_index;
+    if (args.append) {
+        INFO("Loading k-mer index " << args.kmer_index_file);
+        base_index.reset(new PersistentKmerIndex(args.kmer_index_file));
+        VERIFY_MSG(base_index->K() == args.k && base_index->Tau() == args.tau &&
+                   base_index->MaxIndels() == args.max_indels && base_index->IgnoreTails() == args.ignore_tails,
+                   "K-mer index was constructed with k = " << base_index->K() << ", tau = " << base_index->Tau() <<
+                   ", max indels = " << base_index->MaxIndels() << ", ignore tails = " << base_index->IgnoreTails());
+        if (args.strategy != base_index->Strategy()) {
+            INFO("Strategy " << base_index->Strategy() << " of k-mer index is used");
+            args.strategy = base_index->Strategy();
+        }
+    }
+
     INFO("Read length checking");
     size_t required_read_length = (args.strategy != 0) ? (args.k * (args.tau + args.strategy)) : 0;
     size_t required_read_length_for_single_strategy = args.k * (args.tau + 1);
@@ -192,7 +291,7 @@ int main(int argc, char **argv) {
     int saved_reads_single = static_cast<int>(discarded_reads) - static_cast<int>(discarded_reads_single);
     int saved_reads_double = static_cast<int>(discarded_reads) - static_cast<int>(discarded_reads_double);
 
-    if (saved_reads_single > 0.05 * static_cast<double>(input_reads.size())) {
+    if (!args.append && saved_reads_single > 0.05 * static_cast<double>(input_reads.size())) {
         if (saved_reads_single - saved_reads_double < 0.05 * static_cast<double>(input_reads.size())) {
             INFO(bformat("Choosing <<double>> strategy for saving %d reads")
                  % saved_reads_double);
@@ -216,23 +315,166 @@ int main(int argc, char **argv) {
 
     INFO("Strategy " << args.strategy << " was chosen");
 
-    auto dist_fun = [&args](const Dna5String& s1, const Dna5String& s2) -> unsigned {
+    // Hamming distance is computed on packed reads by whole words and stops once it exceeds tau,
+    // edit distance is computed by bit-parallel band rows and also stops once it exceeds tau
+    PackedReads packed_reads;
+    if (args.max_indels == 0) {
+        packed_reads.Add(input_reads);
+    }
+
+    // distance between reads s1 and s2 that have indices index1 and index2 in packed_reads
+    auto read_dist = [&args, &packed_reads](const Dna5String& s1, const Dna5String& s2,
+                                            size_t index1, size_t index2) -> unsigned {
         auto delta = [&args](int l) -> int { return (bool)(l)*2 * args.tau; };
         auto lizard_tail = [&args, &delta](int l) -> int { return args.ignore_tails ? 0 : -delta(l); };
-        return -half_sw_banded(s1, s2, 0, -1, -1, lizard_tail, args.max_indels);
+        if (args.max_indels == 0) {
+            return packed_half_hamming(packed_reads[index1], packed_reads[index2], args.tau, lizard_tail);
+        }
+        return half_edit_distance_banded(s1, s2, lizard_tail, args.max_indels, static_cast<int>(args.tau));
+    };
+    auto dist_fun = [&input_reads, &read_dist](size_t j, size_t i) -> unsigned {
+        return read_dist(input_reads[j], input_reads[i], j, i);
     };
 
-    if (args.reference_file == "") {
+    if (args.append) {
+        SeqFileIn seqFileIn_base(args.base_reads_file.c_str());
+        std::vector<CharString> base_ids;
+        std::vector<Dna5String> base_reads;
+
+        INFO("Reading base reads starts");
+        readRecords(base_ids, base_reads, seqFileIn_base);
+        INFO(base_reads.size() << " reads were extracted from " << args.base_reads_file);
+        VERIFY_MSG(base_reads.size() == base_index->NumReads() &&
+                   reads_checksum(base_reads) == base_index->ReadsChecksum(),
+                   "Base reads " << args.base_reads_file << " differ from reads of k-mer index " <<
+                   args.kmer_index_file);
+        if (args.max_indels == 0) {
+            packed_reads.Add(base_reads);
+        }
+
+        INFO("Reading base graph from " << args.base_graph_file);
+        Graph graph;
+        std::vector<size_t> base_weights;
+        if (is_binary_graph(args.base_graph_file)) {
+            read_binary_graph(args.base_graph_file, graph, base_weights);
+        } else {
+            read_metis_graph(args.base_graph_file, graph, base_weights);
+        }
+        VERIFY_MSG(graph.size() == base_reads.size(),
+                   "Base graph contains " << graph.size() << " vertices, but there are " << base_reads.size() <<
+                   " base reads");
+
+        // base reads follow input reads in packed_reads, but precede them in the appended graph
+        auto append_dist_fun = [&input_reads, &base_reads, &read_dist](size_t j, size_t i) -> unsigned {
+            size_t num_base_reads = base_reads.size();
+            auto read = [&](size_t k) -> const Dna5String& {
+                return k < num_base_reads ? base_reads[k] : input_reads[k - num_base_reads];
+            };
+            auto packed_index = [&](size_t k) -> size_t {
+                return k < num_base_reads ? input_reads.size() + k : k - num_base_reads;
+            };
+            return read_dist(read(j), read(i), packed_index(j), packed_index(i));
+        };
+
+        KmerIndex new_postings;
+        KmerIndex new_selections;
+        size_t num_of_dist_computations;
+        auto new_graph = tauDistGraphAppend(base_reads,
+                                            input_reads,
+                                            *base_index,
+                                            append_dist_fun,
+                                            args.tau, args.k,
+                                            args.strategy,
+                                            new_postings,
+                                            new_selections,
+                                            num_of_dist_computations);
+
+        INFO("Simularity computations: " << num_of_dist_computations << ", average " << \
+             static_cast<double>(num_of_dist_computations) / static_cast<double>(input_reads.size()) << " per read");
+
+        size_t num_of_new_edges = numEdges(new_graph);
+        INFO("New edges found: " << num_of_new_edges);
+        INFO("Strategy efficiency: " << static_cast<double> (num_of_new_edges) / static_cast<double>(num_of_dist_computations));
+
+        // new neighbours have greater ids, so adjacency lists remain sorted
+        graph.resize(new_graph.size());
+        for (size_t i = 0; i < graph.size(); ++i) {
+            graph[i].insert(graph[i].end(), new_graph[i].cbegin(), new_graph[i].cend());
+        }
+        new_graph.clear(); // Free memory
+        INFO("Edges in graph: " << numEdges(graph));
+
+        // Output
+        if (args.export_abundances) {
+            INFO("Saving graph (with abundances)");
+            base_ids.insert(base_ids.end(), input_ids.cbegin(), input_ids.cend());
+            auto abundances = find_abundances(base_ids);
+            save_graph(graph, abundances, args);
+        } else {
+            INFO("Saving graph (without abundances)");
+            save_graph(graph, {}, args);
+        }
+
+        INFO("Updating k-mer index " << args.kmer_index_file);
+        write_kmer_index(args.kmer_index_file, kmer_index_params(args), graph.size(),
+                         reads_checksum(input_reads, base_index->ReadsChecksum()),
+                         new_postings, new_selections, base_index.get());
+    } else if (args.reference_file == "" && args.ram_budget > 0) {
+        INFO("K-mer index construction");
+        auto kmer2reads = kmerIndexConstruction(input_reads, args.k);
+
+        std::string tmp_dir = args.tmp_dir != "" ? args.tmp_dir : path::parent_path(args.output_file);
+        std::string tmp_prefix = path::append_path(tmp_dir, path::filename(args.output_file));
+        INFO("Out-of-core construction with RAM budget " << args.ram_budget << " Mb, temporary files: " <<
+             tmp_prefix << ".*");
+        ExternalEdgeRuns edge_runs(tmp_prefix, args.ram_budget << 20, args.nthreads);
+
+        size_t num_of_dist_computations;
+        KmerSelections selections;
+        tauDistGraphExternal(input_reads,
+                             kmer2reads,
+                             dist_fun,
+                             args.tau, args.k,
+                             args.strategy,
+                             edge_runs,
+                             num_of_dist_computations,
+                             args.kmer_index_file != "" ? &selections : nullptr);
+
+        INFO("Simularity computations: " << num_of_dist_computations << ", average " << \
+             static_cast<double>(num_of_dist_computations) / static_cast<double>(input_reads.size()) << " per read");
+
+        size_t num_of_edges = 0;
+        if (args.export_abundances) {
+            INFO("Merging " << edge_runs.NumRuns() << " runs and saving graph (with abundances)");
+            auto abundances = find_abundances(input_ids);
+            num_of_edges = args.output_format == "binary" ?
+                           edge_runs.WriteBinaryGraph(input_reads.size(), args.output_file, abundances) :
+                           edge_runs.WriteMetisGraph(input_reads.size(), args.output_file, abundances);
+        } else {
+            INFO("Merging " << edge_runs.NumRuns() << " runs and saving graph (without abundances)");
+            num_of_edges = args.output_format == "binary" ?
+                           edge_runs.WriteBinaryGraph(input_reads.size(), args.output_file) :
+                           edge_runs.WriteMetisGraph(input_reads.size(), args.output_file);
+        }
+        INFO("Edges found: " << num_of_edges);
+        INFO("Strategy efficiency: " << static_cast<double> (num_of_edges) / static_cast<double>(num_of_dist_computations));
+
+        if (args.kmer_index_file != "") {
+            save_kmer_index(input_reads, kmer2reads, selections, args);
+        }
+    } else if (args.reference_file == "") {
         INFO("K-mer index construction");
         auto kmer2reads = kmerIndexConstruction(input_reads, args.k);
 
         size_t num_of_dist_computations;
+        KmerSelections selections;
         auto dist_graph = tauDistGraph(input_reads,
                                        kmer2reads,
                                        dist_fun,
                                        args.tau, args.k,
                                        args.strategy,
-                                       num_of_dist_computations);
+                                       num_of_dist_computations,
+                                       args.kmer_index_file != "" ? &selections : nullptr);
 
         INFO("Simularity computations: " << num_of_dist_computations << ", average " << \
              static_cast<double>(num_of_dist_computations) / static_cast<double>(input_reads.size()) << " per read");
@@ -245,10 +487,14 @@ int main(int argc, char **argv) {
         if (args.export_abundances) {
             INFO("Saving graph (with abundances)");
             auto abundances = find_abundances(input_ids);
-            write_metis_graph(dist_graph, abundances, args.output_file);
+            save_graph(dist_graph, abundances, args);
         } else {
             INFO("Saving graph (without abundances)");
-            write_metis_graph(dist_graph, args.output_file);
+            save_graph(dist_graph, {}, args);
+        }
+
+        if (args.kmer_index_file != "") {
+            save_kmer_index(input_reads, kmer2reads, selections, args);
         }
     } else {
         SeqFileIn seqFileIn_reference(args.reference_file.c_str());
@@ -258,15 +504,23 @@ int main(int argc, char **argv) {
         INFO("Reading input reads starts");
         readRecords(reference_ids, reference_reads, seqFileIn_reference);
         INFO(reference_reads.size() << " reads were extracted from " << args.reference_file);
+        if (args.max_indels == 0) {
+            packed_reads.Add(reference_reads);
+        }
 
         INFO("K-mer index construction");
         auto kmer2reads = kmerIndexConstruction(reference_reads, args.k);
 
+        // reference reads follow input reads in packed_reads
+        auto match_dist_fun = [&input_reads, &reference_reads, &read_dist](size_t j, size_t i) -> unsigned {
+            return read_dist(input_reads[j], reference_reads[i], j, input_reads.size() + i);
+        };
+
         size_t num_of_dist_computations;
         auto dist_graph = tauMatchGraph(input_reads,
                                         reference_reads,
                                         kmer2reads,
-                                        dist_fun,
+                                        match_dist_fun,
                                         args.tau, args.k,
                                         args.strategy,
                                         num_of_dist_computations);
@@ -282,10 +536,10 @@ int main(int argc, char **argv) {
         if (args.export_abundances) {
             INFO("Saving graph (with abundances)");
             auto abundances = find_abundances(input_ids);
-            write_metis_graph(dist_graph, abundances, args.output_file, false);
+            save_graph(dist_graph, abundances, args, false);
         } else {
             INFO("Saving graph (without abundances)");
-            write_metis_graph(dist_graph, args.output_file, false);
+            save_graph(dist_graph, {}, args, false);
         }
     }
 
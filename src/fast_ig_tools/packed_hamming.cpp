@@ -0,0 +1,133 @@
+#include "packed_hamming.hpp"
+
+#include <algorithm>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define PACKED_HAMMING_AVX2
+#include <immintrin.h>
+#endif
+
+void PackedReads::Add(const std::vector<seqan::Dna5String> &reads) {
+    if (offsets_.empty()) {
+        offsets_.push_back(0);
+    }
+    for (const auto &read : reads) {
+        size_t length = seqan::length(read);
+        size_t num_blocks = (length + 63) / 64;
+        size_t low = words_.size();
+        size_t high = low + num_blocks;
+        size_t n_mask = high + num_blocks;
+        words_.resize(low + 3 * num_blocks, 0);
+        for (size_t i = 0; i < length; ++i) {
+            unsigned code = seqan::ordValue(read[i]);
+            uint64_t bit = uint64_t(1) << (i % 64);
+            size_t block = i / 64;
+            if (code > 3) {
+                words_[n_mask + block] |= bit;
+                continue;
+            }
+            if (code & 1) {
+                words_[low + block] |= bit;
+            }
+            if (code & 2) {
+                words_[high + block] |= bit;
+            }
+        }
+        offsets_.push_back(words_.size());
+        lengths_.push_back(length);
+    }
+}
+
+namespace {
+
+inline uint64_t block_mismatches(const PackedRead &read1, const PackedRead &read2, size_t block) {
+    return (read1.Low()[block] ^ read2.Low()[block]) |
+           (read1.High()[block] ^ read2.High()[block]) |
+           (read1.NMask()[block] ^ read2.NMask()[block]);
+}
+
+// counts mismatches in blocks starting from first_block, count is the number of mismatches in previous blocks
+template<typename Popcount>
+size_t count_remaining_mismatches(const PackedRead &read1, const PackedRead &read2,
+                                  size_t first_block, size_t count, size_t max_mismatches,
+                                  const Popcount &popcount) {
+    size_t common_length = std::min(read1.length, read2.length);
+    size_t num_full_blocks = common_length / 64;
+    for (size_t block = first_block; block < num_full_blocks; ++block) {
+        count += popcount(block_mismatches(read1, read2, block));
+        if (count > max_mismatches) {
+            return count;
+        }
+    }
+    // the longer read has nucleotides after the end of the shorter one in the last block
+    if (common_length % 64 != 0) {
+        uint64_t mask = (uint64_t(1) << (common_length % 64)) - 1;
+        count += popcount(block_mismatches(read1, read2, num_full_blocks) & mask);
+    }
+    return count;
+}
+
+#ifdef PACKED_HAMMING_AVX2
+struct HardwarePopcount {
+    __attribute__((target("popcnt")))
+    size_t operator()(uint64_t word) const { return static_cast<size_t>(_mm_popcnt_u64(word)); }
+};
+
+__attribute__((target("avx2,popcnt")))
+inline __m256i load_blocks(const uint64_t *plane, size_t block) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(plane + block));
+}
+
+__attribute__((target("avx2,popcnt")))
+size_t count_packed_mismatches_avx2(const PackedRead &read1, const PackedRead &read2, size_t max_mismatches) {
+    HardwarePopcount popcount;
+    size_t num_full_blocks = std::min(read1.length, read2.length) / 64;
+    size_t count = 0;
+    size_t block = 0;
+    // four blocks (256 nucleotides) per iteration, early exit is checked after each of them
+    for (; block + 4 <= num_full_blocks; block += 4) {
+        __m256i low = _mm256_xor_si256(load_blocks(read1.Low(), block), load_blocks(read2.Low(), block));
+        __m256i high = _mm256_xor_si256(load_blocks(read1.High(), block), load_blocks(read2.High(), block));
+        __m256i n_mask = _mm256_xor_si256(load_blocks(read1.NMask(), block), load_blocks(read2.NMask(), block));
+        __m256i diff = _mm256_or_si256(_mm256_or_si256(low, high), n_mask);
+        count += static_cast<size_t>(_mm_popcnt_u64(static_cast<uint64_t>(_mm256_extract_epi64(diff, 0)))) +
+                 static_cast<size_t>(_mm_popcnt_u64(static_cast<uint64_t>(_mm256_extract_epi64(diff, 1)))) +
+                 static_cast<size_t>(_mm_popcnt_u64(static_cast<uint64_t>(_mm256_extract_epi64(diff, 2)))) +
+                 static_cast<size_t>(_mm_popcnt_u64(static_cast<uint64_t>(_mm256_extract_epi64(diff, 3))));
+        if (count > max_mismatches) {
+            return count;
+        }
+    }
+    return count_remaining_mismatches(read1, read2, block, count, max_mismatches, popcount);
+}
+#endif
+
+} // namespace
+
+
+size_t count_packed_mismatches_portable(const PackedRead &read1, const PackedRead &read2, size_t max_mismatches) {
+    auto popcount = [](uint64_t word) { return static_cast<size_t>(__builtin_popcountll(word)); };
+    return count_remaining_mismatches(read1, read2, 0, 0, max_mismatches, popcount);
+}
+
+
+bool packed_hamming_uses_avx2() {
+#ifdef PACKED_HAMMING_AVX2
+    static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+
+size_t count_packed_mismatches(const PackedRead &read1, const PackedRead &read2, size_t max_mismatches) {
+#ifdef PACKED_HAMMING_AVX2
+    if (packed_hamming_uses_avx2()) {
+        return count_packed_mismatches_avx2(read1, read2, max_mismatches);
+    }
+#endif
+    return count_packed_mismatches_portable(read1, read2, max_mismatches);
+}
+
+// vim: ts=4:sw=4
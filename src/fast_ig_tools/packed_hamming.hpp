@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include <seqan/sequence.h>
+
+// Reads packed into bit planes for word-wise Hamming distance computation.
+// Every block of 64 nucleotides is stored as three 64-bit words: low and high bits of nucleotide codes
+// (A = 0, C = 1, G = 2, T = 3, N = 0) and the mask of Ns. Two nucleotides are different iff they differ in one
+// of the planes, so N matches N only, like in comparison of seqan::Dna5 letters. Bits after the end of read are zero.
+// Planes of a read are stored one after another: low words of all blocks, then high words, then masks of Ns.
+
+struct PackedRead {
+    const uint64_t *words;
+    size_t num_blocks;
+    size_t length;
+
+    const uint64_t* Low() const { return words; }
+
+    const uint64_t* High() const { return words + num_blocks; }
+
+    const uint64_t* NMask() const { return words + 2 * num_blocks; }
+};
+
+class PackedReads {
+    std::vector<uint64_t> words_;
+    std::vector<size_t> offsets_;
+    std::vector<size_t> lengths_;
+
+public:
+    PackedReads() { }
+
+    explicit PackedReads(const std::vector<seqan::Dna5String> &reads) {
+        Add(reads);
+    }
+
+    // packs reads, they get indices starting from the current size
+    void Add(const std::vector<seqan::Dna5String> &reads);
+
+    size_t size() const { return lengths_.size(); }
+
+    PackedRead operator[](size_t index) const {
+        return {words_.data() + offsets_[index], (offsets_[index + 1] - offsets_[index]) / 3, lengths_[index]};
+    }
+
+};
+
+// returns the number of mismatches in the common prefix of reads if it does not exceed max_mismatches,
+// otherwise returns some number of mismatches greater than max_mismatches, i.e., counting stops early
+// AVX2 kernel is used if it is supported by CPU
+size_t count_packed_mismatches(const PackedRead &read1, const PackedRead &read2, size_t max_mismatches);
+
+// portable kernel, exposed for testing
+size_t count_packed_mismatches_portable(const PackedRead &read1, const PackedRead &read2, size_t max_mismatches);
+
+bool packed_hamming_uses_avx2();
+
+// the same as -half_hamming(s1, s2, 0, -1, lizard_tail) from banded_half_smith_waterman.hpp,
+// i.e., the number of mismatches in the common prefix minus lizard_tail of the difference of lengths,
+// but if the distance exceeds tau, then some distance greater than tau is returned
+template<typename Tf>
+int packed_half_hamming(const PackedRead &read1, const PackedRead &read2, unsigned tau, const Tf &lizard_tail) {
+    int tail = -lizard_tail(std::abs(static_cast<int>(read1.length) - static_cast<int>(read2.length)));
+    int max_mismatches = static_cast<int>(tau) - tail;
+    if (max_mismatches < 0) {
+        return tail;
+    }
+    return static_cast<int>(count_packed_mismatches(read1, read2, static_cast<size_t>(max_mismatches))) + tail;
+}
+
+// vim: ts=4:sw=4
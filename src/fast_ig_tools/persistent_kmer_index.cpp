@@ -0,0 +1,194 @@
+#include "persistent_kmer_index.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include <verify.hpp>
+
+namespace {
+
+size_t padded_size(size_t size) {
+    return (size + 7) / 8 * 8;
+}
+
+// positions of sections of a table from the beginning of file
+struct TableSections {
+    size_t codes;
+    size_t offsets;
+    size_t reads;
+    size_t end;
+
+    TableSections(size_t begin, size_t num_kmers, size_t num_entries) {
+        codes = begin;
+        offsets = codes + num_kmers * sizeof(uint64_t);
+        reads = offsets + (num_kmers + 1) * sizeof(uint64_t);
+        end = reads + padded_size(num_entries * sizeof(uint32_t));
+    }
+};
+
+KmerTable map_table(const char *data, const TableSections &sections, size_t num_kmers) {
+    KmerTable table;
+    table.codes = reinterpret_cast<const uint64_t*>(data + sections.codes);
+    table.offsets = reinterpret_cast<const uint64_t*>(data + sections.offsets);
+    table.reads = reinterpret_cast<const uint32_t*>(data + sections.reads);
+    table.num_kmers = num_kmers;
+    return table;
+}
+
+// passes k-mers of base table and lists in increasing order of codes to handler(code, base_index, list),
+// base_index is num_kmers of base table for k-mers absent in it, list is nullptr for k-mers absent in lists
+template <typename Handler>
+void merge_tables(const KmerTable &base, const KmerLists &lists, const std::vector<uint64_t> &sorted_codes,
+                  Handler handle) {
+    size_t i = 0;
+    size_t j = 0;
+    while (i < base.num_kmers || j < sorted_codes.size()) {
+        if (j == sorted_codes.size() || (i < base.num_kmers && base.codes[i] < sorted_codes[j])) {
+            handle(base.codes[i], i, nullptr);
+            ++i;
+        } else if (i == base.num_kmers || sorted_codes[j] < base.codes[i]) {
+            handle(sorted_codes[j], base.num_kmers, &lists.at(sorted_codes[j]));
+            ++j;
+        } else {
+            handle(base.codes[i], i, &lists.at(sorted_codes[j]));
+            ++i;
+            ++j;
+        }
+    }
+}
+
+std::vector<uint64_t> sorted_codes(const KmerLists &lists) {
+    std::vector<uint64_t> codes;
+    codes.reserve(lists.size());
+    for (const auto &kv : lists) {
+        codes.push_back(kv.first);
+    }
+    std::sort(codes.begin(), codes.end());
+    return codes;
+}
+
+template <typename T>
+void write_value(std::ostream &out, const T &value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// returns the number of k-mers and the number of entries of the merged table
+std::pair<size_t, size_t> merged_table_size(const KmerTable &base, const KmerLists &lists,
+                                            const std::vector<uint64_t> &codes) {
+    size_t num_kmers = 0;
+    size_t num_entries = base.num_kmers ? base.offsets[base.num_kmers] : 0;
+    merge_tables(base, lists, codes, [&](uint64_t, size_t, const std::vector<size_t> *list) {
+        ++num_kmers;
+        num_entries += list ? list->size() : 0;
+    });
+    return { num_kmers, num_entries };
+}
+
+void write_table(std::ostream &out, const KmerTable &base, const KmerLists &lists,
+                 const std::vector<uint64_t> &codes, size_t num_entries) {
+    merge_tables(base, lists, codes, [&](uint64_t code, size_t, const std::vector<size_t>*) {
+        write_value(out, code);
+    });
+
+    uint64_t offset = 0;
+    write_value(out, offset);
+    merge_tables(base, lists, codes, [&](uint64_t, size_t base_index, const std::vector<size_t> *list) {
+        if (base_index < base.num_kmers) {
+            offset += base.offsets[base_index + 1] - base.offsets[base_index];
+        }
+        offset += list ? list->size() : 0;
+        write_value(out, offset);
+    });
+
+    std::vector<uint32_t> reads;
+    merge_tables(base, lists, codes, [&](uint64_t, size_t base_index, const std::vector<size_t> *list) {
+        reads.clear();
+        if (base_index < base.num_kmers) {
+            reads.assign(base.reads + base.offsets[base_index], base.reads + base.offsets[base_index + 1]);
+        }
+        if (list) {
+            for (size_t read : *list) {
+                reads.push_back(static_cast<uint32_t>(read));
+            }
+        }
+        out.write(reinterpret_cast<const char*>(reads.data()),
+                  static_cast<std::streamsize>(reads.size() * sizeof(uint32_t)));
+    });
+
+    const char zeros[8] = {};
+    out.write(zeros, static_cast<std::streamsize>(padded_size(num_entries * sizeof(uint32_t)) -
+                                                  num_entries * sizeof(uint32_t)));
+}
+
+}
+
+PersistentKmerIndex::PersistentKmerIndex(const std::string &filename) : reader_(filename, false, size_t(-1)) {
+    const char *data = static_cast<const char*>(reader_.data());
+    size_t size = reader_.size();
+    VERIFY_MSG(size >= sizeof(header_) && memcmp(data, kmer_index_file::magic, sizeof(kmer_index_file::magic)) == 0,
+               filename << " is not a k-mer index");
+    memcpy(&header_, data, sizeof(header_));
+    VERIFY_MSG(header_.version == kmer_index_file::version, "K-mer index " << filename << " has unsupported version");
+
+    TableSections postings(sizeof(header_), header_.num_kmers, header_.num_postings);
+    TableSections selections(postings.end, header_.num_selected_kmers, header_.num_selections);
+    VERIFY_MSG(size >= selections.end, "K-mer index " << filename << " is truncated");
+    postings_ = map_table(data, postings, header_.num_kmers);
+    selections_ = map_table(data, selections, header_.num_selected_kmers);
+}
+
+void write_kmer_index(const std::string &filename,
+                      const KmerIndexParams &params,
+                      size_t num_reads,
+                      uint64_t reads_checksum,
+                      const KmerLists &postings,
+                      const KmerLists &selections,
+                      const PersistentKmerIndex *base) {
+    VERIFY_MSG(num_reads < std::numeric_limits<uint32_t>::max(),
+               "Number of reads " << num_reads << " exceeds limit of 32-bit read ids");
+    KmerTable base_postings;
+    KmerTable base_selections;
+    if (base) {
+        VERIFY(base->K() == params.k && base->Tau() == params.tau && base->Strategy() == params.strategy &&
+               base->MaxIndels() == params.max_indels && base->IgnoreTails() == params.ignore_tails &&
+               base->NumReads() <= num_reads);
+        base_postings = base->Postings();
+        base_selections = base->Selections();
+    }
+
+    std::vector<uint64_t> posting_codes = sorted_codes(postings);
+    std::vector<uint64_t> selection_codes = sorted_codes(selections);
+    auto postings_size = merged_table_size(base_postings, postings, posting_codes);
+    auto selections_size = merged_table_size(base_selections, selections, selection_codes);
+
+    kmer_index_file::Header header;
+    memcpy(header.magic, kmer_index_file::magic, sizeof(kmer_index_file::magic));
+    header.version = kmer_index_file::version;
+    header.k = params.k;
+    header.tau = params.tau;
+    header.strategy = params.strategy;
+    header.max_indels = params.max_indels;
+    header.ignore_tails = params.ignore_tails ? 1 : 0;
+    header.reads_checksum = reads_checksum;
+    header.num_reads = num_reads;
+    header.num_kmers = postings_size.first;
+    header.num_postings = postings_size.second;
+    header.num_selected_kmers = selections_size.first;
+    header.num_selections = selections_size.second;
+
+    std::string tmp_filename = filename + ".tmp";
+    {
+        std::ofstream out(tmp_filename, std::ios::binary);
+        VERIFY_MSG(out.good(), "Cannot open " << tmp_filename);
+        write_value(out, header);
+        write_table(out, base_postings, postings, posting_codes, header.num_postings);
+        write_table(out, base_selections, selections, selection_codes, header.num_selections);
+        VERIFY_MSG(out.good(), "Cannot write k-mer index " << tmp_filename);
+    }
+    VERIFY_MSG(std::rename(tmp_filename.c_str(), filename.c_str()) == 0,
+               "Cannot rename " << tmp_filename << " to " << filename);
+}
+
+// vim: ts=4:sw=4
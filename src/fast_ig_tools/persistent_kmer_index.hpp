@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <io/mmapped_reader.hpp>
+
+// Persistent k-mer index of reads of a graph constructed by ig_swgraph_construct (see --kmer-index and --append).
+// The index consists of two tables that map k-mers to sorted lists of read ids:
+//   postings:   all k-mers of reads except ones containing N, like KmerIndex in ig_matcher.hpp
+//   selections: k-mers chosen by optimal_coverage for each read during graph construction
+//               (see select_candidate_kmers), a read occurs in the list of a k-mer as many times as it was chosen
+// Selections make it possible to find candidates among indexed reads for new reads without querying indexed reads
+// once again: an indexed read is a candidate for a new read if the new read contains at least strategy of its
+// chosen k-mers.
+// The header stores parameters of graph construction that cannot be changed in append mode and the checksum
+// of indexed reads (see reads_checksum in ig_matcher.hpp), so that the index is not used with other base reads.
+//
+// layout (numbers are stored in the host byte order, each section is padded to 8 bytes):
+//   header:      char magic[8], uint64 version, uint64 k, uint64 tau, uint64 strategy, uint64 max_indels,
+//                uint64 ignore_tails, uint64 reads_checksum, uint64 num_reads,
+//                uint64 num_kmers, uint64 num_postings, uint64 num_selected_kmers, uint64 num_selections
+//   postings:    uint64 codes[num_kmers] (sorted), uint64 offsets[num_kmers + 1], uint32 reads[num_postings]
+//   selections:  uint64 codes[num_selected_kmers] (sorted), uint64 offsets[num_selected_kmers + 1],
+//                uint32 reads[num_selections]
+// Read ids are 32-bit, so the index can contain at most 2^32 - 1 reads.
+namespace kmer_index_file {
+    const char magic[8] = {'I', 'G', 'K', 'M', 'E', 'R', 'I', 'X'};
+    const uint64_t version = 2;
+
+    struct Header {
+        char magic[8];
+        uint64_t version;
+        uint64_t k;
+        uint64_t tau;
+        uint64_t strategy;
+        uint64_t max_indels;
+        uint64_t ignore_tails;
+        uint64_t reads_checksum;
+        uint64_t num_reads;
+        uint64_t num_kmers;
+        uint64_t num_postings;
+        uint64_t num_selected_kmers;
+        uint64_t num_selections;
+    };
+}
+
+// parameters of graph construction the index is built with
+struct KmerIndexParams {
+    size_t k;
+    unsigned tau;
+    unsigned strategy;
+    unsigned max_indels;
+    bool ignore_tails;
+};
+
+// lists of read ids by k-mer code, i.e., KmerIndex
+using KmerLists = std::unordered_map<uint64_t, std::vector<size_t>>;
+
+// table of the index file mapped into memory
+struct KmerTable {
+    const uint64_t *codes = nullptr;
+    const uint64_t *offsets = nullptr;
+    const uint32_t *reads = nullptr;
+    size_t num_kmers = 0;
+
+    // list of reads of the k-mer, empty if the k-mer is absent
+    std::pair<const uint32_t*, const uint32_t*> Find(uint64_t code) const {
+        const uint64_t *it = std::lower_bound(codes, codes + num_kmers, code);
+        if (it == codes + num_kmers || *it != code) {
+            return { nullptr, nullptr };
+        }
+        size_t index = static_cast<size_t>(it - codes);
+        return { reads + offsets[index], reads + offsets[index + 1] };
+    }
+};
+
+class PersistentKmerIndex {
+    MMappedReader reader_;
+    kmer_index_file::Header header_;
+    KmerTable postings_;
+    KmerTable selections_;
+
+public:
+    explicit PersistentKmerIndex(const std::string &filename);
+
+    PersistentKmerIndex(const PersistentKmerIndex&) = delete;
+
+    PersistentKmerIndex& operator=(const PersistentKmerIndex&) = delete;
+
+    size_t K() const { return header_.k; }
+
+    unsigned Tau() const { return static_cast<unsigned>(header_.tau); }
+
+    unsigned Strategy() const { return static_cast<unsigned>(header_.strategy); }
+
+    unsigned MaxIndels() const { return static_cast<unsigned>(header_.max_indels); }
+
+    bool IgnoreTails() const { return header_.ignore_tails != 0; }
+
+    KmerIndexParams Params() const { return { K(), Tau(), Strategy(), MaxIndels(), IgnoreTails() }; }
+
+    uint64_t ReadsChecksum() const { return header_.reads_checksum; }
+
+    size_t NumReads() const { return header_.num_reads; }
+
+    const KmerTable& Postings() const { return postings_; }
+
+    const KmerTable& Selections() const { return selections_; }
+};
+
+// writes index of num_reads reads with given postings and selections, lists should be sorted;
+// reads_checksum is the checksum of all num_reads reads;
+// if base is not null, the written index contains reads of base as well, ids of postings and selections should be
+// not less than base->NumReads() then. The file is written to a temporary file that replaces filename at the end,
+// so base may be read from filename.
+void write_kmer_index(const std::string &filename,
+                      const KmerIndexParams &params,
+                      size_t num_reads,
+                      uint64_t reads_checksum,
+                      const KmerLists &postings,
+                      const KmerLists &selections,
+                      const PersistentKmerIndex *base = nullptr);
+
+// vim: ts=4:sw=4
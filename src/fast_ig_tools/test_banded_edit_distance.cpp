@@ -0,0 +1,68 @@
+#include <gmock/gmock.h>
+
+#include <random>
+
+#include "banded_half_smith_waterman.hpp"
+
+// mutated copies of a random sequence: substitutions (including N), insertions and deletions
+seqan::Dna5String mutated_prefix(const seqan::Dna5String &base, size_t length, size_t num_errors, std::mt19937 &rnd) {
+    seqan::Dna5String read = seqan::prefix(base, length);
+    for (size_t e = 0; e < num_errors && seqan::length(read) > 0; ++e) {
+        size_t pos = rnd() % seqan::length(read);
+        switch (rnd() % 3) {
+            case 0:
+                read[pos] = seqan::Dna5(rnd() % 5);
+                break;
+            case 1:
+                seqan::insertValue(read, pos, seqan::Dna5(rnd() % 4));
+                break;
+            default:
+                seqan::erase(read, pos);
+        }
+    }
+    return read;
+}
+
+// bit-parallel distance coincides with half_sw_banded unless it exceeds tau
+TEST(banded_edit_distance_tests, bit_parallel_distance_is_consistent_with_half_sw_banded) {
+    std::mt19937 rnd(19);
+    seqan::Dna5String base;
+    for (size_t i = 0; i < 700; ++i) {
+        seqan::appendValue(base, seqan::Dna5(rnd() % 4));
+    }
+    std::vector<seqan::Dna5String> reads;
+    for (size_t i = 0; i < 40; ++i) {
+        size_t length = i < 4 ? i : (rnd() % 2 ? 600 + rnd() % 100 : rnd() % 150);
+        reads.push_back(mutated_prefix(base, length, rnd() % 12, rnd));
+    }
+
+    for (int max_indels : {0, 1, 2, 3, 6, 31, 40}) {
+        for (int tau : {1, 4, 20, std::numeric_limits<int>::max() / 4}) {
+            auto no_tail = [](int) -> int { return 0; };
+            auto tail_penalty = [tau](int l) -> int { return -(l != 0) * 2 * std::min(tau, 10); };
+            auto linear_tail = [](int l) -> int { return -l; };
+            for (size_t i = 0; i < reads.size(); ++i) {
+                for (size_t j = 0; j < reads.size(); j += 1 + rnd() % 3) {
+                    const auto &s1 = reads[i];
+                    const auto &s2 = reads[j];
+                    int dist = -half_sw_banded(s1, s2, 0, -1, -1, no_tail, max_indels);
+                    int fast_dist = half_edit_distance_banded(s1, s2, no_tail, max_indels, tau);
+                    ASSERT_TRUE(dist > tau ? fast_dist > tau : fast_dist == dist) <<
+                            "max_indels " << max_indels << ", tau " << tau << ", reads " << i << " and " << j;
+
+                    dist = -half_sw_banded(s1, s2, 0, -1, -1, tail_penalty, max_indels);
+                    fast_dist = half_edit_distance_banded(s1, s2, tail_penalty, max_indels, tau);
+                    ASSERT_TRUE(dist > tau ? fast_dist > tau : fast_dist == dist) <<
+                            "max_indels " << max_indels << ", tau " << tau << ", reads " << i << " and " << j;
+
+                    dist = -half_sw_banded(s1, s2, 0, -1, -1, linear_tail, max_indels);
+                    fast_dist = half_edit_distance_banded(s1, s2, linear_tail, max_indels, tau);
+                    ASSERT_TRUE(dist > tau ? fast_dist > tau : fast_dist == dist) <<
+                            "max_indels " << max_indels << ", tau " << tau << ", reads " << i << " and " << j;
+                }
+            }
+        }
+    }
+}
+
+// vim: ts=4:sw=4
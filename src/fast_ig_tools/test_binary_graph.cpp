@@ -0,0 +1,158 @@
+#include <gmock/gmock.h>
+
+#include <cstddef>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+#include <csr_graph_format.hpp>
+#include <path_helper.hpp>
+
+#include "fast_ig_tools.hpp"
+#include "external_graph.hpp"
+#include "../graph_utils/graph_io.hpp"
+
+std::string read_file(const std::string &filename) {
+    std::ifstream in(filename, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+// random undirected graph with sorted adjacency lists like the ones constructed by tauDistGraph
+Graph random_graph(size_t num_vertices, std::mt19937 &rnd) {
+    Graph graph(num_vertices);
+    for (size_t e = 0; e < num_vertices * 3; ++e) {
+        size_t from = rnd() % num_vertices;
+        size_t to = rnd() % num_vertices;
+        if (from == to) {
+            continue;
+        }
+        int dist = static_cast<int>(rnd() % 5);
+        graph[from].push_back({to, dist});
+        graph[to].push_back({from, dist});
+    }
+    for (auto &edges : graph) {
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    }
+    return graph;
+}
+
+// conversion to binary format and back reproduces METIS file, out-of-core writer produces the same binary file
+TEST(binary_graph_tests, binary_graph_round_trip) {
+    std::string tmp_dir = path::make_temp_dir("/tmp", "binary_graph_test");
+    std::mt19937 rnd(42);
+    for (size_t num_vertices : {1, 10, 301}) {
+        Graph graph = random_graph(num_vertices, rnd);
+        std::vector<size_t> weights(num_vertices);
+        for (size_t i = 0; i < num_vertices; ++i) {
+            weights[i] = rnd() % 10 + 1;
+        }
+        ExternalEdgeRuns edge_runs(path::append_path(tmp_dir, "graph"), 100 * sizeof(ExternalEdge), 1);
+        for (size_t i = 0; i < num_vertices; ++i) {
+            for (const auto &edge : graph[i]) {
+                edge_runs.AddEdge(0, i, edge.first, edge.second);
+            }
+        }
+
+        std::string metis_filename = path::append_path(tmp_dir, "metis.graph");
+        std::string binary_filename = path::append_path(tmp_dir, "binary.graph");
+        std::string external_filename = path::append_path(tmp_dir, "external.graph");
+        write_metis_graph(graph, weights, metis_filename);
+        write_binary_graph(graph, weights, binary_filename);
+        EXPECT_EQ(numEdges(graph), edge_runs.WriteBinaryGraph(num_vertices, external_filename, weights));
+        EXPECT_EQ(read_file(binary_filename), read_file(external_filename));
+        EXPECT_FALSE(is_binary_graph(metis_filename));
+        EXPECT_TRUE(is_binary_graph(binary_filename));
+
+        Graph loaded_graph;
+        std::vector<size_t> loaded_weights;
+        EXPECT_EQ(numEdges(graph), read_binary_graph(binary_filename, loaded_graph, loaded_weights));
+        EXPECT_EQ(graph, loaded_graph);
+        EXPECT_EQ(weights, loaded_weights);
+        EXPECT_EQ(numEdges(graph), read_metis_graph(metis_filename, loaded_graph, loaded_weights));
+        EXPECT_EQ(graph, loaded_graph);
+        EXPECT_EQ(weights, loaded_weights);
+
+        write_binary_graph(graph, binary_filename);
+        read_binary_graph(binary_filename, loaded_graph, loaded_weights);
+        EXPECT_EQ(graph, loaded_graph);
+        EXPECT_TRUE(loaded_weights.empty());
+    }
+    path::remove_dir(tmp_dir);
+}
+
+// graph_utils loads the same sparse graph from METIS and binary files
+TEST(binary_graph_tests, graph_reader_loads_binary_graph) {
+    std::string tmp_dir = path::make_temp_dir("/tmp", "binary_graph_test");
+    std::mt19937 rnd(7);
+    for (bool vertex_weighted : {false, true}) {
+        Graph graph = random_graph(200, rnd);
+        std::vector<size_t> weights(graph.size());
+        for (size_t i = 0; i < graph.size(); ++i) {
+            weights[i] = rnd() % 10 + 1;
+        }
+        std::string metis_filename = path::append_path(tmp_dir, "metis.graph");
+        std::string binary_filename = path::append_path(tmp_dir, "binary.graph");
+        if (vertex_weighted) {
+            write_metis_graph(graph, weights, metis_filename);
+            write_binary_graph(graph, weights, binary_filename);
+        } else {
+            write_metis_graph(graph, metis_filename);
+            write_binary_graph(graph, binary_filename);
+        }
+
+        SparseGraphPtr metis_graph = GraphReader(metis_filename).CreateGraph();
+        SparseGraphPtr binary_graph = GraphReader(binary_filename).CreateGraph();
+        ASSERT_TRUE(metis_graph && binary_graph);
+        EXPECT_EQ(metis_graph->N(), binary_graph->N());
+        EXPECT_EQ(metis_graph->NZ(), binary_graph->NZ());
+        EXPECT_EQ(metis_graph->RowIndex(), binary_graph->RowIndex());
+        EXPECT_EQ(metis_graph->Col(), binary_graph->Col());
+        EXPECT_EQ(metis_graph->Dist(), binary_graph->Dist());
+        EXPECT_EQ(metis_graph->RowIndexT(), binary_graph->RowIndexT());
+        EXPECT_EQ(metis_graph->ColT(), binary_graph->ColT());
+        EXPECT_EQ(metis_graph->DistT(), binary_graph->DistT());
+        EXPECT_EQ(metis_graph->Weight(), binary_graph->Weight());
+    }
+    path::remove_dir(tmp_dir);
+}
+
+// corrupted files are rejected before their sections are accessed
+TEST(binary_graph_tests, graph_reader_rejects_corrupted_binary_graph) {
+    std::string tmp_dir = path::make_temp_dir("/tmp", "binary_graph_test");
+    std::mt19937 rnd(11);
+    Graph graph = random_graph(50, rnd);
+    std::string filename = path::append_path(tmp_dir, "binary.graph");
+    write_binary_graph(graph, filename);
+    const std::string data = read_file(filename);
+    csr_graph::Header header;
+    memcpy(&header, data.data(), sizeof(header));
+    csr_graph::Sections sections(header);
+
+    auto corrupted = [&](size_t pos, uint64_t value, size_t value_size) {
+        std::string corrupted_data = data;
+        memcpy(&corrupted_data[pos], &value, value_size);
+        std::string corrupted_filename = path::append_path(tmp_dir, "corrupted.graph");
+        std::ofstream out(corrupted_filename, std::ios::binary);
+        out << corrupted_data;
+        return corrupted_filename;
+    };
+
+    // sizes of sections overflow
+    std::string huge_entries = corrupted(offsetof(csr_graph::Header, num_entries), uint64_t(1) << 62, 8);
+    EXPECT_DEATH(GraphReader(huge_entries).CreateGraph(), "truncated");
+    // the last row offset does not match the number of entries
+    std::string wrong_last_offset = corrupted(sections.neighbours - sizeof(uint64_t), header.num_entries - 1, 8);
+    EXPECT_DEATH(GraphReader(wrong_last_offset).CreateGraph(), "number of entries");
+    // row offsets decrease
+    std::string decreasing_offsets = corrupted(sections.offsets + sizeof(uint64_t), header.num_entries, 8);
+    EXPECT_DEATH(GraphReader(decreasing_offsets).CreateGraph(), "decrease");
+    // neighbour id is out of range
+    std::string missing_neighbour = corrupted(sections.neighbours, graph.size(), 4);
+    EXPECT_DEATH(GraphReader(missing_neighbour).CreateGraph(), "missing neighbour");
+    path::remove_dir(tmp_dir);
+}
+
+// vim: ts=4:sw=4
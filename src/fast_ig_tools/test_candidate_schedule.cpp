@@ -0,0 +1,106 @@
+#include <gmock/gmock.h>
+
+#include <random>
+
+#include "ig_matcher.hpp"
+
+seqan::Dna5String random_read(size_t length, std::mt19937 &rnd) {
+    seqan::Dna5String read;
+    for (size_t i = 0; i < length; ++i) {
+        seqan::appendValue(read, seqan::Dna5(rnd() % 4));
+    }
+    return read;
+}
+
+// reads of a public clonotype share k-mers and are much heavier than unique reads
+std::vector<seqan::Dna5String> clonotype_reads(std::mt19937 &rnd) {
+    std::vector<seqan::Dna5String> reads;
+    seqan::Dna5String clonotype = random_read(100, rnd);
+    for (size_t i = 0; i < 20; ++i) {
+        seqan::Dna5String read = clonotype;
+        read[rnd() % seqan::length(read)] = seqan::Dna5(rnd() % 5);
+        reads.push_back(read);
+    }
+    for (size_t i = 0; i < 100; ++i) {
+        reads.push_back(random_read(60 + rnd() % 40, rnd));
+    }
+    return reads;
+}
+
+// merge of posting lists finds the same candidates as counting of hits, buffers are reused between reads
+TEST(candidate_schedule_tests, merged_candidates_are_consistent_with_hit_counting) {
+    std::mt19937 rnd(29);
+    auto reads = clonotype_reads(rnd);
+    const unsigned K = 10;
+    auto kmer2reads = kmerIndexConstruction(reads, K);
+    CandidateBuffers buffers;
+    std::vector<size_t> cand;
+    for (unsigned tau : {0u, 2u, 4u}) {
+        for (unsigned strategy : {1u, 2u, 3u}) {
+            for (const auto &read : reads) {
+                std::vector<const std::vector<size_t>*> postings(tau + strategy, nullptr);
+                select_candidate_kmers(read, kmer2reads, reads.size(), tau, K, strategy, postings.data(), buffers);
+                collect_candidates(postings.data(), reads.size(), tau, strategy, buffers, cand);
+
+                std::unordered_map<size_t, size_t> hits;
+                for (const auto *posting : postings) {
+                    if (posting) {
+                        for (size_t i : *posting) {
+                            ++hits[i];
+                        }
+                    }
+                }
+                std::vector<size_t> expected;
+                for (const auto &kv : hits) {
+                    if (kv.second >= strategy) {
+                        expected.push_back(kv.first);
+                    }
+                }
+                std::sort(expected.begin(), expected.end());
+                EXPECT_EQ(expected, cand) << "tau " << tau << ", strategy " << strategy;
+            }
+        }
+    }
+}
+
+// every candidate pair is visited exactly once, also when heavy reads are split into several tasks
+// and reads are processed by several chunks
+TEST(candidate_schedule_tests, every_candidate_is_visited_once) {
+    std::mt19937 rnd(23);
+    auto reads = clonotype_reads(rnd);
+    const unsigned K = 10;
+    const unsigned tau = 2;
+    auto kmer2reads = kmerIndexConstruction(reads, K);
+    for (unsigned strategy : {0u, 1u, 2u}) {
+        std::vector<std::pair<size_t, size_t>> expected;
+        for (size_t j = 0; j < reads.size(); ++j) {
+            for (size_t i : find_candidates(reads[j], kmer2reads, reads.size(), tau, K, strategy)) {
+                expected.push_back({ j, i });
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+
+        for (int num_threads : {1, 3}) {
+            for (size_t min_task_cost : {1, 1024}) {
+                for (size_t chunk_size : {7, 1 << 16}) {
+                    omp_set_num_threads(num_threads);
+                    std::vector<std::vector<std::pair<size_t, size_t>>> visited(num_threads);
+                    for_each_candidate(reads, kmer2reads, reads.size(), tau, K, strategy,
+                                       [&visited](size_t j, size_t i, size_t thread_id) {
+                        visited[thread_id].push_back({ j, i });
+                    }, nullptr, min_task_cost, chunk_size);
+
+                    std::vector<std::pair<size_t, size_t>> all_visited;
+                    for (const auto &pairs : visited) {
+                        all_visited.insert(all_visited.end(), pairs.cbegin(), pairs.cend());
+                    }
+                    std::sort(all_visited.begin(), all_visited.end());
+                    EXPECT_EQ(expected, all_visited) << "strategy " << strategy << ", threads " << num_threads
+                                                     << ", chunk size " << chunk_size;
+                }
+            }
+        }
+    }
+}
+
+// vim: ts=4:sw=4
@@ -0,0 +1,58 @@
+#include <gmock/gmock.h>
+
+#include <fstream>
+#include <random>
+#include <sstream>
+
+#include <path_helper.hpp>
+
+#include "fast_ig_tools.hpp"
+#include "external_graph.hpp"
+
+std::string read_file(const std::string &filename) {
+    std::ifstream in(filename);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+// out-of-core graph should be written exactly like the graph constructed in memory by tauDistGraph
+TEST(external_graph_tests, merged_runs_are_consistent_with_in_memory_graph) {
+    std::string tmp_dir = path::make_temp_dir("/tmp", "external_graph_test");
+    std::mt19937 rnd(42);
+    for (size_t num_vertices : {1, 10, 300, 1000}) {
+        Graph graph(num_vertices);
+        // budget of 50 edges per thread makes many small runs, they are merged in several passes
+        ExternalEdgeRuns edge_runs(path::append_path(tmp_dir, "graph"), 100 * sizeof(ExternalEdge), 2);
+        std::vector<size_t> weights(num_vertices);
+        for (size_t i = 0; i < num_vertices; ++i) {
+            weights[i] = rnd() % 10 + 1;
+        }
+        for (size_t e = 0; e < num_vertices * 5; ++e) {
+            size_t from = rnd() % num_vertices;
+            size_t to = rnd() % num_vertices;
+            if (from == to) {
+                continue;
+            }
+            int dist = static_cast<int>(rnd() % 5);
+            graph[from].push_back({to, dist});
+            graph[to].push_back({from, dist});
+            edge_runs.AddUndirectedEdge(e % 2, from, to, dist);
+        }
+        for (auto &edges : graph) {
+            std::sort(edges.begin(), edges.end());
+            edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+        }
+
+        std::string expected_filename = path::append_path(tmp_dir, "expected.graph");
+        std::string filename = path::append_path(tmp_dir, "external.graph");
+        write_metis_graph(graph, weights, expected_filename);
+        size_t num_edges = edge_runs.WriteMetisGraph(num_vertices, filename, weights);
+        EXPECT_EQ(numEdges(graph), num_edges);
+        EXPECT_EQ(read_file(expected_filename), read_file(filename));
+        EXPECT_EQ(0u, edge_runs.NumRuns());
+    }
+    path::remove_dir(tmp_dir);
+}
+
+// vim: ts=4:sw=4
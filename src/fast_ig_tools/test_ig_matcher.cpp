@@ -0,0 +1,48 @@
+#include <gmock/gmock.h>
+
+#include <random>
+
+#include "ig_matcher.hpp"
+
+seqan::Dna5String random_read(size_t length, std::mt19937 &rnd) {
+    seqan::Dna5String read;
+    for (size_t i = 0; i < length; ++i) {
+        seqan::appendValue(read, seqan::Dna5(rnd() % 4));
+    }
+    return read;
+}
+
+// reads sharing Ns are close by Hamming distance, so k-mers containing N should not be chosen instead of indexed ones
+TEST(ig_matcher_tests, reads_with_ns_are_candidates) {
+    std::mt19937 rnd(37);
+    std::vector<seqan::Dna5String> reads;
+    for (size_t c = 0; c < 3; ++c) {
+        seqan::Dna5String clonotype = random_read(100, rnd);
+        clonotype[15] = 'N';
+        clonotype[45] = 'N';
+        for (size_t i = 0; i < 15; ++i) {
+            seqan::Dna5String read = seqan::prefix(clonotype, 64 + rnd() % 37);
+            for (size_t e = rnd() % 3; e > 0; --e) {
+                read[rnd() % seqan::length(read)] = seqan::Dna5(rnd() % 4);
+            }
+            reads.push_back(read);
+        }
+    }
+
+    const unsigned K = 10;
+    auto kmer2reads = kmerIndexConstruction(reads, K);
+    auto dist_fun = [&reads](size_t j, size_t i) -> unsigned {
+        return static_cast<unsigned>(hamming_rtrim(reads[j], reads[i]));
+    };
+    for (unsigned tau : {1u, 2u}) {
+        size_t num_of_dist_computations;
+        Graph naive_graph = tauDistGraph(reads, kmer2reads, dist_fun, tau, K, 0, num_of_dist_computations);
+        ASSERT_GT(numEdges(naive_graph), 0u);
+        for (unsigned strategy : {1u, 2u}) {
+            Graph graph = tauDistGraph(reads, kmer2reads, dist_fun, tau, K, strategy, num_of_dist_computations);
+            EXPECT_EQ(naive_graph, graph) << "tau " << tau << ", strategy " << strategy;
+        }
+    }
+}
+
+// vim: ts=4:sw=4
@@ -0,0 +1,73 @@
+#include <gmock/gmock.h>
+
+#include <limits>
+#include <random>
+
+#include "banded_half_smith_waterman.hpp"
+#include "packed_hamming.hpp"
+
+// pairs of similar reads of different lengths with Ns
+std::vector<seqan::Dna5String> random_reads(size_t num_reads, std::mt19937 &rnd) {
+    std::vector<seqan::Dna5String> reads;
+    seqan::Dna5String base;
+    for (size_t i = 0; i < 700; ++i) {
+        seqan::appendValue(base, seqan::Dna5(rnd() % 4));
+    }
+    for (size_t i = 0; i < num_reads; ++i) {
+        size_t length = rnd() % 2 ? rnd() % 700 : 256 + rnd() % 3 * 64;
+        seqan::Dna5String read = seqan::prefix(base, length);
+        size_t num_errors = rnd() % 8;
+        for (size_t j = 0; j < num_errors && length > 0; ++j) {
+            read[rnd() % length] = seqan::Dna5(rnd() % 5);
+        }
+        reads.push_back(read);
+    }
+    return reads;
+}
+
+// packed distance coincides with half_hamming unless it exceeds tau
+TEST(packed_hamming_tests, packed_distance_is_consistent_with_half_hamming) {
+    std::mt19937 rnd(13);
+    auto reads = random_reads(60, rnd);
+    PackedReads packed_reads(reads);
+    for (unsigned tau : {0u, 1u, 3u, 10u, 1000u}) {
+        for (bool ignore_tails : {false, true}) {
+            auto lizard_tail = [tau, ignore_tails](int l) -> int {
+                return ignore_tails ? 0 : -(l != 0) * 2 * static_cast<int>(tau);
+            };
+            for (size_t i = 0; i < reads.size(); ++i) {
+                for (size_t j = 0; j < reads.size(); ++j) {
+                    int dist = -half_hamming(reads[i], reads[j], 0, -1, lizard_tail);
+                    int packed_dist = packed_half_hamming(packed_reads[i], packed_reads[j], tau, lizard_tail);
+                    if (dist <= static_cast<int>(tau)) {
+                        ASSERT_EQ(dist, packed_dist);
+                    } else {
+                        ASSERT_GT(packed_dist, static_cast<int>(tau));
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(packed_hamming_tests, kernels_count_the_same_mismatches) {
+    std::mt19937 rnd(17);
+    auto reads = random_reads(40, rnd);
+    auto other_reads = random_reads(40, rnd);
+    PackedReads packed_reads(reads);
+    packed_reads.Add(other_reads);
+    ASSERT_EQ(reads.size() + other_reads.size(), packed_reads.size());
+    size_t max_mismatches = std::numeric_limits<size_t>::max();
+    for (size_t i = 0; i < reads.size(); ++i) {
+        for (size_t j = 0; j < other_reads.size(); ++j) {
+            size_t mismatches = static_cast<size_t>(-half_hamming(reads[i], other_reads[j], 0, -1,
+                                                                  [](int) { return 0; }));
+            PackedRead packed1 = packed_reads[i];
+            PackedRead packed2 = packed_reads[reads.size() + j];
+            ASSERT_EQ(mismatches, count_packed_mismatches(packed1, packed2, max_mismatches));
+            ASSERT_EQ(mismatches, count_packed_mismatches_portable(packed1, packed2, max_mismatches));
+        }
+    }
+}
+
+// vim: ts=4:sw=4
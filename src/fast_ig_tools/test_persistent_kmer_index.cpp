@@ -0,0 +1,111 @@
+#include <gmock/gmock.h>
+
+#include <fstream>
+#include <random>
+#include <sstream>
+
+#include <path_helper.hpp>
+
+#include "ig_matcher.hpp"
+
+std::string read_file(const std::string &filename) {
+    std::ifstream in(filename, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+// reads of several clonotypes with substitutions and Ns
+std::vector<seqan::Dna5String> random_reads(size_t num_reads, std::mt19937 &rnd) {
+    std::vector<seqan::Dna5String> clonotypes(5);
+    for (auto &clonotype : clonotypes) {
+        for (size_t i = 0; i < 120; ++i) {
+            seqan::appendValue(clonotype, seqan::Dna5(rnd() % 4));
+        }
+    }
+    std::vector<seqan::Dna5String> reads;
+    for (size_t i = 0; i < num_reads; ++i) {
+        seqan::Dna5String read = seqan::prefix(clonotypes[rnd() % clonotypes.size()], 90 + rnd() % 30);
+        size_t num_errors = rnd() % 5;
+        for (size_t j = 0; j < num_errors; ++j) {
+            read[rnd() % seqan::length(read)] = seqan::Dna5(rnd() % 5);
+        }
+        reads.push_back(read);
+    }
+    return reads;
+}
+
+// appended graph and updated index coincide with ones constructed for all reads at once
+TEST(persistent_kmer_index_tests, appended_graph_is_consistent_with_whole_graph) {
+    std::string tmp_dir = path::make_temp_dir("/tmp", "persistent_kmer_index_test");
+    std::mt19937 rnd(31);
+    const unsigned K = 10;
+    const unsigned tau = 3;
+    for (unsigned strategy : {0u, 1u, 3u}) {
+        auto base_reads = random_reads(300, rnd);
+        auto new_reads = random_reads(100, rnd);
+        auto all_reads = base_reads;
+        all_reads.insert(all_reads.end(), new_reads.cbegin(), new_reads.cend());
+        // base reads precede new ones in all_reads, so the same indices are passed by all graph constructions
+        auto dist_fun = [&all_reads](size_t j, size_t i) -> unsigned {
+            return static_cast<unsigned>(hamming_rtrim(all_reads[j], all_reads[i]));
+        };
+
+        const KmerIndexParams params = { K, tau, strategy, 0, true };
+        size_t num_of_dist_computations;
+        auto all_kmer2reads = kmerIndexConstruction(all_reads, K);
+        KmerSelections all_selections;
+        Graph graph = tauDistGraph(all_reads, all_kmer2reads, dist_fun, tau, K, strategy, num_of_dist_computations,
+                                   &all_selections);
+        std::string all_index_filename = path::append_path(tmp_dir, "all.kidx");
+        write_kmer_index(all_index_filename, params, all_reads.size(), reads_checksum(all_reads), all_kmer2reads,
+                         all_selections.index);
+
+        auto base_kmer2reads = kmerIndexConstruction(base_reads, K);
+        KmerSelections base_selections;
+        Graph appended_graph = tauDistGraph(base_reads, base_kmer2reads, dist_fun, tau, K, strategy,
+                                            num_of_dist_computations, &base_selections);
+        std::string index_filename = path::append_path(tmp_dir, "graph.kidx");
+        write_kmer_index(index_filename, params, base_reads.size(), reads_checksum(base_reads), base_kmer2reads,
+                         base_selections.index);
+        {
+            PersistentKmerIndex base_index(index_filename);
+            ASSERT_EQ(base_reads.size(), base_index.NumReads());
+            ASSERT_EQ(reads_checksum(base_reads), base_index.ReadsChecksum());
+            ASSERT_EQ(0u, base_index.MaxIndels());
+            ASSERT_TRUE(base_index.IgnoreTails());
+            KmerIndex new_postings;
+            KmerIndex new_selections;
+            Graph new_graph = tauDistGraphAppend(base_reads, new_reads, base_index, dist_fun, tau, K, strategy,
+                                                 new_postings, new_selections, num_of_dist_computations);
+            appended_graph.resize(new_graph.size());
+            for (size_t i = 0; i < new_graph.size(); ++i) {
+                appended_graph[i].insert(appended_graph[i].end(), new_graph[i].cbegin(), new_graph[i].cend());
+            }
+            write_kmer_index(index_filename, params, all_reads.size(),
+                             reads_checksum(new_reads, base_index.ReadsChecksum()), new_postings, new_selections,
+                             &base_index);
+        }
+
+        EXPECT_EQ(graph, appended_graph) << "strategy " << strategy;
+        // reads are long enough to be covered by k-mers without N, so no edges are lost by k-mer filtering
+        Graph naive_graph = tauDistGraph(all_reads, all_kmer2reads, dist_fun, tau, K, 0, num_of_dist_computations);
+        EXPECT_EQ(naive_graph, appended_graph) << "strategy " << strategy;
+        // selections of base reads may differ in general, since multiplicities of k-mers grow,
+        // but postings are the same, so the rest of the index is compared
+        PersistentKmerIndex index(index_filename);
+        PersistentKmerIndex all_index(all_index_filename);
+        ASSERT_EQ(all_index.NumReads(), index.NumReads());
+        // checksum of appended reads is the checksum of concatenation
+        EXPECT_EQ(all_index.ReadsChecksum(), index.ReadsChecksum());
+        ASSERT_EQ(all_index.Postings().num_kmers, index.Postings().num_kmers);
+        for (const auto &kv : all_kmer2reads) {
+            auto list = index.Postings().Find(kv.first);
+            EXPECT_EQ(kv.second, std::vector<size_t>(list.first, list.second));
+        }
+        EXPECT_TRUE(index.Postings().Find(std::numeric_limits<uint64_t>::max()).first == nullptr);
+    }
+    path::remove_dir(tmp_dir);
+}
+
+// vim: ts=4:sw=4
@@ -66,6 +66,12 @@ public:
         Initialize(edges);
     }
 
+    // takes ready arrays of compressed rows, e.g., loaded from binary graph file
+    CrsMatrix(size_t N, vector<size_t> &&row_index, vector<size_t> &&col, vector<size_t> &&dist) :
+            N_(N), NZ_(col.size()), row_index_(std::move(row_index)), col_(std::move(col)), dist_(std::move(dist)) {
+        assert(row_index_.size() == N_ + 1 && dist_.size() == NZ_);
+    }
+
     const vector<size_t>& Dist() const { return dist_; }
 
     const vector<size_t>& RowIndex() const  { return row_index_; }
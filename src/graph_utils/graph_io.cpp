@@ -1,4 +1,6 @@
 #include <verify.hpp>
+#include <csr_graph_format.hpp>
+#include <io/mmapped_reader.hpp>
 #include "graph_io.hpp"
 #include "../ig_tools/utils/string_tools.hpp"
 
@@ -138,6 +140,78 @@ public:
     }
 };
 
+/*
+ * class BinaryGraphReader
+ *      takes as an input file in binary CSR format (see csr_graph_format.hpp)
+ *      maps it into memory and fills compressed rows of upper triangle of graph matrix directly
+ *      returns graph
+ */
+class BinaryGraphReader {
+public:
+    SparseGraphPtr ReadGraph(const std::string &graph_filename) {
+        MMappedReader reader(graph_filename, false, size_t(-1));
+        const char *data = static_cast<const char*>(reader.data());
+        size_t size = reader.size();
+        VERIFY_MSG(size >= sizeof(csr_graph::Header) && csr_graph::HasMagic(data, size),
+                   graph_filename << " is not a binary CSR graph");
+        csr_graph::Header header;
+        memcpy(&header, data, sizeof(header));
+        VERIFY_MSG(header.version == csr_graph::version,
+                   "Binary CSR graph " << graph_filename << " has unsupported version");
+        // every section fits into the file, so sizes of sections are bounded by the file size
+        // and their sum in csr_graph::Sections cannot overflow
+        VERIFY_MSG(header.num_vertices < size / sizeof(uint64_t) && header.num_entries <= size / sizeof(uint32_t),
+                   "Binary CSR graph " << graph_filename << " is truncated");
+        csr_graph::Sections sections(header);
+        VERIFY_MSG(size >= sections.file_size, "Binary CSR graph " << graph_filename << " is truncated");
+
+        const uint64_t *offsets = reinterpret_cast<const uint64_t*>(data + sections.offsets);
+        const uint32_t *neighbours = reinterpret_cast<const uint32_t*>(data + sections.neighbours);
+        const int32_t *edge_weights = reinterpret_cast<const int32_t*>(data + sections.edge_weights);
+        size_t num_vertices = header.num_vertices;
+        VERIFY_MSG(offsets[0] == 0 && offsets[num_vertices] == header.num_entries,
+                   "Row offsets of binary CSR graph " << graph_filename << " do not match the number of entries");
+        for(size_t i = 0; i < num_vertices; i++)
+            VERIFY_MSG(offsets[i] <= offsets[i + 1],
+                       "Row offsets of binary CSR graph " << graph_filename << " decrease at vertex " << i);
+        // like text readers, only edges to vertices with greater indices are kept in the direct matrix
+        vector<size_t> row_index;
+        vector<size_t> col;
+        vector<size_t> dist;
+        row_index.reserve(num_vertices + 1);
+        col.reserve(header.num_entries / 2);
+        dist.reserve(header.num_entries / 2);
+        row_index.push_back(0);
+        for(size_t i = 0; i < num_vertices; i++) {
+            for(size_t j = offsets[i]; j < offsets[i + 1]; j++) {
+                VERIFY_MSG(neighbours[j] < num_vertices, "Vertex " << i << " of binary CSR graph " <<
+                           graph_filename << " has missing neighbour " << neighbours[j]);
+                if(i < neighbours[j]) {
+                    col.push_back(neighbours[j]);
+                    dist.push_back(size_t(edge_weights[j]));
+                }
+            }
+            row_index.push_back(col.size());
+        }
+        vector<size_t> weight(num_vertices, 1);
+        if(header.flags & csr_graph::vertex_weights_flag) {
+            const uint64_t *vertex_weights = reinterpret_cast<const uint64_t*>(data + sections.vertex_weights);
+            weight.assign(vertex_weights, vertex_weights + num_vertices);
+        }
+        CrsMatrixPtr direct_matrix(new CrsMatrix(num_vertices, std::move(row_index), std::move(col), std::move(dist)));
+        return SparseGraphPtr(new SparseGraph(direct_matrix, weight));
+    }
+};
+
+bool GraphIsBinary(std::ifstream &graph_stream) {
+    char data[sizeof(csr_graph::magic)];
+    graph_stream.read(data, sizeof(data));
+    bool is_binary = csr_graph::HasMagic(data, size_t(graph_stream.gcount()));
+    graph_stream.clear();
+    graph_stream.seekg(0);
+    return is_binary;
+}
+
 /*
  *
  */
@@ -199,7 +273,13 @@ SparseGraphPtr GraphReader::CreateGraph() {
         WARN("File " + this->graph_filename + " with graph was not found");
         return SparseGraphPtr(NULL);
     }
-    SparseGraphPtr graph_ptr = VersatileGraphReader().ReadGraph(graph_stream);
+    SparseGraphPtr graph_ptr;
+    if(GraphIsBinary(graph_stream)) {
+        TRACE("Binary CSR graph reader was chosen");
+        graph_ptr = BinaryGraphReader().ReadGraph(graph_filename);
+    }
+    else
+        graph_ptr = VersatileGraphReader().ReadGraph(graph_stream);
     TRACE("Extracted graph contains " << graph_ptr->N() << " vertices & " << graph_ptr->NZ() << " edges");
     return graph_ptr;
 }
\ No newline at end of file
@@ -20,15 +20,19 @@ private:
     GraphComponentMap component_map_;
 
 public:
-    SparseGraph(size_t N, const vector<GraphEdge> &edges, const vector<size_t>& weight) :
-            direct_matrix_(new CrsMatrix(N, edges)), weight_(weight) {
+    // direct matrix contains upper triangle of graph matrix
+    SparseGraph(CrsMatrixPtr direct_matrix, const vector<size_t>& weight) :
+            direct_matrix_(direct_matrix), weight_(weight) {
         trans_matrix_ = direct_matrix_->Transpose();
-        vertex_.reserve(N);
-        for (size_t i = 0; i < N; i++) {
+        vertex_.reserve(N());
+        for (size_t i = 0; i < N(); i++) {
             vertex_.push_back(Vertex(*this, i));
         }
     }
 
+    SparseGraph(size_t N, const vector<GraphEdge> &edges, const vector<size_t>& weight) :
+            SparseGraph(CrsMatrixPtr(new CrsMatrix(N, edges)), weight) {}
+
     SparseGraph(size_t N, const vector<GraphEdge> &edges) : SparseGraph(N, edges, vector<size_t>(N, 1)) {}
 
     size_t N() const { return direct_matrix_->N(); }
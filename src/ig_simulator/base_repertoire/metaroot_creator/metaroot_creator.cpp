@@ -25,8 +25,10 @@ AbstractMetarootCreator::AbstractMetarootCreator(const MetarootSimulationParams&
     nucl_remover_p(get_nucleotides_remover(config.nucleotides_remover_params)),
     nucl_creator_p(get_nucleotides_creator(config.p_nucleotides_creator_params)),
     nucl_inserter_p(get_nucleotides_inserter(config.n_nucleotides_inserter_params)),
-    v_cdr_db(cdr_labeler::GermlineDbLabeler(db.front(), config.cdr_labeler_config.cdrs_params).ComputeLabeling()),
-    j_cdr_db(cdr_labeler::GermlineDbLabeler(db.back(),  config.cdr_labeler_config.cdrs_params).ComputeLabeling()),
+    v_cdr_db(cdr_labeler::GermlineDbLabeler(db.front(), config.cdr_labeler_config.cdrs_params,
+        config.cdr_labeler_config.vj_finder_config.algorithm_params.germline_params.cache_dir).ComputeLabeling()),
+    j_cdr_db(cdr_labeler::GermlineDbLabeler(db.back(),  config.cdr_labeler_config.cdrs_params,
+        config.cdr_labeler_config.vj_finder_config.algorithm_params.germline_params.cache_dir).ComputeLabeling()),
     productivity_checker()
 {
     VERIFY(db.size() >= 2);
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+
+// counting of heap allocations made via global operator new
+// allocations are counted only if IgReC was configured with -DIGREC_COUNT_ALLOCATIONS=ON,
+// otherwise counters always stay zero
+namespace allocation_counter {
+    bool Enabled();
+
+    // the number of allocations made by the calling thread since its start
+    size_t ThreadAllocations();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// Binary CSR container of weighted graphs written by ig_swgraph_construct and loaded by graph_utils.
+// Adjacency lists are stored like in METIS files: an undirected edge is present in lists of both its vertices.
+//
+// layout (numbers are stored in the host byte order, each section is padded to 8 bytes):
+//   header:          char magic[8], uint64 version, uint64 flags, uint64 num_vertices, uint64 num_edges,
+//                    uint64 num_entries
+//   row offsets:     uint64 offsets[num_vertices + 1], offsets[0] = 0, offsets[num_vertices] = num_entries
+//   neighbours:      uint32 neighbours[num_entries], 0-based ids of adjacent vertices
+//   edge weights:    int32 edge_weights[num_entries]
+//   vertex weights:  uint64 vertex_weights[num_vertices], present iff flags contain vertex_weights_flag
+// num_edges is the number of edges written to the header of METIS file, i.e., num_entries / 2 for undirected graphs
+namespace csr_graph {
+    const char magic[8] = {'I', 'G', 'C', 'S', 'R', 'G', 'P', 'H'};
+    const uint64_t version = 1;
+    const uint64_t vertex_weights_flag = 1;
+
+    struct Header {
+        char magic[8];
+        uint64_t version;
+        uint64_t flags;
+        uint64_t num_vertices;
+        uint64_t num_edges;
+        uint64_t num_entries;
+    };
+
+    inline size_t PaddedSize(size_t size) {
+        return (size + 7) / 8 * 8;
+    }
+
+    inline Header MakeHeader(size_t num_vertices, size_t num_edges, size_t num_entries, bool has_vertex_weights) {
+        Header header;
+        memcpy(header.magic, magic, sizeof(magic));
+        header.version = version;
+        header.flags = has_vertex_weights ? vertex_weights_flag : 0;
+        header.num_vertices = num_vertices;
+        header.num_edges = num_edges;
+        header.num_entries = num_entries;
+        return header;
+    }
+
+    inline bool HasMagic(const char *data, size_t size) {
+        return size >= sizeof(magic) && memcmp(data, magic, sizeof(magic)) == 0;
+    }
+
+    // positions of sections from the beginning of file
+    struct Sections {
+        size_t offsets;
+        size_t neighbours;
+        size_t edge_weights;
+        size_t vertex_weights;
+        size_t file_size;
+
+        explicit Sections(const Header &header) {
+            offsets = sizeof(Header);
+            neighbours = offsets + (header.num_vertices + 1) * sizeof(uint64_t);
+            edge_weights = neighbours + PaddedSize(header.num_entries * sizeof(uint32_t));
+            vertex_weights = edge_weights + PaddedSize(header.num_entries * sizeof(int32_t));
+            file_size = vertex_weights +
+                    ((header.flags & vertex_weights_flag) ? header.num_vertices * sizeof(uint64_t) : 0);
+        }
+    };
+}
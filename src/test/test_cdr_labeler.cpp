@@ -103,8 +103,10 @@ TEST_F(CDRLabelerTest, ReadCDRsAreIgBlastConsistent) {
     INFO("Labeled DB of J segments consists of " << labeled_j_db.size() << " records");
     INFO("Alignment against VJ germline segments");
     core::ReadArchive read_archive("test_dataset/cdr_labeler_minitest.fastq");
+    vj_finder::VJGermlineIndex germline_index(labeled_v_db, labeled_j_db,
+                                              config.vj_finder_config.algorithm_params.aligner_params);
     vj_finder::VJParallelProcessor processor(read_archive, config.vj_finder_config.algorithm_params,
-                                             labeled_v_db, labeled_j_db,
+                                             germline_index,
                                              config.run_params.num_threads);
     vj_finder::VJAlignmentInfo alignment_info = processor.Process();
     ReadCDRLabeler read_labeler(config.shm_params, v_labeling, j_labeling);
@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 
 #include "../algorithms/block_alignment/block_alignment_utils.hpp"
+#include "../algorithms/block_alignment/match_chaining.hpp"
+
+#include <random>
 
 using namespace algorithms;
 
@@ -16,3 +19,44 @@ TEST(block_chain_alignment_test, find_simple_gap_test) {
     EXPECT_EQ(0, find_simple_gap("", "A"));
     EXPECT_EQ(0, find_simple_gap("", "GACTGGTTGG"));
 }
+
+// sparse chaining should reproduce paths and scores of the quadratic longest path in DAG
+TEST(block_chain_alignment_test, sparse_chaining_test) {
+    std::mt19937 rnd(42);
+    typedef StaticBlockAlignmentScoring<12, 12, 12, 4, 1, 1, 0, 0> StaticScoring;
+    std::vector<BlockAlignmentScoringScheme> schemes = {StaticScoring::Scheme(),
+                                                        {12, 3, 5, 5, 2, 2, 1, 3}};
+    // chainer with compile-time scoring should coincide with the chainer with the same run-time scoring
+    BasicSparseMatchChainer<StaticScoring> static_chainer((StaticScoring()));
+    for(auto scheme = schemes.begin(); scheme != schemes.end(); scheme++) {
+        SparseMatchChainer chainer(*scheme);
+        auto has_edge = [&chainer](const Match &a, const Match &b) { return chainer.HasEdge(a, b); };
+        auto edge_weight = [&chainer](const Match &a, const Match &b) { return chainer.EdgeWeight(a, b); };
+        auto vertex_weight = [&chainer](const Match &m) { return chainer.VertexWeight(m); };
+        LongestPathWorkspace workspace;
+        for(size_t test = 0; test < 500; test++) {
+            // matches near a few diagonals with occasional ties of subject positions
+            std::vector<Match> matches(1 + rnd() % 60);
+            for(auto it = matches.begin(); it != matches.end(); it++) {
+                it->subject_pos = int(rnd() % 300);
+                it->read_pos = it->subject_pos + int(rnd() % 4) * 5 - 7 + int(rnd() % 3);
+                it->length = 5 + rnd() % 20;
+            }
+            std::stable_sort(matches.begin(), matches.end(), Match::less_subject_pos);
+            int expected_score = weighted_longest_path_in_DAG(matches, has_edge, edge_weight, vertex_weight,
+                                                              workspace);
+            int score = chainer.Chain(matches);
+            ASSERT_EQ(expected_score, score);
+            if(*scheme == StaticScoring::Scheme()) {
+                ASSERT_EQ(expected_score, static_chainer.Chain(matches));
+                ASSERT_EQ(chainer.Path().size(), static_chainer.Path().size());
+            }
+            ASSERT_EQ(workspace.path.size(), chainer.Path().size());
+            for(size_t i = 0; i < workspace.path.size(); i++) {
+                ASSERT_EQ(workspace.path[i].subject_pos, chainer.Path()[i].subject_pos);
+                ASSERT_EQ(workspace.path[i].read_pos, chainer.Path()[i].read_pos);
+                ASSERT_EQ(workspace.path[i].length, chainer.Path()[i].length);
+            }
+        }
+    }
+}
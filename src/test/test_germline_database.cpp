@@ -8,6 +8,12 @@
 #include <germline_utils/germline_databases/immune_gene_database.hpp>
 #include <germline_utils/germline_databases/chain_database.hpp>
 #include <germline_utils/germline_databases/custom_gene_database.hpp>
+#include <germline_utils/germline_db_generator.hpp>
+#include <path_helper.hpp>
+
+#include <fcntl.h>
+#include <fstream>
+#include <sys/stat.h>
 
 void create_console_logger() {
     using namespace logging;
@@ -103,3 +109,67 @@ TEST_F(GermlineDBTest, TestCustomVariableDbCorrectness) {
     ASSERT_EQ(custom_j_db.size(), 100);
     INFO("Custom database of " << custom_j_db.Segment() << " segments contains " << custom_j_db.size() << " records");
 }
+
+// test checks that DB restored from germline cache coincides with DB generated from FASTA files
+TEST_F(GermlineDBTest, TestCachedDbIsConsistentWithGeneratedDb) {
+    using namespace germline_utils;
+    std::string tmp_dir = path::make_temp_dir("/tmp", "germline_cache_test");
+    GermlineInput germline_input;
+    germline_input.ig_dir = "IG";
+    germline_input.tcr_dir = "TCR";
+    germline_input.germline_filenames_config = "configs/vj_finder/germline_files_config.txt";
+    GermlineParams germline_params;
+    germline_params.germline_dir = "data/germline";
+    germline_params.organism = "human";
+    germline_params.loci = "IG";
+    germline_params.pseudogenes = true;
+    CustomGeneDatabase generated_db = GermlineDbGenerator(germline_input, germline_params).GenerateVariableDb();
+    germline_params.cache_dir = path::append_path(tmp_dir, "cache");
+    // the first generator builds DB from FASTA files and saves it, the second one loads the saved bundle
+    CustomGeneDatabase saved_db = GermlineDbGenerator(germline_input, germline_params).GenerateVariableDb();
+    CustomGeneDatabase cached_db = GermlineDbGenerator(germline_input, germline_params).GenerateVariableDb();
+    ASSERT_EQ(generated_db.size(), saved_db.size());
+    ASSERT_EQ(generated_db.size(), cached_db.size());
+    ASSERT_EQ(generated_db.num_dbs(), cached_db.num_dbs());
+    for(size_t i = 0; i < generated_db.size(); i++) {
+        ASSERT_EQ(generated_db[i].GeneType(), cached_db[i].GeneType());
+        ASSERT_EQ(generated_db[i].id(), cached_db[i].id());
+        ASSERT_EQ(generated_db[i].ORF(), cached_db[i].ORF());
+        ASSERT_TRUE(generated_db[i].name() == cached_db[i].name());
+        ASSERT_TRUE(generated_db[i].seq() == cached_db[i].seq());
+        ASSERT_TRUE(generated_db[i].aa_seq() == cached_db[i].aa_seq());
+    }
+    path::remove_dir(tmp_dir);
+}
+
+// test checks that content of file is hashed again only if its size or mtime changed
+TEST_F(GermlineDBTest, TestFileContentHashUsesStamp) {
+    using namespace germline_utils;
+    std::string tmp_dir = path::make_temp_dir("/tmp", "germline_stamp_test");
+    std::string fname = path::append_path(tmp_dir, "genes.fa");
+    auto write_file = [&fname](std::string content) {
+        std::ofstream out(fname);
+        out << content;
+    };
+    auto content_hash = [](std::string content) {
+        ContentHasher hasher;
+        hasher.Update(content);
+        return hasher.Hash();
+    };
+    write_file(">gene\nACGT\n");
+    GermlineDbCache cache(path::append_path(tmp_dir, "cache"));
+    ASSERT_EQ(cache.FileContentHash(fname), content_hash(">gene\nACGT\n"));
+    ASSERT_EQ(GermlineDbCache("").FileContentHash(fname), content_hash(">gene\nACGT\n"));
+    // content of the same size with restored mtime is not read, so the hash of the stamp is returned
+    struct stat file_stat;
+    ASSERT_EQ(stat(fname.c_str(), &file_stat), 0);
+    write_file(">gene\nTTTT\n");
+    struct timespec times[2] = {file_stat.st_atim, file_stat.st_mtim};
+    ASSERT_EQ(utimensat(AT_FDCWD, fname.c_str(), times, 0), 0);
+    ASSERT_EQ(cache.FileContentHash(fname), content_hash(">gene\nACGT\n"));
+    // change of size invalidates the stamp
+    write_file(">gene\nACGTA\n");
+    ASSERT_EQ(cache.FileContentHash(fname), content_hash(">gene\nACGTA\n"));
+    ASSERT_EQ(cache.FileContentHash(fname), content_hash(">gene\nACGTA\n"));
+    path::remove_dir(tmp_dir);
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include "../algorithms/hashes/kmer_generator.hpp"
+
+#include <algorithm>
+#include <random>
+
+using namespace algorithms;
+
+// rolling encoder should produce the same codes as encoding of each window from scratch and skip windows with N
+TEST(kmer_generator_test, rolling_encoding_test) {
+    std::mt19937 rnd(42);
+    const std::string alphabet = "ACGTN";
+    for(size_t k : {1, 5, 13, 32}) {
+        for(size_t iteration = 0; iteration < 50; iteration++) {
+            seqan::Dna5String s;
+            size_t length = rnd() % 100;
+            for(size_t i = 0; i < length; i++)
+                seqan::appendValue(s, alphabet[rnd() % (iteration % 2 ? 5 : 4)]);
+            std::vector<EncodedKmer> expected;
+            for(size_t pos = 0; pos + k <= length; pos++) {
+                uint64_t code = 0;
+                bool has_n = false;
+                for(size_t i = pos; i < pos + k; i++) {
+                    has_n = has_n or unsigned(s[i]) > 3;
+                    code = code * 4 + unsigned(s[i]);
+                }
+                if(!has_n)
+                    expected.push_back({code, pos});
+            }
+            size_t num_kmers = 0;
+            for(const EncodedKmer &kmer : Kmers(s, k)) {
+                ASSERT_LT(num_kmers, expected.size());
+                ASSERT_EQ(expected[num_kmers].code, kmer.code);
+                ASSERT_EQ(expected[num_kmers].pos, kmer.pos);
+                num_kmers++;
+            }
+            ASSERT_EQ(expected.size(), num_kmers);
+        }
+    }
+}
+
+TEST(kmer_generator_test, minimizer_sampling_test) {
+    std::mt19937 rnd(42);
+    const std::string alphabet = "ACGT";
+    MinimizerQueue queue;
+    for(size_t k : {5, 7}) {
+        for(size_t w : {1, 3, 5}) {
+            for(size_t iteration = 0; iteration < 50; iteration++) {
+                seqan::Dna5String s;
+                size_t length = rnd() % 100;
+                for(size_t i = 0; i < length; i++)
+                    seqan::appendValue(s, alphabet[rnd() % 4]);
+                std::vector<EncodedKmer> kmers(Kmers(s, k).begin(), Kmers(s, k).end());
+                std::vector<EncodedKmer> minimizers;
+                ForEachMinimizer(s, length, k, w, [&minimizers](uint64_t code, size_t pos) {
+                    minimizers.push_back({code, pos});
+                });
+                // workspace shared by all iterations gives the same minimizers
+                std::vector<EncodedKmer> reused_queue_minimizers;
+                ForEachMinimizer(s, 0, length, k, w, queue, [&reused_queue_minimizers](uint64_t code, size_t pos) {
+                    reused_queue_minimizers.push_back({code, pos});
+                });
+                ASSERT_EQ(minimizers.size(), reused_queue_minimizers.size());
+                if(w == 1) {
+                    ASSERT_EQ(kmers.size(), minimizers.size());
+                }
+                ASSERT_EQ(kmers.empty(), minimizers.empty());
+                for(size_t i = 0; i < minimizers.size(); i++) {
+                    ASSERT_EQ(kmers[minimizers[i].pos].code, minimizers[i].code);
+                    ASSERT_EQ(minimizers[i].pos, reused_queue_minimizers[i].pos);
+                    if(i > 0) {
+                        ASSERT_LT(minimizers[i - 1].pos, minimizers[i].pos);
+                    }
+                }
+                // every window of w consecutive k-mers contains its minimal k-mer, and it is reported
+                for(size_t start = 0; start + w <= kmers.size(); start++) {
+                    size_t min_pos = start;
+                    for(size_t pos = start; pos < start + w; pos++)
+                        if(MinimizerOrder(kmers[pos].code) < MinimizerOrder(kmers[min_pos].code))
+                            min_pos = pos;
+                    auto it = std::find_if(minimizers.begin(), minimizers.end(),
+                                           [min_pos](const EncodedKmer &kmer) { return kmer.pos == min_pos; });
+                    ASSERT_TRUE(it != minimizers.end());
+                }
+            }
+        }
+    }
+}
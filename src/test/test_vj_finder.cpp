@@ -1,12 +1,18 @@
 #include <gtest/gtest.h>
 #include <logger/log_writers.hpp>
 
+#include <memory>
 #include <sstream>
 
 #include <cdr_config.hpp>
 #include <germline_utils/germline_db_generator.hpp>
 #include <vj_parallel_processor.hpp>
+#include <vj_streaming_processor.hpp>
+#include <vj_batch_aligner.hpp>
+#include <vj_binary_alignment_info.hpp>
+#include <immune_gene_alignment_converter.hpp>
 #include <convert.hpp>
+#include <path_helper.hpp>
 
 void create_console_logger() {
     using namespace logging;
@@ -21,7 +27,23 @@ vj_finder::VJAlignmentInfo alignment_info;
 
 class VJFinderTest : public ::testing::Test {
 public:
+    std::unique_ptr<germline_utils::CustomGeneDatabase> v_gene_database;
+    std::unique_ptr<germline_utils::CustomGeneDatabase> j_gene_database;
+    std::unique_ptr<vj_finder::VJGermlineIndex> germline_index;
+
+    static void SetUpTestCase() {
+        create_console_logger();
+    }
+
+    // config is loaded before every test, since tests change algorithm parameters
     void SetUp() {
+        vj_finder::load(vj_finder_config, "configs/vj_finder/config.info");
+        germline_utils::GermlineDbGenerator db_generator(vj_finder_config.io_params.input_params.germline_input,
+                                                         vj_finder_config.algorithm_params.germline_params);
+        v_gene_database.reset(new germline_utils::CustomGeneDatabase(db_generator.GenerateVariableDb()));
+        j_gene_database.reset(new germline_utils::CustomGeneDatabase(db_generator.GenerateJoinDb()));
+        germline_index.reset(new vj_finder::VJGermlineIndex(*v_gene_database, *j_gene_database,
+                                                            vj_finder_config.algorithm_params.aligner_params));
     }
 };
 
@@ -99,20 +121,12 @@ void TestReadLeftRightFilling() {
 }
 
 TEST_F(VJFinderTest, BaseVJFinderTest) {
-    create_console_logger();
-    std::string config_fname = "configs/vj_finder/config.info";
-    vj_finder::load(vj_finder_config, config_fname);
     vj_finder_config.algorithm_params.fix_crop_fill_params.fill_right = true;
     vj_finder_config.algorithm_params.fix_crop_fill_params.fix_right = 3;
     read_archive.ExtractFromFile("test_dataset/vj_finder_test.fastq");
-    germline_utils::GermlineDbGenerator db_generator(vj_finder_config.io_params.input_params.germline_input,
-                                                     vj_finder_config.algorithm_params.germline_params);
-    auto v_gene_database = db_generator.GenerateVariableDb();
-    auto j_gene_database = db_generator.GenerateJoinDb();
     vj_finder::VJParallelProcessor processor(read_archive,
                                                 vj_finder_config.algorithm_params,
-                                                v_gene_database,
-                                                j_gene_database,
+                                                *germline_index,
                                                 vj_finder_config.run_params.num_threads);
     alignment_info = processor.Process();
 
@@ -125,3 +139,227 @@ TEST_F(VJFinderTest, BaseVJFinderTest) {
     TestReadLeftRightCropping();
     TestReadLeftRightFilling();
 }
+
+// alignments constructed from CIGAR should have the same characteristics as alignments computed from seqan rows
+TEST_F(VJFinderTest, CigarAlignmentIsConsistentWithSeqanAlignment) {
+    core::ReadArchive local_read_archive("test_dataset/vj_finder_test.fastq");
+    vj_finder::VJParallelProcessor processor(local_read_archive, vj_finder_config.algorithm_params,
+                                             *germline_index, 1);
+    vj_finder::VJAlignmentInfo local_alignment_info = processor.Process();
+    ASSERT_GT(local_alignment_info.NumVJHits(), 0);
+    vj_finder::ImmuneGeneAlignmentConverter converter;
+    for(size_t i = 0; i < local_alignment_info.NumVJHits(); i++) {
+        const vj_finder::VJHits &vj_hits = local_alignment_info.GetVJHitsByIndex(i);
+        std::vector<algorithms::PairwiseBlockAlignment> block_alignments = {
+                vj_hits.GetVHitByIndex(0).BlockAlignment(), vj_hits.GetJHitByIndex(0).BlockAlignment()};
+        std::vector<const germline_utils::ImmuneGene*> genes = {&vj_hits.GetVHitByIndex(0).ImmuneGene(),
+                                                                &vj_hits.GetJHitByIndex(0).ImmuneGene()};
+        for(size_t j = 0; j < block_alignments.size(); j++) {
+            auto cigar_alignment = converter.ConvertToAlignment(*genes[j], vj_hits.Read(), block_alignments[j]);
+            alignment_utils::ImmuneGeneReadAlignment seqan_alignment(*genes[j], vj_hits.Read(),
+                                                                     cigar_alignment.Alignment(),
+                                                                     cigar_alignment.Score());
+            ASSERT_FALSE(cigar_alignment.Cigar().Empty());
+            ASSERT_EQ(cigar_alignment.Cigar().NumColumns(), seqan_alignment.AlignmentLength());
+            ASSERT_EQ(cigar_alignment.AlignmentLength(), seqan_alignment.AlignmentLength());
+            ASSERT_EQ(cigar_alignment.SubjectAlignmentLength(), seqan_alignment.SubjectAlignmentLength());
+            ASSERT_EQ(cigar_alignment.QueryAlignmentLength(), seqan_alignment.QueryAlignmentLength());
+            ASSERT_EQ(cigar_alignment.RealStartAlignmentPos(), seqan_alignment.RealStartAlignmentPos());
+            ASSERT_EQ(cigar_alignment.RealEndAlignmentPos(), seqan_alignment.RealEndAlignmentPos());
+            ASSERT_EQ(cigar_alignment.NumberGaps(), seqan_alignment.NumberGaps());
+            ASSERT_EQ(cigar_alignment.NumberMatches(), seqan_alignment.NumberMatches());
+            ASSERT_EQ(cigar_alignment.NumberMismatches(), seqan_alignment.NumberMismatches());
+            ASSERT_EQ(cigar_alignment.NormalizedScore(), seqan_alignment.NormalizedScore());
+        }
+    }
+}
+
+// k-mer matches resolved by batched lookup should coincide with matches of single queries
+TEST_F(VJFinderTest, BatchedKmerLookupIsConsistentWithSingleQueries) {
+    const auto &v_index = germline_index->VIndex();
+    core::ReadArchive local_read_archive("test_dataset/vj_finder_test.fastq");
+    std::vector<const seqan::Dna5String*> queries;
+    for(auto it = local_read_archive.cbegin(); it != local_read_archive.cend(); it++)
+        queries.push_back(&it->seq);
+    algorithms::KmerLookupBatch batch;
+    v_index.LookupQueries(queries.data(), queries.size(), batch);
+    ASSERT_EQ(batch.NumQueries(), queries.size());
+    algorithms::SubjectKmerMatches batch_matches(v_index.NumSubjects());
+    for(size_t i = 0; i < queries.size(); i++) {
+        auto single_matches = v_index.GetSubjectKmerMatchesForQuery(*queries[i]);
+        batch.FillSubjectKmerMatches(i, batch_matches);
+        ASSERT_EQ(batch.NumKmerHits(i), v_index.NumKmerHits(*queries[i]));
+        ASSERT_EQ(single_matches.MatchedSubjects(), batch_matches.MatchedSubjects());
+        for(size_t j = 0; j < v_index.NumSubjects(); j++) {
+            ASSERT_EQ(single_matches[j].size(), batch_matches[j].size());
+            for(size_t m = 0; m < single_matches[j].size(); m++) {
+                ASSERT_EQ(single_matches[j][m].needle_pos, batch_matches[j][m].needle_pos);
+                ASSERT_EQ(single_matches[j][m].read_pos, batch_matches[j][m].read_pos);
+            }
+        }
+    }
+}
+
+std::string ReadFileContent(std::string fname) {
+    std::ifstream in(fname);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+vj_finder::VJFinderConfig::IOParams::OutputParams CreateOutputParams(std::string output_dir) {
+    auto output_params = vj_finder_config.io_params.output_params;
+    output_params.output_files.output_dir = output_dir;
+    vj_finder::update_output_files_config(output_params.output_files);
+    return output_params;
+}
+
+void OutputAlignmentInfo(const vj_finder::VJFinderConfig::IOParams::OutputParams &output_params,
+                         const vj_finder::VJAlignmentInfo &alignment_info) {
+    path::make_dir(output_params.output_files.output_dir);
+    vj_finder::VJAlignmentOutput output(output_params, alignment_info);
+    output.OutputAlignmentInfo();
+    output.OutputCleanedReads();
+    output.OutputVAlignments();
+    output.OutputFilteredReads();
+    output.OutputFilteringInfo();
+}
+
+TEST_F(VJFinderTest, StreamingOutputIsConsistentWithInMemoryOutput) {
+    std::string input_reads = "test_dataset/vj_finder_test.fastq";
+    std::string tmp_dir = path::make_temp_dir("/tmp", "vjf_streaming_test");
+
+    auto in_memory_params = CreateOutputParams(path::append_path(tmp_dir, "in_memory"));
+    core::ReadArchive local_read_archive(input_reads);
+    vj_finder::VJParallelProcessor processor(local_read_archive, vj_finder_config.algorithm_params,
+                                             *germline_index, 2);
+    auto local_alignment_info = processor.Process();
+    OutputAlignmentInfo(in_memory_params, local_alignment_info);
+
+    auto streaming_params = CreateOutputParams(path::append_path(tmp_dir, "streaming"));
+    path::make_dir(streaming_params.output_files.output_dir);
+    vj_finder::VJStreamingProcessor streaming_processor(input_reads, vj_finder_config.algorithm_params,
+                                                        *germline_index, 2, 2, false);
+    vj_finder::VJStreamingOutput streaming_output(streaming_params);
+    streaming_processor.Process(streaming_output);
+    streaming_output.Close();
+
+    ASSERT_EQ(streaming_processor.NumVJHits(), local_alignment_info.NumVJHits());
+    ASSERT_EQ(streaming_processor.NumFilteredReads(), local_alignment_info.NumFilteredReads());
+    ASSERT_EQ(ReadFileContent(in_memory_params.output_files.alignment_info_fname),
+              ReadFileContent(streaming_params.output_files.alignment_info_fname));
+    ASSERT_EQ(ReadFileContent(in_memory_params.output_files.cleaned_reads_fname),
+              ReadFileContent(streaming_params.output_files.cleaned_reads_fname));
+    ASSERT_EQ(ReadFileContent(in_memory_params.output_files.valignments_filename),
+              ReadFileContent(streaming_params.output_files.valignments_filename));
+    ASSERT_EQ(ReadFileContent(in_memory_params.output_files.filtering_info_filename),
+              ReadFileContent(streaming_params.output_files.filtering_info_filename));
+    path::remove_dir(tmp_dir);
+}
+
+TEST_F(VJFinderTest, BinaryAlignmentInfoIsConsistentWithTsv) {
+    std::string input_reads = "test_dataset/vj_finder_test.fastq";
+    std::string tmp_dir = path::make_temp_dir("/tmp", "vjf_binary_test");
+
+    auto tsv_params = CreateOutputParams(path::append_path(tmp_dir, "tsv"));
+    core::ReadArchive local_read_archive(input_reads);
+    vj_finder::VJParallelProcessor processor(local_read_archive, vj_finder_config.algorithm_params,
+                                             *germline_index, 2);
+    auto local_alignment_info = processor.Process();
+    OutputAlignmentInfo(tsv_params, local_alignment_info);
+
+    // in-memory output consists of a single block, streaming output of chunk size 2 consists of several blocks
+    auto binary_params = CreateOutputParams(path::append_path(tmp_dir, "binary"));
+    binary_params.output_details.binary_alignment_info = true;
+    OutputAlignmentInfo(binary_params, local_alignment_info);
+    auto streaming_params = CreateOutputParams(path::append_path(tmp_dir, "streaming"));
+    streaming_params.output_details.binary_alignment_info = true;
+    path::make_dir(streaming_params.output_files.output_dir);
+    vj_finder::VJStreamingProcessor streaming_processor(input_reads, vj_finder_config.algorithm_params,
+                                                        *germline_index, 2, 2, false);
+    vj_finder::VJStreamingOutput streaming_output(streaming_params);
+    streaming_processor.Process(streaming_output);
+    streaming_output.Close();
+
+    std::vector<std::string> binary_files = {binary_params.output_files.binary_alignment_info_fname,
+                                             streaming_params.output_files.binary_alignment_info_fname};
+    for(auto it = binary_files.begin(); it != binary_files.end(); it++) {
+        vj_finder::VJBinaryAlignmentReader reader(*it);
+        ASSERT_EQ(reader.NumRows(), local_alignment_info.NumVJHits() + local_alignment_info.NumFilteredReads());
+        std::stringstream alignment_info_ss;
+        std::stringstream filtering_info_ss;
+        vj_finder::ConvertBinaryAlignmentInfoToTsv(reader, alignment_info_ss, filtering_info_ss);
+        ASSERT_EQ(ReadFileContent(tsv_params.output_files.alignment_info_fname), alignment_info_ss.str());
+        ASSERT_EQ(ReadFileContent(tsv_params.output_files.filtering_info_filename), filtering_info_ss.str());
+    }
+    path::remove_dir(tmp_dir);
+}
+
+TEST_F(VJFinderTest, DeduplicatedOutputIsConsistentWithOutputOfAllReads) {
+    std::string tmp_dir = path::make_temp_dir("/tmp", "vjf_deduplication_test");
+    // each read occurs three times
+    std::string input_reads = path::append_path(tmp_dir, "reads.fastq");
+    std::string reads_content = ReadFileContent("test_dataset/vj_finder_test.fastq");
+    std::ofstream(input_reads) << reads_content << reads_content << reads_content;
+
+    auto all_reads_params = CreateOutputParams(path::append_path(tmp_dir, "all_reads"));
+    vj_finder_config.algorithm_params.aligner_params.deduplicate_reads = false;
+    core::ReadArchive all_read_archive(input_reads);
+    vj_finder::VJParallelProcessor all_reads_processor(all_read_archive, vj_finder_config.algorithm_params,
+                                                       *germline_index, 2);
+    auto all_reads_info = all_reads_processor.Process();
+    OutputAlignmentInfo(all_reads_params, all_reads_info);
+
+    auto unique_reads_params = CreateOutputParams(path::append_path(tmp_dir, "unique_reads"));
+    vj_finder_config.algorithm_params.aligner_params.deduplicate_reads = true;
+    core::ReadArchive unique_read_archive(input_reads);
+    vj_finder::VJParallelProcessor unique_reads_processor(unique_read_archive, vj_finder_config.algorithm_params,
+                                                          *germline_index, 2);
+    auto unique_reads_info = unique_reads_processor.Process();
+    OutputAlignmentInfo(unique_reads_params, unique_reads_info);
+
+    ASSERT_EQ(all_reads_info.NumVJHits(), unique_reads_info.NumVJHits());
+    ASSERT_EQ(all_reads_info.NumFilteredReads(), unique_reads_info.NumFilteredReads());
+    ASSERT_EQ(ReadFileContent(all_reads_params.output_files.alignment_info_fname),
+              ReadFileContent(unique_reads_params.output_files.alignment_info_fname));
+    ASSERT_EQ(ReadFileContent(all_reads_params.output_files.cleaned_reads_fname),
+              ReadFileContent(unique_reads_params.output_files.cleaned_reads_fname));
+    ASSERT_EQ(ReadFileContent(all_reads_params.output_files.valignments_filename),
+              ReadFileContent(unique_reads_params.output_files.valignments_filename));
+    ASSERT_EQ(ReadFileContent(all_reads_params.output_files.filtering_info_filename),
+              ReadFileContent(unique_reads_params.output_files.filtering_info_filename));
+    path::remove_dir(tmp_dir);
+}
+
+TEST_F(VJFinderTest, BatchAlignerIsConsistentWithParallelProcessor) {
+    core::ReadArchive local_read_archive("test_dataset/vj_finder_test.fastq");
+    std::vector<seqan::Dna5String> seqs;
+    for(auto it = local_read_archive.cbegin(); it != local_read_archive.cend(); it++)
+        seqs.push_back(it->seq);
+    vj_finder::VJParallelProcessor processor(local_read_archive, vj_finder_config.algorithm_params,
+                                             *germline_index, 2);
+    auto local_alignment_info = processor.Process();
+
+    vj_finder::VJBatchAligner batch_aligner(vj_finder_config.algorithm_params, *germline_index, 2);
+    // the same aligner is used for several batches
+    for(size_t batch = 0; batch < 2; batch++) {
+        size_t num_results = 0;
+        batch_aligner.Align(seqs, [&](size_t index, const vj_finder::ProcessedVJHits &processed_hits) {
+            ASSERT_EQ(index, num_results);
+            num_results++;
+            const core::Read &read = local_read_archive[index];
+            ASSERT_EQ(processed_hits.ReadToBeFiltered(), local_alignment_info.ReadIsFiltered(read));
+            ASSERT_EQ(core::seqan_string_to_string(processed_hits.read.seq), core::seqan_string_to_string(read.seq));
+            if(processed_hits.ReadToBeFiltered())
+                return;
+            const vj_finder::VJHits &vj_hits = local_alignment_info.GetVJHitsByRead(read);
+            ASSERT_EQ(processed_hits.vj_hits.NumVHits(), vj_hits.NumVHits());
+            ASSERT_EQ(core::seqan_string_to_string(processed_hits.vj_hits.GetVHitByIndex(0).ImmuneGene().name()),
+                      core::seqan_string_to_string(vj_hits.GetVHitByIndex(0).ImmuneGene().name()));
+            ASSERT_EQ(core::seqan_string_to_string(processed_hits.vj_hits.GetJHitByIndex(0).ImmuneGene().name()),
+                      core::seqan_string_to_string(vj_hits.GetJHitByIndex(0).ImmuneGene().name()));
+            ASSERT_EQ(processed_hits.vj_hits.GetVHitByIndex(0).Score(), vj_hits.GetVHitByIndex(0).Score());
+        });
+        ASSERT_EQ(num_results, seqs.size());
+    }
+}
@@ -394,7 +394,9 @@ namespace clusterer {
             auto kmer2reads = kmerIndexConstruction(all_halves, k);
             size_t num_of_dist_computations = 0;
             Graph& graph = (i == 0) ? left_graph : right_graph;
-            graph = tauDistGraph(all_halves, kmer2reads, ClusteringMode::bounded_edit_dist(tau, max_indels),
+            auto dist = ClusteringMode::bounded_edit_dist(tau, max_indels);
+            auto dist_fun = [&all_halves, &dist](size_t j, size_t i) { return dist(all_halves[j], all_halves[i]); };
+            graph = tauDistGraph(all_halves, kmer2reads, dist_fun,
                                  static_cast<unsigned>(tau), static_cast<unsigned>(k), static_cast<unsigned>(strategy),
                                  num_of_dist_computations);
             INFO("graph constructed: " << i << ", dist computed " << num_of_dist_computations << " times.");
@@ -0,0 +1,137 @@
+#include <verify.hpp>
+
+#include <sstream>
+
+#include "alignment_cigar.hpp"
+
+namespace alignment_utils {
+    void AlignmentCigar::Append(CigarOperation operation, size_t length) {
+        if(length == 0)
+            return;
+        if(!runs_.empty() and runs_.back().operation == operation) {
+            runs_.back().length += length;
+            return;
+        }
+        runs_.push_back({operation, length});
+    }
+
+    size_t AlignmentCigar::NumColumns() const {
+        size_t num_columns = 0;
+        for(auto it = runs_.cbegin(); it != runs_.cend(); it++)
+            if(it->operation != CigarOperation::SoftClip)
+                num_columns += it->length;
+        return num_columns;
+    }
+
+    std::string AlignmentCigar::ToString() const {
+        std::stringstream ss;
+        ss << *this;
+        return ss.str();
+    }
+
+    std::ostream& operator<<(std::ostream &out, const AlignmentCigar &cigar) {
+        const char op_chars[] = {'M', 'I', 'D', 'S'};
+        for(auto it = cigar.cbegin(); it != cigar.cend(); it++)
+            out << it->length << op_chars[static_cast<size_t>(it->operation)];
+        return out;
+    }
+
+    namespace {
+        size_t CountMatches(const seqan::Dna5 *subject, const seqan::Dna5 *query, size_t length) {
+            size_t num_matches = 0;
+            for(size_t i = 0; i < length; i++)
+                num_matches += subject[i].value == query[i].value;
+            return num_matches;
+        }
+    }
+
+    CigarAlignmentStats ComputeCigarAlignmentStats(const AlignmentCigar &cigar,
+                                                   const seqan::Dna5String &subject,
+                                                   const seqan::Dna5String &query) {
+        CigarAlignmentStats stats = {0, 0, 0, 0, 0, 0};
+        const seqan::Dna5 *subject_ptr = seqan::begin(subject, seqan::Standard());
+        const seqan::Dna5 *query_ptr = seqan::begin(query, seqan::Standard());
+        size_t subject_pos = 0;
+        size_t query_pos = 0;
+        bool has_aligned_columns = false;
+        for(auto it = cigar.cbegin(); it != cigar.cend(); it++) {
+            switch(it->operation) {
+                case CigarOperation::SoftClip:
+                    query_pos += it->length;
+                    break;
+                case CigarOperation::Insertion:
+                    query_pos += it->length;
+                    stats.num_gaps += it->length;
+                    stats.num_columns += it->length;
+                    break;
+                case CigarOperation::Deletion:
+                    subject_pos += it->length;
+                    stats.num_gaps += it->length;
+                    stats.num_columns += it->length;
+                    break;
+                case CigarOperation::Match: {
+                    VERIFY_MSG(subject_pos + it->length <= seqan::length(subject) and
+                               query_pos + it->length <= seqan::length(query), "CIGAR " << cigar <<
+                               " exceeds lengths of sequences");
+                    size_t num_matches = CountMatches(subject_ptr + subject_pos, query_ptr + query_pos, it->length);
+                    stats.num_matches += num_matches;
+                    stats.num_mismatches += it->length - num_matches;
+                    if(!has_aligned_columns)
+                        stats.first_aligned_column = stats.num_columns;
+                    has_aligned_columns = true;
+                    stats.num_columns += it->length;
+                    stats.last_aligned_column = stats.num_columns - 1;
+                    subject_pos += it->length;
+                    query_pos += it->length;
+                    break;
+                }
+            }
+        }
+        if(!has_aligned_columns) {
+            stats.first_aligned_column = stats.num_columns;
+            stats.last_aligned_column = stats.num_columns;
+        }
+        return stats;
+    }
+
+    void CigarToSeqanAlignment(const AlignmentCigar &cigar,
+                               const seqan::Dna5String &subject,
+                               const seqan::Dna5String &query,
+                               seqan::Align<seqan::Dna5String, seqan::ArrayGaps> &alignment) {
+        using TRow = seqan::Row<seqan::Align<seqan::Dna5String, seqan::ArrayGaps>>::Type;
+        seqan::resize(seqan::rows(alignment), 2);
+        seqan::assignSource(seqan::row(alignment, 0), subject);
+        seqan::assignSource(seqan::row(alignment, 1), query);
+        TRow &subject_row = seqan::row(alignment, 0);
+        TRow &query_row = seqan::row(alignment, 1);
+        size_t subject_pos = seqan::length(subject);
+        size_t query_pos = seqan::length(query);
+        const auto &runs = cigar.Runs();
+        for(size_t i = runs.size() - 1; i + 1 > 0; i--) {
+            size_t length = runs[i].length;
+            switch(runs[i].operation) {
+                case CigarOperation::SoftClip:
+                    VERIFY_MSG(i == 0 or i + 1 == runs.size(), "Soft clipping is not at the end of CIGAR " << cigar);
+                    query_pos -= length;
+                    if(i == 0)
+                        seqan::setBeginPosition(query_row, length);
+                    else
+                        seqan::setEndPosition(query_row, query_pos);
+                    break;
+                case CigarOperation::Insertion:
+                    query_pos -= length;
+                    seqan::insertGaps(subject_row, subject_pos, length);
+                    break;
+                case CigarOperation::Deletion:
+                    subject_pos -= length;
+                    seqan::insertGaps(query_row, query_pos, length);
+                    break;
+                case CigarOperation::Match:
+                    subject_pos -= length;
+                    query_pos -= length;
+                    break;
+            }
+        }
+        VERIFY_MSG(subject_pos == 0 and query_pos == 0, "CIGAR " << cigar << " does not cover subject and query");
+    }
+}
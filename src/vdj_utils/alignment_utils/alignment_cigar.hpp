@@ -0,0 +1,73 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <seqan/align.h>
+
+namespace alignment_utils {
+    enum class CigarOperation { Match, Insertion, Deletion, SoftClip };
+
+    // run of alignment columns with the same operation:
+    //   Match (M) - symbols of subject and query are aligned to each other (match or mismatch)
+    //   Insertion (I) - symbols of query are aligned to gaps in subject
+    //   Deletion (D) - symbols of subject are aligned to gaps in query
+    //   SoftClip (S) - symbols of query do not belong to alignment, it can be the first or the last run only
+    struct CigarRun {
+        CigarOperation operation;
+        size_t length;
+    };
+
+    // compact representation of alignment of query (e.g., read) against the whole subject (e.g., gene segment),
+    // it is converted into seqan alignment on demand
+    class AlignmentCigar {
+        std::vector<CigarRun> runs_;
+
+    public:
+        // runs of zero length are skipped, adjacent runs with the same operation are merged
+        void Append(CigarOperation operation, size_t length);
+
+        void Clear() { runs_.clear(); }
+
+        bool Empty() const { return runs_.empty(); }
+
+        const std::vector<CigarRun>& Runs() const { return runs_; }
+
+        typedef std::vector<CigarRun>::const_iterator CigarRunIterator;
+
+        CigarRunIterator cbegin() const { return runs_.cbegin(); }
+
+        CigarRunIterator cend() const { return runs_.cend(); }
+
+        // number of columns of alignment, i.e., total length of M, I and D runs
+        size_t NumColumns() const;
+
+        // e.g., 3S120M2D30M
+        std::string ToString() const;
+    };
+
+    std::ostream& operator<<(std::ostream &out, const AlignmentCigar &cigar);
+
+    // statistics of alignment columns, gaps are counted in both subject and query
+    struct CigarAlignmentStats {
+        size_t num_columns;
+        size_t num_matches;
+        size_t num_mismatches;
+        size_t num_gaps;
+        // the first and the last columns without gaps, num_columns if there are no such columns
+        size_t first_aligned_column;
+        size_t last_aligned_column;
+    };
+
+    // matches are counted over contiguous runs of subject and query, so the loop is vectorized by the compiler
+    CigarAlignmentStats ComputeCigarAlignmentStats(const AlignmentCigar &cigar,
+                                                   const seqan::Dna5String &subject,
+                                                   const seqan::Dna5String &query);
+
+    // gaps are inserted into rows in the reverse order of runs, so view positions coincide with source positions
+    void CigarToSeqanAlignment(const AlignmentCigar &cigar,
+                               const seqan::Dna5String &subject,
+                               const seqan::Dna5String &query,
+                               seqan::Align<seqan::Dna5String, seqan::ArrayGaps> &alignment);
+}
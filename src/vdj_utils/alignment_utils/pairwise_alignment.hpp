@@ -2,6 +2,7 @@
 
 #include <memory>
 #include "alignment_positions.hpp"
+#include "alignment_cigar.hpp"
 #include <seqan/align.h>
 #undef NDEBUG
 #include <cassert>
@@ -18,6 +19,8 @@ namespace alignment_utils {
         const QueryTypename* query_ptr_;
         //AlignmentPositions positions_; it is important to have alignment positions?
         seqan::Align<seqan::Dna5String, seqan::ArrayGaps> alignment_;
+        // empty if alignment was constructed from seqan alignment
+        AlignmentCigar cigar_;
 
         // computed characteristics
         // alignment_length_ is min of lens of subject_len and query_len
@@ -87,6 +90,20 @@ namespace alignment_utils {
                 }
         }
 
+        // the same characteristics as above are computed in one pass over runs of CIGAR
+        void ComputeCigarCharacteristics(const seqan::Dna5String &subject_seq, const seqan::Dna5String &query_seq) {
+            CigarAlignmentStats stats = ComputeCigarAlignmentStats(cigar_, subject_seq, query_seq);
+            subject_alignment_length_ = stats.num_columns;
+            query_alignment_length_ = stats.num_columns;
+            alignment_length_ = stats.num_columns;
+            real_start_alignment_pos_ = stats.first_aligned_column;
+            real_end_alignment_pos_ = stats.last_aligned_column;
+            num_gaps_ = stats.num_gaps;
+            num_matches_ = stats.num_matches;
+            num_mismatches_ = stats.num_mismatches;
+            num_shms_ = num_mismatches_ + num_gaps_;
+        }
+
         void ComputeNormalizedScore() {
             auto alignment_row = seqan::row(alignment_, 0);
             normalized_score_ = score_ / static_cast<double>(seqan::length(alignment_row));
@@ -139,6 +156,21 @@ namespace alignment_utils {
                 PairwiseAlignment(&subject, &query, alignment, score)
         { }
 
+        // subject_seq and query_seq are sequences of subject and query, seqan alignment is constructed from CIGAR
+        PairwiseAlignment(const SubjectTypename& subject,
+                          const QueryTypename& query,
+                          const seqan::Dna5String &subject_seq,
+                          const seqan::Dna5String &query_seq,
+                          AlignmentCigar cigar,
+                          double score) :
+                subject_ptr_(&subject), query_ptr_(&query), alignment_(), cigar_(std::move(cigar)),
+                num_gaps_(0), num_matches_(0), num_mismatches_(0), score_(score)
+        {
+            ComputeCigarCharacteristics(subject_seq, query_seq);
+            CigarToSeqanAlignment(cigar_, subject_seq, query_seq, alignment_);
+            ComputeNormalizedScore();
+        }
+
         PairwiseAlignment(const PairwiseAlignment&)            = default;
         PairwiseAlignment(PairwiseAlignment&&)                 = default;
         PairwiseAlignment& operator=(const PairwiseAlignment&) = default;
@@ -187,6 +219,8 @@ namespace alignment_utils {
 
         const DnaGappedAlignment& Alignment() const { return alignment_; }
 
+        const AlignmentCigar& Cigar() const { return cigar_; }
+
         size_t AlignmentLength() const { return alignment_length_; }
 
         size_t SubjectAlignmentLength() const { return subject_alignment_length_; }
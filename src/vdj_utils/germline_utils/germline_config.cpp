@@ -22,6 +22,7 @@ void load(GermlineParams &gp, boost::property_tree::ptree const &pt, bool) {
     load(gp.loci, pt, "loci");
     load(gp.organism, pt, "organism");
     load(gp.pseudogenes, pt, "pseudogenes");
+    load(gp.cache_dir, pt, "cache_dir", false);
 }
 
 
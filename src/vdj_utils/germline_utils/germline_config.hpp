@@ -20,6 +20,8 @@ struct GermlineParams {
     std::string organism;
     std::string loci;
     bool pseudogenes;
+    // directory of persistent germline DB bundles, empty string disables caching
+    std::string cache_dir;
 };
 
 
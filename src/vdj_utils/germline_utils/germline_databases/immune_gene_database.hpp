@@ -41,6 +41,20 @@ namespace germline_utils {
             ComputeAASeq();
         }
 
+        // creates gene with precomputed ORF and translation (e.g., restored from germline DB cache)
+        ImmuneGene(ImmuneGeneType gene_type,
+                   seqan::CharString gene_name,
+                   seqan::Dna5String gene_seq,
+                   size_t id,
+                   unsigned orf,
+                   seqan::String<seqan::AminoAcid> aa_seq) :
+                gene_type_(gene_type),
+                gene_name_(gene_name),
+                gene_seq_(gene_seq),
+                id_(id),
+                orf_(orf),
+                aa_seq_(aa_seq) { }
+
         void SetORF(unsigned orf);
 
         unsigned ORF() const { return orf_; }
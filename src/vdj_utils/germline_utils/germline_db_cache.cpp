@@ -0,0 +1,239 @@
+#include <verify.hpp>
+#include <logger/logger.hpp>
+#include <path_helper.hpp>
+#include <io/mmapped_reader.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "germline_db_cache.hpp"
+
+namespace germline_utils {
+    namespace {
+        const uint64_t fnv_offset_basis = 14695981039346656037ULL;
+        const uint64_t fnv_prime = 1099511628211ULL;
+        const size_t section_alignment = 8;
+
+        struct GeneRecordHeader {
+            uint64_t id;
+            uint32_t chain_type;
+            uint32_t orf;
+            uint32_t name_length;
+            uint32_t seq_length;
+            uint32_t aa_seq_length;
+            uint32_t padding;
+        };
+
+        size_t PaddedSize(size_t size) {
+            return (size + section_alignment - 1) / section_alignment * section_alignment;
+        }
+
+        template<typename T>
+        void AppendValue(std::string &buffer, const T &value) {
+            buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        void AppendPadding(std::string &buffer) {
+            buffer.append(PaddedSize(buffer.size()) - buffer.size(), '\0');
+        }
+
+        template<typename T>
+        T ExtractValue(const char *data, size_t &pos, size_t size) {
+            VERIFY_MSG(pos + sizeof(T) <= size, "Germline DB bundle is truncated");
+            T value;
+            memcpy(&value, data + pos, sizeof(T));
+            pos += sizeof(T);
+            return value;
+        }
+
+        // size and mtime of file and hash of its content
+        struct FileStamp {
+            uint64_t file_size;
+            int64_t mtime_sec;
+            int64_t mtime_nsec;
+            uint64_t content_hash;
+
+            bool SameFile(const FileStamp &stamp) const {
+                return file_size == stamp.file_size and mtime_sec == stamp.mtime_sec and
+                        mtime_nsec == stamp.mtime_nsec;
+            }
+        };
+
+        uint64_t HashFileContent(std::string fname) {
+            ContentHasher hasher;
+            hasher.UpdateFileContent(fname);
+            return hasher.Hash();
+        }
+
+        template<typename SeqType>
+        std::string SeqToString(const SeqType &seq) {
+            std::string str(seqan::length(seq), '\0');
+            for(size_t i = 0; i < str.size(); i++)
+                str[i] = char(seq[i]);
+            return str;
+        }
+    }
+
+    ContentHasher::ContentHasher() : hash_(fnv_offset_basis) { }
+
+    void ContentHasher::Update(const void *data, size_t size) {
+        const unsigned char *bytes = static_cast<const unsigned char*>(data);
+        for(size_t i = 0; i < size; i++) {
+            hash_ ^= bytes[i];
+            hash_ *= fnv_prime;
+        }
+    }
+
+    void ContentHasher::Update(const std::string &str) {
+        Update(uint64_t(str.size()));
+        Update(str.data(), str.size());
+    }
+
+    void ContentHasher::UpdateFileContent(std::string fname) {
+        path::CheckFileExistenceFATAL(fname);
+        std::ifstream fhandler(fname, std::ios::binary);
+        std::stringstream content;
+        content << fhandler.rdbuf();
+        Update(content.str());
+    }
+
+    const char GermlineDbCache::magic[8] = {'I', 'G', 'G', 'E', 'R', 'M', 'D', 'B'};
+    const char GermlineDbCache::stamp_magic[8] = {'I', 'G', 'F', 'S', 'T', 'A', 'M', 'P'};
+    const uint64_t GermlineDbCache::version;
+
+    std::string GermlineDbCache::BundleFname(std::string prefix, uint64_t key) const {
+        char key_str[17];
+        snprintf(key_str, sizeof(key_str), "%016llx", static_cast<unsigned long long>(key));
+        return path::append_path(cache_dir_, prefix + "_" + std::string(key_str) + ".bin");
+    }
+
+    std::string GermlineDbCache::DbBundleFname(SegmentType segment_type, uint64_t key) const {
+        std::stringstream prefix;
+        prefix << "germline_" << segment_type;
+        return BundleFname(prefix.str(), key);
+    }
+
+    std::string GermlineDbCache::StampFname(std::string full_path) const {
+        ContentHasher hasher;
+        hasher.Update(full_path);
+        return BundleFname("stamp", hasher.Hash());
+    }
+
+    uint64_t GermlineDbCache::FileContentHash(std::string fname) const {
+        path::CheckFileExistenceFATAL(fname);
+        if(!Enabled())
+            return HashFileContent(fname);
+        struct stat file_stat;
+        VERIFY_MSG(stat(fname.c_str(), &file_stat) == 0, "File " << fname << " cannot be accessed");
+        FileStamp stamp = {uint64_t(file_stat.st_size), int64_t(file_stat.st_mtim.tv_sec),
+                           int64_t(file_stat.st_mtim.tv_nsec), 0};
+        std::string full_path = fname;
+        path::make_full_path(full_path);
+        std::string stamp_fname = StampFname(full_path);
+        std::ifstream in(stamp_fname, std::ios::binary);
+        std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        // stamp of another version or of another file with the same hash of path is just overwritten
+        const char *data = content.data();
+        size_t size = content.size();
+        size_t header_size = sizeof(stamp_magic) + sizeof(uint64_t) + sizeof(FileStamp) + sizeof(uint64_t);
+        if(size >= header_size and memcmp(data, stamp_magic, sizeof(stamp_magic)) == 0) {
+            size_t pos = sizeof(stamp_magic);
+            uint64_t stamp_version = ExtractValue<uint64_t>(data, pos, size);
+            auto cached_stamp = ExtractValue<FileStamp>(data, pos, size);
+            uint64_t path_length = ExtractValue<uint64_t>(data, pos, size);
+            if(stamp_version == version and size - pos == path_length and
+                    full_path.compare(0, std::string::npos, data + pos, path_length) == 0 and
+                    cached_stamp.SameFile(stamp))
+                return cached_stamp.content_hash;
+        }
+        stamp.content_hash = HashFileContent(fname);
+        std::string buffer(stamp_magic, sizeof(stamp_magic));
+        AppendValue(buffer, version);
+        AppendValue(buffer, stamp);
+        AppendValue(buffer, uint64_t(full_path.size()));
+        buffer += full_path;
+        WriteBundle(stamp_fname, buffer);
+        return stamp.content_hash;
+    }
+
+    bool GermlineDbCache::LoadDb(uint64_t key, CustomGeneDatabase &db) const {
+        std::string fname = DbBundleFname(db.Segment(), key);
+        if(!path::FileExists(fname))
+            return false;
+        MMappedReader reader(fname, false, size_t(-1));
+        const char *data = static_cast<const char*>(reader.data());
+        size_t size = reader.size();
+        size_t pos = 0;
+        VERIFY_MSG(size >= sizeof(magic) and memcmp(data, magic, sizeof(magic)) == 0,
+                   fname << " is not a germline DB bundle");
+        pos += sizeof(magic);
+        VERIFY_MSG(ExtractValue<uint64_t>(data, pos, size) == version,
+                   "Germline DB bundle " << fname << " has unsupported version");
+        VERIFY_MSG(ExtractValue<uint64_t>(data, pos, size) == key, "Key of germline DB bundle " << fname <<
+                " does not match its name");
+        auto segment_type = static_cast<SegmentType>(ExtractValue<uint64_t>(data, pos, size));
+        VERIFY_MSG(segment_type == db.Segment(), "Germline DB bundle " << fname << " stores " << segment_type <<
+                " segments instead of " << db.Segment());
+        uint64_t num_genes = ExtractValue<uint64_t>(data, pos, size);
+        for(uint64_t i = 0; i < num_genes; i++) {
+            auto header = ExtractValue<GeneRecordHeader>(data, pos, size);
+            size_t record_size = size_t(header.name_length) + header.seq_length + header.aa_seq_length;
+            VERIFY_MSG(pos + record_size <= size, "Germline DB bundle " << fname << " is truncated");
+            const char *name = data + pos;
+            const char *seq = name + header.name_length;
+            const char *aa_seq = seq + header.seq_length;
+            db.AddImmuneGene(ImmuneGene(ImmuneGeneType(ChainType(ImmuneChainType(header.chain_type)),
+                                                       segment_type),
+                                        seqan::CharString(std::string(name, header.name_length)),
+                                        seqan::Dna5String(std::string(seq, header.seq_length)),
+                                        size_t(header.id),
+                                        header.orf,
+                                        seqan::String<seqan::AminoAcid>(std::string(aa_seq,
+                                                                                    header.aa_seq_length))));
+            pos += PaddedSize(record_size);
+        }
+        INFO(num_genes << " records were loaded from germline DB bundle " << fname);
+        return true;
+    }
+
+    void GermlineDbCache::SaveDb(uint64_t key, const CustomGeneDatabase &db) const {
+        std::string buffer(magic, sizeof(magic));
+        AppendValue(buffer, version);
+        AppendValue(buffer, key);
+        AppendValue(buffer, uint64_t(db.Segment()));
+        AppendValue(buffer, uint64_t(db.size()));
+        for(size_t i = 0; i < db.size(); i++) {
+            const ImmuneGene &gene = db[i];
+            std::string name(seqan::toCString(gene.name()));
+            std::string seq = SeqToString(gene.seq());
+            std::string aa_seq = SeqToString(gene.aa_seq());
+            GeneRecordHeader header = {uint64_t(gene.id()), uint32_t(gene.Chain().Chain()), uint32_t(gene.ORF()),
+                                       uint32_t(name.size()), uint32_t(seq.size()), uint32_t(aa_seq.size()), 0};
+            AppendValue(buffer, header);
+            buffer += name;
+            buffer += seq;
+            buffer += aa_seq;
+            AppendPadding(buffer);
+        }
+        std::string fname = DbBundleFname(db.Segment(), key);
+        WriteBundle(fname, buffer);
+        INFO(db.size() << " records were saved to germline DB bundle " << fname);
+    }
+
+    void GermlineDbCache::WriteBundle(std::string fname, const std::string &content) const {
+        path::make_dirs(cache_dir_);
+        std::string tmp_fname = fname + ".tmp." + std::to_string(getpid());
+        std::ofstream out(tmp_fname, std::ios::binary);
+        VERIFY_MSG(out.good(), "Germline bundle " << tmp_fname << " cannot be opened");
+        out.write(content.data(), content.size());
+        out.close();
+        VERIFY_MSG(!out.fail(), "Germline bundle " << tmp_fname << " cannot be written");
+        VERIFY_MSG(std::rename(tmp_fname.c_str(), fname.c_str()) == 0,
+                   "Germline bundle " << tmp_fname << " cannot be renamed into " << fname);
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+
+#include <germline_utils/germline_databases/custom_gene_database.hpp>
+
+namespace germline_utils {
+    // 64-bit FNV-1a hash of a stream of values, used as key of cached germline bundles
+    class ContentHasher {
+        uint64_t hash_;
+
+    public:
+        ContentHasher();
+
+        void Update(const void *data, size_t size);
+
+        void Update(uint64_t value) { Update(&value, sizeof(value)); }
+
+        // size of string is hashed too, so concatenation of strings does not collide with a single string
+        void Update(const std::string &str);
+
+        void UpdateFileContent(std::string fname);
+
+        uint64_t Hash() const { return hash_; }
+    };
+
+    // persistent storage of parsed germline databases, bundles are stored in cache_dir and named by their keys
+    // bundle is never updated: any change of input files or parameters changes the key and leads to a new bundle
+    //
+    // layout of DB bundle (numbers are stored in the host byte order, each section is padded to 8 bytes):
+    //   header:  char magic[8], uint64 version, uint64 key, uint64 segment_type, uint64 num_genes
+    //   genes:   uint64 id, uint32 chain_type, uint32 orf, uint32 name_length, uint32 seq_length,
+    //            uint32 aa_seq_length, uint32 padding, char name[name_length], char seq[seq_length],
+    //            char aa_seq[aa_seq_length]
+    // nucleotide and amino acid sequences are stored as strings of their letters
+    //
+    // hashes of contents of input files are cached in stamps, so files are not read while they are unchanged:
+    //   stamp:   char magic[8], uint64 version, uint64 file_size, int64 mtime_sec, int64 mtime_nsec,
+    //            uint64 content_hash, uint64 path_length, char path[path_length]
+    // stamp is named by hash of absolute path of file and is valid while size and mtime of file coincide with it
+    class GermlineDbCache {
+        std::string cache_dir_;
+
+        std::string DbBundleFname(SegmentType segment_type, uint64_t key) const;
+
+        std::string StampFname(std::string full_path) const;
+
+    public:
+        static const char magic[8];
+        static const char stamp_magic[8];
+        static const uint64_t version = 1;
+
+        GermlineDbCache(std::string cache_dir) : cache_dir_(cache_dir) { }
+
+        bool Enabled() const { return !cache_dir_.empty(); }
+
+        // name of bundle file, e.g., <cache_dir>/germline_V_0123456789abcdef.bin
+        std::string BundleFname(std::string prefix, uint64_t key) const;
+
+        // returns FNV-1a hash of content of file (the same as ContentHasher::UpdateFileContent on empty hasher),
+        // if cache is enabled, file is read only if its size or mtime differ from the stamp
+        uint64_t FileContentHash(std::string fname) const;
+
+        // returns false if bundle does not exist, genes are added to db in the order of their global indices
+        bool LoadDb(uint64_t key, CustomGeneDatabase &db) const;
+
+        void SaveDb(uint64_t key, const CustomGeneDatabase &db) const;
+
+        // content is written into temporary file that is renamed then,
+        // so concurrent runs never observe partially written bundles
+        void WriteBundle(std::string fname, const std::string &content) const;
+    };
+}
@@ -186,30 +186,44 @@ namespace germline_utils {
             INFO(chain_types_[i] << ": " << j_genes_fnames_[i]);
     }
 
+    uint64_t GermlineDbGenerator::ComputeCacheKey(germline_utils::SegmentType segment_type,
+                                                  const std::vector<std::string> &fnames) const {
+        ContentHasher hasher;
+        hasher.Update(GermlineDbCache::version);
+        hasher.Update(uint64_t(segment_type));
+        for(size_t i = 0; i < fnames.size(); i++) {
+            hasher.Update(uint64_t(chain_types_[i].Chain()));
+            hasher.Update(fnames[i]);
+            hasher.Update(cache_.FileContentHash(fnames[i]));
+        }
+        return hasher.Hash();
+    }
+
+    germline_utils::CustomGeneDatabase GermlineDbGenerator::GenerateDb(germline_utils::SegmentType segment_type,
+                                                                       const std::vector<std::string> &fnames) {
+        germline_utils::CustomGeneDatabase custom_db(segment_type);
+        uint64_t cache_key = 0;
+        if(cache_.Enabled()) {
+            cache_key = ComputeCacheKey(segment_type, fnames);
+            if(cache_.LoadDb(cache_key, custom_db))
+                return custom_db;
+        }
+        for(size_t i = 0; i < fnames.size(); i++)
+            custom_db.AddDatabase(germline_utils::ImmuneGeneType(chain_types_[i], segment_type), fnames[i]);
+        if(cache_.Enabled())
+            cache_.SaveDb(cache_key, custom_db);
+        return custom_db;
+    }
+
     germline_utils::CustomGeneDatabase GermlineDbGenerator::GenerateVariableDb() {
-        germline_utils::CustomGeneDatabase v_custom_db(germline_utils::SegmentType::VariableSegment);
-        for(size_t i = 0; i < v_genes_fnames_.size(); i++)
-            v_custom_db.AddDatabase(germline_utils::ImmuneGeneType(chain_types_[i],
-                                                                   germline_utils::SegmentType::VariableSegment),
-                                    v_genes_fnames_[i]);
-        return v_custom_db;
+        return GenerateDb(germline_utils::SegmentType::VariableSegment, v_genes_fnames_);
     }
 
     germline_utils::CustomGeneDatabase GermlineDbGenerator::GenerateDiversityDb() {
-        germline_utils::CustomGeneDatabase d_custom_db(germline_utils::SegmentType::DiversitySegment);
-        for(size_t i = 0; i < d_genes_fnames_.size(); i++)
-            d_custom_db.AddDatabase(germline_utils::ImmuneGeneType(chain_types_[i],
-                                                                   germline_utils::SegmentType::DiversitySegment),
-                                    d_genes_fnames_[i]);
-        return d_custom_db;
+        return GenerateDb(germline_utils::SegmentType::DiversitySegment, d_genes_fnames_);
     }
 
     germline_utils::CustomGeneDatabase GermlineDbGenerator::GenerateJoinDb() {
-        germline_utils::CustomGeneDatabase j_custom_db(germline_utils::SegmentType::JoinSegment);
-        for(size_t i = 0; i < j_genes_fnames_.size(); i++)
-            j_custom_db.AddDatabase(germline_utils::ImmuneGeneType(chain_types_[i],
-                                                                   germline_utils::SegmentType::JoinSegment),
-                                    j_genes_fnames_[i]);
-        return j_custom_db;
+        return GenerateDb(germline_utils::SegmentType::JoinSegment, j_genes_fnames_);
     }
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "germline_utils/germline_config.hpp"
 #include <germline_utils/germline_databases/custom_gene_database.hpp>
+#include "germline_utils/germline_db_cache.hpp"
 
 namespace germline_utils {
     class GermlineDbGenerator {
@@ -13,13 +14,24 @@ namespace germline_utils {
         std::vector<std::string> d_genes_fnames_;
         std::vector<std::string> j_genes_fnames_;
 
+        GermlineDbCache cache_;
+
         void GenerateGeneFnames();
 
+        // key depends on content of germline files, so bundle is rebuilt after any update of them
+        // files are hashed only if their size or mtime changed since the last run
+        uint64_t ComputeCacheKey(germline_utils::SegmentType segment_type,
+                                 const std::vector<std::string> &fnames) const;
+
+        germline_utils::CustomGeneDatabase GenerateDb(germline_utils::SegmentType segment_type,
+                                                      const std::vector<std::string> &fnames);
+
     public:
         GermlineDbGenerator(const germline_utils::GermlineInput &germ_input,
                             const germline_utils::GermlineParams &germ_params) :
                 germ_input_(germ_input),
-                germ_params_(germ_params) {
+                germ_params_(germ_params),
+                cache_(germ_params.cache_dir) {
             GenerateGeneFnames();
         }
 
@@ -61,6 +61,8 @@ void parse_command_line_args(vj_finder::VJFinderConfig &cfg, int argc, char** ar
              "replace spaces in read headers with underline symbol '_'")
             ("separator", po::value<std::string>(&cfg.io_params.output_params.output_details.separator)->default_value(cfg.io_params.output_params.output_details.separator),
              "separator for alignment info file: ','")
+            ("binary-alignment-info", po::value<bool>(&cfg.io_params.output_params.output_details.binary_alignment_info)->default_value(cfg.io_params.output_params.output_details.binary_alignment_info),
+             "write alignment info in columnar binary format (see vj_alignment_info_converter) instead of TSV")
 
             ("pseudogenes,P", po::value<bool>(&cfg.algorithm_params.germline_params.pseudogenes)->default_value(cfg.algorithm_params.germline_params.pseudogenes),
              "use pseudogenes along with normal germline genes")
@@ -68,14 +70,24 @@ void parse_command_line_args(vj_finder::VJFinderConfig &cfg, int argc, char** ar
              "loci: IGH, IGL, IGK, IG (all BCRs), TRA, TRB, TRG, TRD, TR (all TCRs) or all")
             ("organism", po::value<std::string>(&cfg.algorithm_params.germline_params.organism)->default_value(cfg.algorithm_params.germline_params.organism),
              "organism ('human', 'mouse', 'pig', 'rabbit', 'rat' and 'rhesus_monkey' are supported)")
+            ("germline-cache-dir", po::value<std::string>(&cfg.algorithm_params.germline_params.cache_dir)->default_value(cfg.algorithm_params.germline_params.cache_dir),
+             "directory of precompiled germline DB bundles reused by subsequent runs (disabled if empty)")
 
             ("threads,t", po::value<size_t>(&cfg.run_params.num_threads)->default_value(cfg.run_params.num_threads),
              "the number of threads")
+            ("streaming", po::value<bool>(&cfg.run_params.streaming_mode)->default_value(cfg.run_params.streaming_mode),
+             "read, align and write input reads chunk by chunk using bounded memory")
+            ("chunk-size", po::value<size_t>(&cfg.run_params.chunk_size)->default_value(cfg.run_params.chunk_size),
+             "the number of reads in a chunk in streaming mode")
 
             ("word-size,k", po::value<size_t>(&cfg.algorithm_params.aligner_params.word_size_v)->default_value(cfg.algorithm_params.aligner_params.word_size_v),
              "word size for V genes")
             ("word-size-j", po::value<size_t>(&cfg.algorithm_params.aligner_params.word_size_j)->default_value(cfg.algorithm_params.aligner_params.word_size_j),
              "word size for J genes")
+            ("minimizer-window-v", po::value<size_t>(&cfg.algorithm_params.aligner_params.minimizer_window_v)->default_value(cfg.algorithm_params.aligner_params.minimizer_window_v),
+             "window of minimizers used for seeding of V genes (1 means that all k-mers are used)")
+            ("minimizer-window-j", po::value<size_t>(&cfg.algorithm_params.aligner_params.minimizer_window_j)->default_value(cfg.algorithm_params.aligner_params.minimizer_window_j),
+             "window of minimizers used for seeding of J genes (1 means that all k-mers are used)")
             ("min-k-coverage-v,n", po::value<size_t>(&cfg.algorithm_params.aligner_params.min_k_coverage_v)->default_value(cfg.algorithm_params.aligner_params.min_k_coverage_v),
              "minimal block coverage for V gene")
             ("min-k-coverage-j", po::value<size_t>(&cfg.algorithm_params.aligner_params.min_k_coverage_j)->default_value(cfg.algorithm_params.aligner_params.min_k_coverage_j),
@@ -84,6 +96,8 @@ void parse_command_line_args(vj_finder::VJFinderConfig &cfg, int argc, char** ar
              "maximal number of V gene candidates for each query")
             ("max-candidates-j", po::value<size_t>(&cfg.algorithm_params.aligner_params.max_candidates_j)->default_value(cfg.algorithm_params.aligner_params.max_candidates_j),
              "maximal number of J gene candidates for each query")
+            ("deduplicate", po::value<bool>(&cfg.algorithm_params.aligner_params.deduplicate_reads)->default_value(cfg.algorithm_params.aligner_params.deduplicate_reads),
+             "align only one read from each group of reads with identical sequences")
 
             ("min-len", po::value<size_t>(&cfg.algorithm_params.filtering_params.min_aligned_length)->default_value(cfg.algorithm_params.filtering_params.min_aligned_length),
              "minimal length of reported sequence")
@@ -6,11 +6,11 @@ namespace vj_finder {
     class ImmuneGeneAlignmentConverter : public algorithms::BlockAlignmentConverter<
             germline_utils::ImmuneGene, core::Read> {
     public:
-        seqan::Dna5String GetSubjectString(const germline_utils::ImmuneGene &subject) {
+        const seqan::Dna5String& GetSubjectString(const germline_utils::ImmuneGene &subject) {
             return subject.seq();
         }
 
-        seqan::Dna5String GetQueryString(const core::Read& query) {
+        const seqan::Dna5String& GetQueryString(const core::Read& query) {
             return query.seq;
         }
     };
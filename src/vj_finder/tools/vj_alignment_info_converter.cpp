@@ -0,0 +1,29 @@
+// Converter of binary alignment info of VJ Finder (see vj_binary_alignment_info.hpp) to TSV files
+// Usage: vj_alignment_info_converter alignment_info.bin alignment_info.csv filtering_info.csv
+
+#include <logger/logger.hpp>
+#include <logger/log_writers.hpp>
+
+#include "../vj_binary_alignment_info.hpp"
+
+void create_console_logger() {
+    using namespace logging;
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+int main(int argc, char **argv) {
+    create_console_logger();
+    if(argc != 4) {
+        std::cerr << "Usage: " << argv[0] << " alignment_info.bin alignment_info.csv filtering_info.csv" << std::endl;
+        return 1;
+    }
+    vj_finder::VJBinaryAlignmentReader reader(argv[1]);
+    INFO(reader.NumRows() << " rows in " << reader.NumBlocks() << " blocks were read from " << argv[1]);
+    std::ofstream alignment_info_out(argv[2]);
+    std::ofstream filtering_info_out(argv[3]);
+    vj_finder::ConvertBinaryAlignmentInfoToTsv(reader, alignment_info_out, filtering_info_out);
+    INFO("Alignment info was written to " << argv[2] << ", filtering info was written to " << argv[3]);
+    return 0;
+}
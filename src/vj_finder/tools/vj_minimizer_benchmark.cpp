@@ -0,0 +1,112 @@
+// Benchmark of minimizer-sampled seeding against exhaustive k-mer seeding
+// Usage: vj_minimizer_benchmark [reads.fastq] [num_threads]
+// should be run from the IgReC root directory (configs/vj_finder/config.info is used)
+// for each minimizer window, reports size of V index, number of V k-mer hits, throughput of VJ alignment
+// and recall of exhaustive mode: fraction of reads aligned by exhaustive mode that are aligned by sampled mode,
+// and fractions of them with the same top V and J genes
+
+#include <logger/logger.hpp>
+#include <logger/log_writers.hpp>
+#include <perfcounter.hpp>
+
+#include <convert.hpp>
+#include <read_archive.hpp>
+#include <germline_utils/germline_db_generator.hpp>
+#include "../vj_finder_config.hpp"
+#include "../vj_germline_index.hpp"
+#include "../vj_parallel_processor.hpp"
+
+void create_console_logger() {
+    using namespace logging;
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+struct SeedingRun {
+    size_t num_indexed_kmers;
+    size_t num_kmer_hits;
+    double reads_per_second;
+    vj_finder::VJAlignmentInfo alignment_info;
+};
+
+SeedingRun RunSeeding(const vj_finder::VJFinderConfig::AlgorithmParams &algorithm_params,
+                      const germline_utils::CustomGeneDatabase &v_db,
+                      const germline_utils::CustomGeneDatabase &j_db,
+                      std::string reads_fname, size_t num_threads) {
+    vj_finder::VJGermlineIndex germline_index(v_db, j_db, algorithm_params.aligner_params);
+    // reads are modified by fixing, cropping and filling, so each run gets a fresh copy
+    core::ReadArchive reads(reads_fname);
+    SeedingRun run;
+    run.num_indexed_kmers = germline_index.VIndex().NumPositions();
+    run.num_kmer_hits = 0;
+    for(auto it = reads.cbegin(); it != reads.cend(); it++)
+        run.num_kmer_hits += germline_index.VIndex().NumKmerHits(it->seq);
+    perf_counter pc;
+    vj_finder::VJParallelProcessor processor(reads, algorithm_params, germline_index, num_threads);
+    run.alignment_info = processor.Process();
+    run.reads_per_second = double(reads.size()) / pc.time();
+    return run;
+}
+
+std::string TopGeneName(const vj_finder::VJHits &vj_hits, bool v_gene) {
+    return core::seqan_string_to_string(v_gene ? vj_hits.GetVHitByIndex(0).ImmuneGene().name() :
+                                        vj_hits.GetJHitByIndex(0).ImmuneGene().name());
+}
+
+void ReportRecall(const SeedingRun &exhaustive, const SeedingRun &sampled, std::string reads_fname) {
+    core::ReadArchive reads(reads_fname);
+    size_t num_aligned = 0;
+    size_t num_recalled = 0;
+    size_t num_same_v = 0;
+    size_t num_same_j = 0;
+    for(auto it = reads.cbegin(); it != reads.cend(); it++) {
+        if(exhaustive.alignment_info.ReadIsFiltered(*it))
+            continue;
+        num_aligned++;
+        if(sampled.alignment_info.ReadIsFiltered(*it))
+            continue;
+        num_recalled++;
+        const auto &exhaustive_hits = exhaustive.alignment_info.GetVJHitsByRead(*it);
+        const auto &sampled_hits = sampled.alignment_info.GetVJHitsByRead(*it);
+        num_same_v += TopGeneName(exhaustive_hits, true) == TopGeneName(sampled_hits, true);
+        num_same_j += TopGeneName(exhaustive_hits, false) == TopGeneName(sampled_hits, false);
+    }
+    double denominator = double(std::max<size_t>(num_aligned, 1));
+    INFO("  recall of aligned reads: " << double(num_recalled) / denominator << " (" << num_recalled <<
+         " of " << num_aligned << "), same top V gene: " << double(num_same_v) / denominator <<
+         ", same top J gene: " << double(num_same_j) / denominator);
+}
+
+int main(int argc, char **argv) {
+    create_console_logger();
+    std::string reads_fname = argc > 1 ? argv[1] : "test_dataset/merged_reads.fastq";
+    size_t num_threads = argc > 2 ? size_t(std::stoul(argv[2])) : 1;
+    vj_finder::VJFinderConfig config;
+    vj_finder::load(config, "configs/vj_finder/config.info");
+    germline_utils::GermlineDbGenerator db_generator(config.io_params.input_params.germline_input,
+                                                     config.algorithm_params.germline_params);
+    auto v_db = db_generator.GenerateVariableDb();
+    auto j_db = db_generator.GenerateJoinDb();
+
+    auto algorithm_params = config.algorithm_params;
+    algorithm_params.aligner_params.minimizer_window_v = 1;
+    algorithm_params.aligner_params.minimizer_window_j = 1;
+    SeedingRun exhaustive = RunSeeding(algorithm_params, v_db, j_db, reads_fname, num_threads);
+    INFO("Exhaustive seeding: " << exhaustive.num_indexed_kmers << " indexed V k-mers, " <<
+         exhaustive.num_kmer_hits << " V k-mer hits, " << exhaustive.reads_per_second << " reads per second");
+    std::vector<size_t> windows = {2, 3, 4, 5, 7};
+    for(auto it = windows.begin(); it != windows.end(); it++) {
+        // windows do not exceed k, so minimizers of a shared substring overlap and are combined into blocks
+        const auto &aligner_params = config.algorithm_params.aligner_params;
+        algorithm_params.aligner_params.minimizer_window_v = std::min(*it, aligner_params.word_size_v);
+        algorithm_params.aligner_params.minimizer_window_j = std::min(*it, aligner_params.word_size_j);
+        SeedingRun sampled = RunSeeding(algorithm_params, v_db, j_db, reads_fname, num_threads);
+        INFO("Minimizer seeding (w_v = " << algorithm_params.aligner_params.minimizer_window_v << ", w_j = " <<
+             algorithm_params.aligner_params.minimizer_window_j << "): " << sampled.num_indexed_kmers <<
+             " indexed V k-mers, " << sampled.num_kmer_hits << " V k-mer hits, " << sampled.reads_per_second <<
+             " reads per second, speedup " << sampled.reads_per_second / exhaustive.reads_per_second);
+        ReportRecall(exhaustive, sampled, reads_fname);
+    }
+    return 0;
+}
@@ -0,0 +1,148 @@
+// Benchmark of k-mer seeding against germline V and J databases
+// Usage: vj_seeding_benchmark [reads.fastq] [num_rounds]
+// should be run from the IgReC root directory (configs/vj_finder/config.info is used)
+
+#include <logger/logger.hpp>
+#include <logger/log_writers.hpp>
+#include <perfcounter.hpp>
+
+#include <unordered_map>
+
+#include <read_archive.hpp>
+#include <hashes/kmer_generator.hpp>
+#include <germline_utils/germline_db_generator.hpp>
+#include "../vj_finder_config.hpp"
+#include "../vj_germline_index.hpp"
+
+void create_console_logger() {
+    using namespace logging;
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+// copy of the former unordered_map-based SubjectQueryKmerIndex, kept as a reference point
+class MapKmerIndex {
+    struct SubjectPosition {
+        size_t subject_index;
+        size_t position;
+    };
+
+    size_t k_;
+    size_t num_subjects_;
+    std::unordered_map<uint64_t, std::vector<SubjectPosition>> kmer_query_pos_map_;
+
+public:
+    template<typename SubjectDatabase>
+    MapKmerIndex(const SubjectDatabase &db, size_t k) : k_(k), num_subjects_(db.size()) {
+        for(size_t j = 0; j < db.size(); j++)
+            for(const auto &kmer : algorithms::Kmers(db[j].seq(), k_))
+                kmer_query_pos_map_[kmer.code].push_back({j, kmer.pos});
+    }
+
+    algorithms::SubjectKmerMatches GetSubjectKmerMatchesForQuery(const seqan::Dna5String &query_str) const {
+        algorithms::SubjectKmerMatches subj_kmer_matches(num_subjects_);
+        for(const auto &kmer : algorithms::Kmers(query_str, k_)) {
+            if(kmer_query_pos_map_.find(kmer.code) == kmer_query_pos_map_.end())
+                continue;
+            auto subj_pos = kmer_query_pos_map_.at(kmer.code);
+            for(auto it = subj_pos.begin(); it != subj_pos.end(); it++)
+                subj_kmer_matches.Update(it->subject_index, {static_cast<int>(it->position),
+                                                             static_cast<int>(kmer.pos)});
+        }
+        return subj_kmer_matches;
+    }
+};
+
+size_t NumMatches(const algorithms::SubjectKmerMatches &matches) {
+    size_t num_matches = 0;
+    for(auto it = matches.cbegin(); it != matches.cend(); it++)
+        num_matches += it->size();
+    return num_matches;
+}
+
+template<typename Index>
+double SeedReads(const Index &index, const core::ReadArchive &reads, size_t num_rounds, size_t &num_matches) {
+    num_matches = 0;
+    perf_counter pc;
+    for(size_t round = 0; round < num_rounds; round++)
+        for(auto it = reads.cbegin(); it != reads.cend(); it++)
+            num_matches += NumMatches(index.GetSubjectKmerMatchesForQuery(it->seq));
+    return pc.time() * 1e6 / double(reads.size() * num_rounds);
+}
+
+// reads are looked up by blocks of batch_size reads, matches are filled from the resolved batch
+template<typename Index>
+double SeedReadsBatched(const Index &index, const core::ReadArchive &reads, size_t num_rounds, size_t batch_size,
+                        size_t &num_matches) {
+    num_matches = 0;
+    algorithms::KmerLookupBatch batch;
+    algorithms::SubjectKmerMatches matches(index.NumSubjects());
+    std::vector<const seqan::Dna5String*> queries;
+    perf_counter pc;
+    for(size_t round = 0; round < num_rounds; round++)
+        for(size_t start = 0; start < reads.size(); start += batch_size) {
+            queries.clear();
+            for(size_t i = start; i < std::min(start + batch_size, reads.size()); i++)
+                queries.push_back(&reads[i].seq);
+            index.LookupQueries(queries.data(), queries.size(), batch);
+            for(size_t i = 0; i < queries.size(); i++) {
+                batch.FillSubjectKmerMatches(i, matches);
+                num_matches += NumMatches(matches);
+            }
+        }
+    return pc.time() * 1e6 / double(reads.size() * num_rounds);
+}
+
+void BenchmarkLocus(const vj_finder::VJFinderConfig &config, std::string locus,
+                    const core::ReadArchive &reads, size_t num_rounds) {
+    auto germline_params = config.algorithm_params.germline_params;
+    germline_params.loci = locus;
+    germline_utils::GermlineDbGenerator db_generator(config.io_params.input_params.germline_input, germline_params);
+    auto v_db = db_generator.GenerateVariableDb();
+    const auto &aligner_params = config.algorithm_params.aligner_params;
+
+    // both indices are built for V genes only, like VJGermlineIndex builds its V index
+    perf_counter pc;
+    MapKmerIndex map_index(v_db, aligner_params.word_size_v);
+    double map_construction_time = pc.time_ms();
+    pc.reset();
+    vj_finder::CustomGermlineDbHelper v_helper(v_db);
+    vj_finder::VJGermlineIndex::VKmerIndex v_index(v_db, aligner_params.word_size_v, v_helper,
+                                                   aligner_params.minimizer_window_v);
+    double csr_construction_time = pc.time_ms();
+
+    size_t map_matches = 0;
+    size_t csr_matches = 0;
+    double map_time = SeedReads(map_index, reads, num_rounds, map_matches);
+    double csr_time = SeedReads(v_index, reads, num_rounds, csr_matches);
+    INFO(locus << ": " << v_db.size() << " V genes, " << v_index.NumPositions() <<
+                 " indexed V k-mers (k = " << aligner_params.word_size_v << ")");
+    INFO(locus << " map-based index: construction " << map_construction_time << " ms, seeding " <<
+                 map_time << " us per read, " << map_matches << " k-mer matches");
+    INFO(locus << " CSR index: construction " << csr_construction_time << " ms, seeding " <<
+                 csr_time << " us per read, " << csr_matches << " k-mer matches");
+    INFO(locus << " seeding speedup: " << map_time / csr_time);
+    std::vector<size_t> batch_sizes = {2, 16, 64};
+    for(auto it = batch_sizes.begin(); it != batch_sizes.end(); it++) {
+        size_t batch_matches = 0;
+        double batch_time = SeedReadsBatched(v_index, reads, num_rounds, *it, batch_matches);
+        VERIFY_MSG(batch_matches == csr_matches, "Batched seeding reports " << batch_matches <<
+                   " k-mer matches instead of " << csr_matches);
+        INFO(locus << " CSR index, batches of " << *it << " reads: seeding " << batch_time <<
+                     " us per read, speedup over single queries: " << csr_time / batch_time);
+    }
+}
+
+int main(int argc, char **argv) {
+    create_console_logger();
+    std::string reads_fname = argc > 1 ? argv[1] : "test_dataset/merged_reads.fastq";
+    size_t num_rounds = argc > 2 ? size_t(std::stoul(argv[2])) : 10;
+    vj_finder::VJFinderConfig config;
+    vj_finder::load(config, "configs/vj_finder/config.info");
+    core::ReadArchive reads(reads_fname);
+    std::vector<std::string> loci = {"IGH", "IGK", "IGL"};
+    for(auto it = loci.begin(); it != loci.end(); it++)
+        BenchmarkLocus(config, *it, reads, num_rounds);
+    return 0;
+}
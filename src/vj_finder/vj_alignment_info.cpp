@@ -1,8 +1,11 @@
 #include <verify.hpp>
 #include "vj_alignment_info.hpp"
 #include "immune_gene_alignment_converter.hpp"
+#include "vj_binary_alignment_info.hpp"
 
 namespace vj_finder {
+    const size_t VJAlignmentInfo::missing_index;
+
     void VJAlignmentInfo::Update(VJAlignmentInfo vj_alignment_info) {
         for(size_t i = 0; i < vj_alignment_info.NumVJHits(); i++)
             UpdateHits(vj_alignment_info.GetVJHitsByIndex(i));
@@ -10,22 +13,42 @@ namespace vj_finder {
             UpdateFilteringInfo(vj_alignment_info.GetFilteringInfoByIndex(i));
     }
 
+    void VJAlignmentInfo::SetIndexByReadId(std::vector<size_t> &index_by_read_id, size_t read_id, size_t index) {
+        if(read_id >= index_by_read_id.size())
+            index_by_read_id.resize(read_id + 1, missing_index);
+        index_by_read_id[read_id] = index;
+    }
+
+    void VJAlignmentInfo::Reserve(size_t num_reads) {
+        alignment_records_.reserve(num_reads);
+        hit_index_by_read_id_.reserve(num_reads);
+        filtering_info_index_by_read_id_.reserve(num_reads);
+    }
+
     void VJAlignmentInfo::UpdateFilteringInfo(VJFilteringInfo filtering_info) {
-        filtering_infos_.push_back(filtering_info);
-        read_id_filtering_info_map_[filtering_info.read->id] = filtering_infos_.size() - 1;
+        size_t read_id = filtering_info.read->id;
+        filtering_infos_.push_back(std::move(filtering_info));
+        SetIndexByReadId(filtering_info_index_by_read_id_, read_id, filtering_infos_.size() - 1);
     }
 
     void VJAlignmentInfo::UpdateChainTypeMap(const VJHits &vj_hits) {
-        auto chain_type = vj_hits.GetVHitByIndex(0).ImmuneGene().Chain();
-        if(chain_type_abundance_.find(chain_type) == chain_type_abundance_.end())
-            chain_type_abundance_[chain_type] = 0;
-        chain_type_abundance_[chain_type]++;
+        chain_type_abundance_[vj_hits.Chain()]++;
+    }
+
+    void VJAlignmentInfo::AddHitsWithoutChainType(VJHits vj_hits) {
+        size_t read_id = vj_hits.Read().id;
+        alignment_records_.push_back(std::move(vj_hits));
+        SetIndexByReadId(hit_index_by_read_id_, read_id, alignment_records_.size() - 1);
     }
 
     void VJAlignmentInfo::UpdateHits(VJHits vj_hits) {
         UpdateChainTypeMap(vj_hits);
-        alignment_records_.push_back(std::move(vj_hits));
-        read_id_hit_index_map_[vj_hits.Read().id] = alignment_records_.size() - 1;
+        AddHitsWithoutChainType(std::move(vj_hits));
+    }
+
+    void VJAlignmentInfo::AddChainTypeAbundance(const ChainTypeAbundance &chain_type_abundance) {
+        for(auto it = chain_type_abundance.cbegin(); it != chain_type_abundance.cend(); it++)
+            chain_type_abundance_[it->first] += it->second;
     }
 
 
@@ -42,91 +65,159 @@ namespace vj_finder {
     }
 
     const VJHits& VJAlignmentInfo::GetVJHitsByRead(const core::Read &read) const {
-        VERIFY_MSG(read_id_hit_index_map_.find(read.id) != read_id_hit_index_map_.end(),
-                   "Alignment info does not contain read " << read.name);
-        return alignment_records_[read_id_hit_index_map_.at(read.id)];
+        return alignment_records_[GetVJHitIndexByRead(read)];
     }
 
     VJFilteringInfo VJAlignmentInfo::GetFilteringInfoByRead(const core::Read &read) const {
-        VERIFY_MSG(read_id_filtering_info_map_.find(read.id) != read_id_filtering_info_map_.end(),
-                   "Alignment info does not contain read " << read.name);
-        return filtering_infos_[read_id_filtering_info_map_.at(read.id)];
+        return filtering_infos_[GetFilteringInfoIndexByRead(read)];
     }
 
-    void VJAlignmentOutput::OutputAlignmentInfo() const {
-        std::ofstream out(output_params_.output_files.alignment_info_fname);
+    void WriteAlignmentInfoHeader(std::ostream &out) {
         out << "Read_name\tChain_type\tV_hit\tV_start_pos\tV_end_pos\tV_score\t"
-                       "J_hit\tJ_start_pos\tJ_end_pos\tJ_score" << std::endl;
-        for(size_t i = 0; i < alignment_info_.NumVJHits(); i++) {
-            auto vj_hits = alignment_info_.GetVJHitsByIndex(i);
-            for(size_t j = 0; j < output_params_.output_details.num_aligned_candidates; j++)
-                out << vj_hits.Read().name << "\t" << vj_hits.GetVHitByIndex(0).ImmuneGene().Chain() << "\t" <<
-                        vj_hits.GetVHitByIndex(j).ImmuneGene().name() << "\t" <<
-                        vj_hits.GetVHitByIndex(j).FirstMatchReadPos() + 1 << "\t" <<
-                        vj_hits.GetVHitByIndex(j).LastMatchReadPos() << "\t" <<
-                        vj_hits.GetVHitByIndex(j).Score() << "\t" <<
-                        vj_hits.GetJHitByIndex(j).ImmuneGene().name() << "\t" <<
-                        vj_hits.GetJHitByIndex(j).FirstMatchReadPos() + 1 << "\t" <<
-                        vj_hits.GetJHitByIndex(j).LastMatchReadPos() << "\t" <<
-                        vj_hits.GetJHitByIndex(j).Score() << "\t" << std::endl;
+                       "J_hit\tJ_start_pos\tJ_end_pos\tJ_score" << '\n';
+    }
+
+    void WriteAlignmentInfoRecord(std::ostream &out, const VJHits &vj_hits, size_t num_aligned_candidates) {
+        for(size_t j = 0; j < num_aligned_candidates; j++)
+            out << vj_hits.Read().name << "\t" << vj_hits.GetVHitByIndex(0).ImmuneGene().Chain() << "\t" <<
+                    vj_hits.GetVHitByIndex(j).ImmuneGene().name() << "\t" <<
+                    vj_hits.GetVHitByIndex(j).FirstMatchReadPos() + 1 << "\t" <<
+                    vj_hits.GetVHitByIndex(j).LastMatchReadPos() << "\t" <<
+                    vj_hits.GetVHitByIndex(j).Score() << "\t" <<
+                    vj_hits.GetJHitByIndex(j).ImmuneGene().name() << "\t" <<
+                    vj_hits.GetJHitByIndex(j).FirstMatchReadPos() + 1 << "\t" <<
+                    vj_hits.GetJHitByIndex(j).LastMatchReadPos() << "\t" <<
+                    vj_hits.GetJHitByIndex(j).Score() << "\t" << '\n';
+    }
+
+    void WriteReadRecord(std::ostream &out, const core::Read &read) {
+        out << ">" << read.name << '\n';
+        out << read.seq << '\n';
+    }
+
+    // index is 0-based index of the aligned read in the output
+    void WriteVAlignmentRecord(std::ostream &out, const VJHits &vj_hits, size_t index) {
+        ImmuneGeneAlignmentConverter alignment_converter;
+        const auto &v_hit = vj_hits.GetVHitByIndex(0);
+        auto v_alignment = alignment_converter.ConvertToAlignment(v_hit.ImmuneGene(), vj_hits.Read(),
+                                                                  v_hit.BlockAlignment());
+        auto subject_row = seqan::row(v_alignment.Alignment(), 0);
+        auto query_row = seqan::row(v_alignment.Alignment(), 1);
+        out << ">INDEX:" << index + 1 << "|READ:" << vj_hits.Read().name << "|START_POS:" <<
+                v_alignment.StartSubjectPosition() << "|END_POS:" <<
+                v_alignment.EndSubjectPosition() << '\n';
+        out << query_row << '\n';
+        out << ">INDEX:" << index + 1 << "|GENE:" << v_alignment.subject().name() <<
+        "|START_POS:" << v_alignment.StartQueryPosition() << "|END_POS:" <<
+                v_alignment.EndQueryPosition() << "|CHAIN_TYPE:" <<
+                v_alignment.subject().Chain() << '\n';
+        out << subject_row << '\n';
+    }
+
+    void WriteFilteringInfoRecord(std::ostream &out, const VJFilteringInfo &filtering_info) {
+        out << filtering_info.read->name << "\t" << filtering_info << '\n';
+    }
+
+    void VJAlignmentOutput::OutputAlignmentInfo() const {
+        if(output_params_.output_details.binary_alignment_info) {
+            VJBinaryAlignmentWriter writer(output_params_.output_files.binary_alignment_info_fname,
+                                           output_params_.output_details.num_aligned_candidates);
+            writer.Write(alignment_info_);
+            writer.Close();
+            return;
         }
+        std::ofstream out(output_params_.output_files.alignment_info_fname);
+        WriteAlignmentInfoHeader(out);
+        for(size_t i = 0; i < alignment_info_.NumVJHits(); i++)
+            WriteAlignmentInfoRecord(out, alignment_info_.GetVJHitsByIndex(i),
+                                     output_params_.output_details.num_aligned_candidates);
         out.close();
         INFO("Alignment info was written to " << output_params_.output_files.alignment_info_fname);
     }
 
     void VJAlignmentOutput::OutputCleanedReads() const {
         std::ofstream out(output_params_.output_files.cleaned_reads_fname);
-        for(size_t i = 0; i < alignment_info_.NumVJHits(); i++) {
-            auto read = alignment_info_.GetVJHitsByIndex(i).Read();
-            out << ">" << read.name << std::endl;
-            out << read.seq << std::endl;
-        }
+        for(size_t i = 0; i < alignment_info_.NumVJHits(); i++)
+            WriteReadRecord(out, alignment_info_.GetVJHitsByIndex(i).Read());
         out.close();
         INFO("Cleaned reads were written to " << output_params_.output_files.cleaned_reads_fname);
     }
 
     void VJAlignmentOutput::OutputFilteredReads() const {
         std::ofstream out(output_params_.output_files.filtered_reads_fname);
-        for(size_t i = 0; i < alignment_info_.NumFilteredReads(); i++) {
-            auto read = alignment_info_.GetFilteredReadByIndex(i);
-            out << ">" << read.name << std::endl;
-            out << read.seq << std::endl;
-        }
+        for(size_t i = 0; i < alignment_info_.NumFilteredReads(); i++)
+            WriteReadRecord(out, alignment_info_.GetFilteredReadByIndex(i));
         out.close();
         INFO("Filtered reads were written to " << output_params_.output_files.filtered_reads_fname);
     }
 
     void VJAlignmentOutput::OutputVAlignments() const {
-        ImmuneGeneAlignmentConverter alignment_converter;
         std::ofstream out(output_params_.output_files.valignments_filename);
-        for(size_t i = 0; i < alignment_info_.NumVJHits(); i++) {
-            auto vj_hits = alignment_info_.GetVJHitsByIndex(i);
-            auto v_hit = vj_hits.GetVHitByIndex(0);
-            auto v_alignment = alignment_converter.ConvertToAlignment(v_hit.ImmuneGene(), vj_hits.Read(),
-                                                                      v_hit.BlockAlignment());
-            auto subject_row = seqan::row(v_alignment.Alignment(), 0);
-            auto query_row = seqan::row(v_alignment.Alignment(), 1);
-            out << ">INDEX:" << i + 1 << "|READ:" << vj_hits.Read().name << "|START_POS:" <<
-                    v_alignment.StartSubjectPosition() << "|END_POS:" <<
-                    v_alignment.EndSubjectPosition() << std::endl;
-            out << query_row << std::endl;
-            out << ">INDEX:" << i + 1 << "|GENE:" << v_alignment.subject().name() <<
-            "|START_POS:" << v_alignment.StartQueryPosition() << "|END_POS:" <<
-                    v_alignment.EndQueryPosition() << "|CHAIN_TYPE:" <<
-                    v_alignment.subject().Chain() << std::endl;
-            out << subject_row << std::endl;
-        }
+        for(size_t i = 0; i < alignment_info_.NumVJHits(); i++)
+            WriteVAlignmentRecord(out, alignment_info_.GetVJHitsByIndex(i), i);
         out.close();
         INFO("V alignments were written to " << output_params_.output_files.valignments_filename);
     }
 
     void VJAlignmentOutput::OutputFilteringInfo() const {
         std::ofstream out(output_params_.output_files.filtering_info_filename);
-        for(size_t i = 0; i < alignment_info_.NumFilteredReads(); i++) {
-            auto filtering_info = alignment_info_.GetFilteringInfoByIndex(i);
-            out << filtering_info.read->name << "\t" << filtering_info << std::endl;
-        }
+        for(size_t i = 0; i < alignment_info_.NumFilteredReads(); i++)
+            WriteFilteringInfoRecord(out, alignment_info_.GetFilteringInfoByIndex(i));
         out.close();
         INFO("Information about filtered reads was written to " << output_params_.output_files.filtering_info_filename);
     }
+
+    VJStreamingOutput::VJStreamingOutput(const VJFinderConfig::IOParams::OutputParams &output_params) :
+            output_params_(output_params),
+            cleaned_reads_out_(output_params.output_files.cleaned_reads_fname),
+            filtered_reads_out_(output_params.output_files.filtered_reads_fname),
+            valignments_out_(output_params.output_files.valignments_filename),
+            filtering_info_out_(output_params.output_files.filtering_info_filename),
+            num_written_hits_(0),
+            num_written_filtered_reads_(0) {
+        if(output_params.output_details.binary_alignment_info) {
+            binary_writer_ = std::make_shared<VJBinaryAlignmentWriter>(
+                    output_params.output_files.binary_alignment_info_fname,
+                    output_params.output_details.num_aligned_candidates);
+            return;
+        }
+        alignment_info_out_.open(output_params.output_files.alignment_info_fname);
+        WriteAlignmentInfoHeader(alignment_info_out_);
+    }
+
+    void VJStreamingOutput::Write(const VJAlignmentInfo &alignment_info) {
+        for(size_t i = 0; i < alignment_info.NumVJHits(); i++) {
+            const VJHits &vj_hits = alignment_info.GetVJHitsByIndex(i);
+            if(!binary_writer_)
+                WriteAlignmentInfoRecord(alignment_info_out_, vj_hits,
+                                         output_params_.output_details.num_aligned_candidates);
+            WriteReadRecord(cleaned_reads_out_, vj_hits.Read());
+            WriteVAlignmentRecord(valignments_out_, vj_hits, num_written_hits_ + i);
+        }
+        for(size_t i = 0; i < alignment_info.NumFilteredReads(); i++) {
+            WriteReadRecord(filtered_reads_out_, alignment_info.GetFilteredReadByIndex(i));
+            WriteFilteringInfoRecord(filtering_info_out_, alignment_info.GetFilteringInfoByIndex(i));
+        }
+        if(binary_writer_)
+            binary_writer_->Write(alignment_info);
+        num_written_hits_ += alignment_info.NumVJHits();
+        num_written_filtered_reads_ += alignment_info.NumFilteredReads();
+    }
+
+    void VJStreamingOutput::Close() {
+        if(binary_writer_)
+            binary_writer_->Close();
+        else {
+            alignment_info_out_.close();
+            INFO("Alignment info was written to " << output_params_.output_files.alignment_info_fname);
+        }
+        cleaned_reads_out_.close();
+        INFO("Cleaned reads were written to " << output_params_.output_files.cleaned_reads_fname);
+        valignments_out_.close();
+        INFO("V alignments were written to " << output_params_.output_files.valignments_filename);
+        filtered_reads_out_.close();
+        INFO("Filtered reads were written to " << output_params_.output_files.filtered_reads_fname);
+        filtering_info_out_.close();
+        INFO("Information about filtered reads was written to " << output_params_.output_files.filtering_info_filename);
+    }
 }
\ No newline at end of file
@@ -1,27 +1,51 @@
 #pragma once
 
 #include <unordered_set>
+#include <fstream>
 #include "vj_finder_config.hpp"
 #include "vj_alignment_structs.hpp"
 #include "vj_hits_filter.hpp"
 
 namespace vj_finder {
     class VJAlignmentInfo {
+    public:
+        typedef std::unordered_map<germline_utils::ChainType, size_t,
+                germline_utils::ChainTypeHasher> ChainTypeAbundance;
+
+    private:
+        static const size_t missing_index = size_t(-1);
+
         std::vector<VJHits> alignment_records_;
         std::vector<VJFilteringInfo> filtering_infos_;
 
-        std::map<size_t, size_t> read_id_hit_index_map_;
-        std::map<size_t, size_t> read_id_filtering_info_map_;
+        // read ids are indices in read archive, so records are addressed by read id directly,
+        // i-th element is index of record of read with id i or missing_index
+        std::vector<size_t> hit_index_by_read_id_;
+        std::vector<size_t> filtering_info_index_by_read_id_;
 
-        std::unordered_map<germline_utils::ChainType, size_t, germline_utils::ChainTypeHasher> chain_type_abundance_;
+        ChainTypeAbundance chain_type_abundance_;
 
         void UpdateChainTypeMap(const VJHits &vj_hits);
 
+        static void SetIndexByReadId(std::vector<size_t> &index_by_read_id, size_t read_id, size_t index);
+
+        static size_t GetIndexByReadId(const std::vector<size_t> &index_by_read_id, size_t read_id) {
+            return read_id < index_by_read_id.size() ? index_by_read_id[read_id] : missing_index;
+        }
+
     public:
         VJAlignmentInfo() { }
 
+        void Reserve(size_t num_reads);
+
         void UpdateHits(VJHits vj_hits);
 
+        // chain type abundance is not updated: it is expected to be computed by the caller
+        // (e.g., reduced over threads) and added using AddChainTypeAbundance
+        void AddHitsWithoutChainType(VJHits vj_hits);
+
+        void AddChainTypeAbundance(const ChainTypeAbundance &chain_type_abundance);
+
         void UpdateFilteringInfo(VJFilteringInfo filtering_info);
 
         void Update(VJAlignmentInfo vj_alignment_info);
@@ -41,19 +65,19 @@ namespace vj_finder {
         VJFilteringInfo GetFilteringInfoByRead(const core::Read &read) const;
 
         bool ReadIsFiltered(const core::Read &read) const {
-            return read_id_filtering_info_map_.find(read.id) != read_id_filtering_info_map_.end();
+            return GetIndexByReadId(filtering_info_index_by_read_id_, read.id) != missing_index;
         }
 
         size_t GetVJHitIndexByRead(const core::Read &read) const {
-            VERIFY_MSG(read_id_hit_index_map_.find(read.id) != read_id_hit_index_map_.end(),
-                       "Info does contain record for aligned read " << read.name);
-            return read_id_hit_index_map_.at(read.id);
+            size_t index = GetIndexByReadId(hit_index_by_read_id_, read.id);
+            VERIFY_MSG(index != missing_index, "Info does contain record for aligned read " << read.name);
+            return index;
         }
 
         size_t GetFilteringInfoIndexByRead(const core::Read &read) const {
-            VERIFY_MSG(read_id_filtering_info_map_.find(read.id) != read_id_filtering_info_map_.end(),
-                       "Info does contain record for filtered read " << read.name);
-            return read_id_filtering_info_map_.at(read.id);
+            size_t index = GetIndexByReadId(filtering_info_index_by_read_id_, read.id);
+            VERIFY_MSG(index != missing_index, "Info does contain record for filtered read " << read.name);
+            return index;
         }
 
         const core::Read& GetFilteredReadByIndex(size_t filtering_info_index) const {
@@ -62,14 +86,15 @@ namespace vj_finder {
             return *(filtering_infos_[filtering_info_index].read);
         }
 
-        typedef std::unordered_map<germline_utils::ChainType, size_t,
-                germline_utils::ChainTypeHasher>::const_iterator ChainTypeAbundanceConstIter;
+        typedef ChainTypeAbundance::const_iterator ChainTypeAbundanceConstIter;
 
         ChainTypeAbundanceConstIter chain_type_cbegin() const { return chain_type_abundance_.cbegin(); }
 
         ChainTypeAbundanceConstIter chain_type_cend() const { return chain_type_abundance_.cend(); }
     };
 
+    void WriteAlignmentInfoHeader(std::ostream &out);
+
     class VJAlignmentOutput {
         const VJFinderConfig::IOParams::OutputParams &output_params_;
         const VJAlignmentInfo &alignment_info_;
@@ -89,4 +114,34 @@ namespace vj_finder {
 
         void OutputFilteringInfo() const;
     };
+
+    class VJBinaryAlignmentWriter;
+
+    // writes alignment results chunk by chunk into the same files as VJAlignmentOutput
+    // chunks should be passed in the order of input reads
+    class VJStreamingOutput {
+        const VJFinderConfig::IOParams::OutputParams &output_params_;
+
+        // alignment info is written either in text or in binary format
+        std::ofstream alignment_info_out_;
+        std::shared_ptr<VJBinaryAlignmentWriter> binary_writer_;
+        std::ofstream cleaned_reads_out_;
+        std::ofstream filtered_reads_out_;
+        std::ofstream valignments_out_;
+        std::ofstream filtering_info_out_;
+
+        size_t num_written_hits_;
+        size_t num_written_filtered_reads_;
+
+    public:
+        VJStreamingOutput(const VJFinderConfig::IOParams::OutputParams &output_params);
+
+        void Write(const VJAlignmentInfo &alignment_info);
+
+        void Close();
+
+        size_t NumWrittenHits() const { return num_written_hits_; }
+
+        size_t NumWrittenFilteredReads() const { return num_written_filtered_reads_; }
+    };
 }
\ No newline at end of file
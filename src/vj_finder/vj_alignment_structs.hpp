@@ -69,6 +69,9 @@ namespace vj_finder {
 
         bool Empty() const { return read_ptr_ == NULL or immune_gene_ptr_ == NULL; }
 
+        // binds hit to another read with identical sequence
+        void UpdateRead(const core::Read &read) { read_ptr_ = &read; }
+
 
         // first match positions are inclusive
         size_t FirstMatchReadPos() const { return block_alignment_.first_match_read_pos(); }
@@ -164,33 +167,62 @@ namespace vj_finder {
         VJHits(const core::Read &read) : read_ptr_(&read) { }
 
         void AddVHit(VGeneHit v_hit) {
-            v_hits_.push_back(v_hit);
+            v_hits_.push_back(std::move(v_hit));
         }
 
         void AddJHit(JGeneHit j_hit) {
-            j_hits_.push_back(j_hit);
+            j_hits_.push_back(std::move(j_hit));
+        }
+
+        // keeps only the best V and J hits and releases memory of the rest
+        void SelectBestHits() {
+            VERIFY_MSG(NumVHits() > 0 and NumJHits() > 0, "Read " << Read().name << " has no V or J hits");
+            v_hits_.erase(v_hits_.begin() + 1, v_hits_.end());
+            v_hits_.shrink_to_fit();
+            j_hits_.erase(j_hits_.begin() + 1, j_hits_.end());
+            j_hits_.shrink_to_fit();
+        }
+
+        void Reserve(size_t num_v_hits, size_t num_j_hits) {
+            v_hits_.reserve(num_v_hits);
+            j_hits_.reserve(num_j_hits);
         }
 
         size_t NumVHits() const { return v_hits_.size(); }
 
         size_t NumJHits() const { return j_hits_.size(); }
 
-        VGeneHit GetVHitByIndex(size_t index) const {
+        const VGeneHit& GetVHitByIndex(size_t index) const {
             VERIFY_MSG(index < NumVHits(), "Index " << index << " exceeds number V hits");
             return v_hits_[index];
         }
 
-        JGeneHit GetJHitByIndex(size_t index) const {
+        const JGeneHit& GetJHitByIndex(size_t index) const {
             VERIFY_MSG(index < NumJHits(), "Index " << index << " exceeds number J hits");
             return j_hits_[index];
         }
 
+        // chain type of the best V hit
+        germline_utils::ChainType Chain() const {
+            VERIFY_MSG(NumVHits() > 0, "Read " << Read().name << " has no V hits");
+            return v_hits_[0].Chain();
+        }
+
         size_t AlignedSegmentLength() const {
             return GetJHitByIndex(0).End() - GetVHitByIndex(0).Start();
         }
 
         const core::Read& Read() const { return *read_ptr_; }
 
+        // binds hits to another read with identical sequence
+        void UpdateRead(const core::Read &read) {
+            read_ptr_ = &read;
+            for(auto it = v_hits_.begin(); it != v_hits_.end(); it++)
+                it->UpdateRead(read);
+            for(auto it = j_hits_.begin(); it != j_hits_.end(); it++)
+                it->UpdateRead(read);
+        }
+
         void AddLeftShift(int shift) {
             for(auto it = v_hits_.begin(); it != v_hits_.end(); it++)
                 it->AddShift(shift);
@@ -214,13 +246,13 @@ namespace vj_finder {
         }
     };
 
-    class CustomGermlineDbHelper : public algorithms::KmerIndexHelper<germline_utils::CustomGeneDatabase,
+    class CustomGermlineDbHelper final : public algorithms::KmerIndexHelper<germline_utils::CustomGeneDatabase,
             seqan::Dna5String> {
     public:
         CustomGermlineDbHelper(const germline_utils::CustomGeneDatabase& db) :
                 KmerIndexHelper<germline_utils::CustomGeneDatabase, seqan::Dna5String>(db) { }
 
-        seqan::Dna5String GetDbRecordByIndex(size_t index) const {
+        const seqan::Dna5String& GetDbRecordByIndex(size_t index) const {
             return db_[index].seq();
         }
 
@@ -233,13 +265,13 @@ namespace vj_finder {
         }
     };
 
-    class ImmuneGeneGermlineDbHelper : public algorithms::KmerIndexHelper<germline_utils::ImmuneGeneDatabase,
+    class ImmuneGeneGermlineDbHelper final : public algorithms::KmerIndexHelper<germline_utils::ImmuneGeneDatabase,
             seqan::Dna5String> {
     public:
         ImmuneGeneGermlineDbHelper(const germline_utils::ImmuneGeneDatabase& db) :
                 KmerIndexHelper<germline_utils::ImmuneGeneDatabase, seqan::Dna5String>(db) { }
 
-        seqan::Dna5String GetDbRecordByIndex(size_t index) const {
+        const seqan::Dna5String& GetDbRecordByIndex(size_t index) const {
             return db_[index].seq();
         }
 
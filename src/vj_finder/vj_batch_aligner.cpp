@@ -0,0 +1,57 @@
+#include <omp.h>
+#include <verify.hpp>
+
+#include "vj_batch_aligner.hpp"
+
+namespace vj_finder {
+    void VJBatchAligner::Initialize() {
+        VERIFY_MSG(num_threads_ > 0, "Number of threads should be positive");
+        for(size_t i = 0; i < num_threads_; i++)
+            query_processors_.push_back(std::make_shared<VJQueryProcessor>(algorithm_params_, read_archive_,
+                                                                           germline_index_));
+    }
+
+    void VJBatchAligner::AlignReadArchive(const ResultCallback &callback) {
+        processed_reads_.clear();
+        processed_reads_.reserve(read_archive_.size());
+        for(size_t i = 0; i < read_archive_.size(); i++)
+            processed_reads_.emplace_back(read_archive_[i]);
+#pragma omp parallel num_threads(int(num_threads_))
+        {
+            VJQueryProcessor &vj_query_processor = *query_processors_[omp_get_thread_num()];
+#pragma omp for schedule(dynamic)
+            for(size_t i = 0; i < read_archive_.size(); i++) {
+                auto processed_read = vj_query_processor.Process(read_archive_[i]);
+                processed_reads_[i].filtering_info = processed_read.filtering_info;
+                if(!processed_read.ReadToBeFiltered())
+                    processed_reads_[i].vj_hits = std::move(processed_read.vj_hits);
+            }
+        }
+        for(size_t i = 0; i < processed_reads_.size(); i++)
+            callback(i, processed_reads_[i]);
+    }
+
+    void VJBatchAligner::Align(const seqan::Dna5String *seqs, size_t num_seqs, const ResultCallback &callback) {
+        read_archive_.Clear();
+        for(size_t i = 0; i < num_seqs; i++)
+            read_archive_.AddRead(std::to_string(i), seqs[i]);
+        AlignReadArchive(callback);
+    }
+
+    void VJBatchAligner::Align(const std::vector<seqan::Dna5String> &seqs, const std::vector<std::string> &names,
+                               const ResultCallback &callback) {
+        VERIFY_MSG(seqs.size() == names.size(), "Numbers of sequences (" << seqs.size() << ") and names (" <<
+                names.size() << ") do not match");
+        read_archive_.Clear();
+        for(size_t i = 0; i < seqs.size(); i++)
+            read_archive_.AddRead(names[i], seqs[i]);
+        AlignReadArchive(callback);
+    }
+
+    StrandVoteStats VJBatchAligner::GetStrandVoteStats() const {
+        StrandVoteStats stats;
+        for(auto it = query_processors_.cbegin(); it != query_processors_.cend(); it++)
+            stats.Update((*it)->GetStrandVoteStats());
+        return stats;
+    }
+}
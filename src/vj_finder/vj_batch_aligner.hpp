@@ -0,0 +1,62 @@
+#pragma once
+
+#include <functional>
+
+#include "vj_query_processing.hpp"
+#include "vj_germline_index.hpp"
+
+namespace vj_finder {
+    // in-memory interface of VJ Finder for tools that align reads in-process (e.g., CDR labeler, IgSimulator):
+    // sequences are aligned against a prebuilt germline index that can be shared by several aligners,
+    // results are passed to the callback in the order of input sequences
+    //
+    // query processors of threads are created once and reused for all batches, so a single aligner should be
+    // used for many batches; Align is not thread-safe, each client thread should use its own aligner
+    // reads are not deduplicated in batches, deduplicate_reads parameter is ignored
+    class VJBatchAligner {
+    public:
+        // index is 0-based index of sequence in the batch
+        // processed hits refer to the read stored in the aligner (its sequence can be reverse-complemented,
+        // cropped or filled), they are valid only during the call of the callback
+        typedef std::function<void(size_t index, const ProcessedVJHits &processed_hits)> ResultCallback;
+
+    private:
+        const VJFinderConfig::AlgorithmParams &algorithm_params_;
+        const VJGermlineIndex &germline_index_;
+        size_t num_threads_;
+
+        // archive is refilled by each batch, query processors are bound to it
+        core::ReadArchive read_archive_;
+        std::vector<std::shared_ptr<VJQueryProcessor>> query_processors_;
+        // i-th slot stores result of i-th sequence of the current batch, each slot is written by a single thread
+        std::vector<ProcessedVJHits> processed_reads_;
+
+        void Initialize();
+
+        void AlignReadArchive(const ResultCallback &callback);
+
+    public:
+        VJBatchAligner(const VJFinderConfig::AlgorithmParams &algorithm_params,
+                       const VJGermlineIndex &germline_index,
+                       size_t num_threads) : algorithm_params_(algorithm_params),
+                                             germline_index_(germline_index),
+                                             num_threads_(num_threads) {
+            Initialize();
+        }
+
+        // aligns num_seqs sequences starting from seqs
+        void Align(const seqan::Dna5String *seqs, size_t num_seqs, const ResultCallback &callback);
+
+        void Align(const std::vector<seqan::Dna5String> &seqs, const ResultCallback &callback) {
+            Align(seqs.data(), seqs.size(), callback);
+        }
+
+        // names of reads are used instead of indices in names of the processed reads
+        void Align(const std::vector<seqan::Dna5String> &seqs, const std::vector<std::string> &names,
+                   const ResultCallback &callback);
+
+        size_t NumThreads() const { return num_threads_; }
+
+        StrandVoteStats GetStrandVoteStats() const;
+    };
+}
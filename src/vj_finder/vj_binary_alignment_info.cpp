@@ -0,0 +1,273 @@
+#include <verify.hpp>
+#include <logger/logger.hpp>
+#include <convert.hpp>
+
+#include <cstring>
+
+#include "vj_binary_alignment_info.hpp"
+
+namespace vj_finder {
+    const char VJBinaryAlignmentFormat::magic[8] = {'V', 'J', 'F', 'B', 'I', 'N', '0', '1'};
+    const uint64_t VJBinaryAlignmentFormat::version;
+    const uint32_t VJBinaryAlignmentFormat::missing_gene;
+
+    namespace {
+        const size_t section_alignment = 8;
+
+        size_t PaddedSize(size_t size) {
+            return (size + section_alignment - 1) / section_alignment * section_alignment;
+        }
+
+        int64_t GetFilteringValue(const VJFilteringInfo &filtering_info) {
+            switch(filtering_info.filtering_reason) {
+                case VJFilteringReason::LeftUncoveredLimitReason:
+                    return filtering_info.left_uncovered_length;
+                case VJFilteringReason::RightUncoveredLimitReason:
+                    return filtering_info.right_uncovered_length;
+                case VJFilteringReason::VSegmentLengthReason:
+                    return int64_t(filtering_info.v_segment_length);
+                case VJFilteringReason::JSegmentLengthReason:
+                    return int64_t(filtering_info.j_segment_length);
+                case VJFilteringReason::AlignedSegmentLengthReason:
+                    return int64_t(filtering_info.aligned_segment_length);
+                default:
+                    return 0;
+            }
+        }
+
+        // returns pointer to the column of size elements and moves pos to the next section
+        template<typename T>
+        const T* ExtractColumn(const char *data, size_t &pos, size_t size, size_t section_end) {
+            const T* column = reinterpret_cast<const T*>(data + pos);
+            pos += PaddedSize(size * sizeof(T));
+            VERIFY_MSG(pos <= section_end, "Binary alignment info is truncated");
+            return column;
+        }
+    }
+
+    void VJBinaryAlignmentWriter::Columns::Clear() {
+        read_index.clear();
+        name_offset.assign(1, 0);
+        v_score.clear();
+        j_score.clear();
+        filtering_value.clear();
+        v_gene.clear();
+        j_gene.clear();
+        v_start.clear();
+        v_end.clear();
+        j_start.clear();
+        j_end.clear();
+        chain_type.clear();
+        strand.clear();
+        filtering_reason.clear();
+        names.clear();
+    }
+
+    VJBinaryAlignmentWriter::VJBinaryAlignmentWriter(std::string fname, size_t num_aligned_candidates) :
+            fname_(fname),
+            out_(fname, std::ios::binary),
+            num_aligned_candidates_(num_aligned_candidates),
+            num_written_reads_(0),
+            num_blocks_(0) {
+        VERIFY_MSG(out_.good(), "Binary alignment info " << fname << " cannot be opened");
+        out_.write(VJBinaryAlignmentFormat::magic, sizeof(VJBinaryAlignmentFormat::magic));
+        uint64_t version = VJBinaryAlignmentFormat::version;
+        WriteColumn(&version, 1);
+        columns_.Clear();
+    }
+
+    uint32_t VJBinaryAlignmentWriter::GetGeneId(const germline_utils::ImmuneGene &gene) {
+        auto it = gene_ids_.insert(std::make_pair(&gene, uint32_t(genes_.size())));
+        if(it.second)
+            genes_.push_back(&gene);
+        return it.first->second;
+    }
+
+    void VJBinaryAlignmentWriter::AddRow(uint64_t read_index, const std::string &read_name) {
+        columns_.read_index.push_back(read_index);
+        columns_.names += read_name;
+        columns_.name_offset.push_back(columns_.names.size());
+    }
+
+    void VJBinaryAlignmentWriter::AddAlignedRead(const VJHits &vj_hits, uint64_t read_index) {
+        uint8_t chain_type = uint8_t(vj_hits.Chain().Chain());
+        for(size_t i = 0; i < num_aligned_candidates_; i++) {
+            const VGeneHit &v_hit = vj_hits.GetVHitByIndex(i);
+            const JGeneHit &j_hit = vj_hits.GetJHitByIndex(i);
+            AddRow(read_index, vj_hits.Read().name);
+            columns_.v_score.push_back(v_hit.Score());
+            columns_.j_score.push_back(j_hit.Score());
+            columns_.filtering_value.push_back(0);
+            columns_.v_gene.push_back(GetGeneId(v_hit.ImmuneGene()));
+            columns_.j_gene.push_back(GetGeneId(j_hit.ImmuneGene()));
+            columns_.v_start.push_back(int32_t(v_hit.FirstMatchReadPos()));
+            columns_.v_end.push_back(int32_t(v_hit.LastMatchReadPos()));
+            columns_.j_start.push_back(int32_t(j_hit.FirstMatchReadPos()));
+            columns_.j_end.push_back(int32_t(j_hit.LastMatchReadPos()));
+            columns_.chain_type.push_back(chain_type);
+            columns_.strand.push_back(uint8_t(v_hit.Strand()));
+            columns_.filtering_reason.push_back(uint8_t(VJFilteringReason::UnknownFilteringReason));
+        }
+    }
+
+    void VJBinaryAlignmentWriter::AddFilteredRead(const VJFilteringInfo &filtering_info, uint64_t read_index) {
+        AddRow(read_index, filtering_info.read->name);
+        columns_.v_score.push_back(0);
+        columns_.j_score.push_back(0);
+        columns_.filtering_value.push_back(GetFilteringValue(filtering_info));
+        columns_.v_gene.push_back(VJBinaryAlignmentFormat::missing_gene);
+        columns_.j_gene.push_back(VJBinaryAlignmentFormat::missing_gene);
+        columns_.v_start.push_back(0);
+        columns_.v_end.push_back(0);
+        columns_.j_start.push_back(0);
+        columns_.j_end.push_back(0);
+        columns_.chain_type.push_back(uint8_t(germline_utils::ImmuneChainType::UnknownImmuneChain));
+        columns_.strand.push_back(0);
+        columns_.filtering_reason.push_back(uint8_t(filtering_info.filtering_reason));
+    }
+
+    template<typename T>
+    void VJBinaryAlignmentWriter::WriteColumn(const T *data, size_t size) {
+        size_t num_bytes = size * sizeof(T);
+        out_.write(reinterpret_cast<const char*>(data), std::streamsize(num_bytes));
+        static const char padding[section_alignment] = {0};
+        out_.write(padding, std::streamsize(PaddedSize(num_bytes) - num_bytes));
+    }
+
+    void VJBinaryAlignmentWriter::Write(const VJAlignmentInfo &alignment_info) {
+        columns_.Clear();
+        for(size_t i = 0; i < alignment_info.NumVJHits(); i++) {
+            const VJHits &vj_hits = alignment_info.GetVJHitsByIndex(i);
+            AddAlignedRead(vj_hits, num_written_reads_ + vj_hits.Read().id);
+        }
+        for(size_t i = 0; i < alignment_info.NumFilteredReads(); i++) {
+            const VJFilteringInfo &filtering_info = alignment_info.GetFilteringInfoByIndex(i);
+            AddFilteredRead(filtering_info, num_written_reads_ + filtering_info.read->id);
+        }
+        uint64_t block_header[] = {uint64_t(columns_.read_index.size()), uint64_t(columns_.names.size())};
+        WriteColumn(block_header, 2);
+        WriteColumn(columns_.read_index);
+        WriteColumn(columns_.name_offset);
+        WriteColumn(columns_.v_score);
+        WriteColumn(columns_.j_score);
+        WriteColumn(columns_.filtering_value);
+        WriteColumn(columns_.v_gene);
+        WriteColumn(columns_.j_gene);
+        WriteColumn(columns_.v_start);
+        WriteColumn(columns_.v_end);
+        WriteColumn(columns_.j_start);
+        WriteColumn(columns_.j_end);
+        WriteColumn(columns_.chain_type);
+        WriteColumn(columns_.strand);
+        WriteColumn(columns_.filtering_reason);
+        WriteColumn(columns_.names.data(), columns_.names.size());
+        num_written_reads_ += alignment_info.NumVJHits() + alignment_info.NumFilteredReads();
+        num_blocks_++;
+    }
+
+    void VJBinaryAlignmentWriter::WriteGeneTable() {
+        std::string names;
+        std::vector<uint64_t> name_offset(1, 0);
+        for(auto it = genes_.begin(); it != genes_.end(); it++) {
+            names += core::seqan_string_to_string((*it)->name());
+            name_offset.push_back(names.size());
+        }
+        uint64_t table_header[] = {uint64_t(genes_.size()), uint64_t(names.size())};
+        WriteColumn(table_header, 2);
+        WriteColumn(name_offset);
+        WriteColumn(names.data(), names.size());
+    }
+
+    void VJBinaryAlignmentWriter::Close() {
+        uint64_t gene_table_offset = uint64_t(out_.tellp());
+        WriteGeneTable();
+        uint64_t trailer[] = {gene_table_offset, num_blocks_};
+        WriteColumn(trailer, 2);
+        out_.write(VJBinaryAlignmentFormat::magic, sizeof(VJBinaryAlignmentFormat::magic));
+        out_.close();
+        INFO("Binary alignment info was written to " << fname_);
+    }
+
+    VJBinaryAlignmentReader::VJBinaryAlignmentReader(const std::string &fname) :
+            file_(fname, false, size_t(-1)),
+            num_rows_(0),
+            num_genes_(0),
+            gene_name_offset_(NULL),
+            gene_names_(NULL) {
+        Initialize(fname);
+    }
+
+    void VJBinaryAlignmentReader::Initialize(const std::string &fname) {
+        const char *data = static_cast<const char*>(file_.data());
+        size_t file_size = file_.size();
+        const size_t header_size = sizeof(VJBinaryAlignmentFormat::magic) + sizeof(uint64_t);
+        const size_t trailer_size = 2 * sizeof(uint64_t) + sizeof(VJBinaryAlignmentFormat::magic);
+        VERIFY_MSG(file_size >= header_size + trailer_size and
+                   memcmp(data, VJBinaryAlignmentFormat::magic, sizeof(VJBinaryAlignmentFormat::magic)) == 0 and
+                   memcmp(data + file_size - sizeof(VJBinaryAlignmentFormat::magic), VJBinaryAlignmentFormat::magic,
+                          sizeof(VJBinaryAlignmentFormat::magic)) == 0,
+                   "File " << fname << " is not a binary alignment info");
+        size_t pos = sizeof(VJBinaryAlignmentFormat::magic);
+        uint64_t version = *ExtractColumn<uint64_t>(data, pos, 1, file_size);
+        VERIFY_MSG(version == VJBinaryAlignmentFormat::version, "Unsupported version of binary alignment info: " <<
+                version);
+        const uint64_t *trailer = reinterpret_cast<const uint64_t*>(data + file_size - trailer_size);
+        size_t gene_table_offset = size_t(trailer[0]);
+        size_t num_blocks = size_t(trailer[1]);
+        for(size_t i = 0; i < num_blocks; i++) {
+            const uint64_t *block_header = ExtractColumn<uint64_t>(data, pos, 2, gene_table_offset);
+            Block block;
+            block.num_rows = size_t(block_header[0]);
+            size_t n = block.num_rows;
+            block.read_index = ExtractColumn<uint64_t>(data, pos, n, gene_table_offset);
+            block.name_offset = ExtractColumn<uint64_t>(data, pos, n + 1, gene_table_offset);
+            block.v_score = ExtractColumn<double>(data, pos, n, gene_table_offset);
+            block.j_score = ExtractColumn<double>(data, pos, n, gene_table_offset);
+            block.filtering_value = ExtractColumn<int64_t>(data, pos, n, gene_table_offset);
+            block.v_gene = ExtractColumn<uint32_t>(data, pos, n, gene_table_offset);
+            block.j_gene = ExtractColumn<uint32_t>(data, pos, n, gene_table_offset);
+            block.v_start = ExtractColumn<int32_t>(data, pos, n, gene_table_offset);
+            block.v_end = ExtractColumn<int32_t>(data, pos, n, gene_table_offset);
+            block.j_start = ExtractColumn<int32_t>(data, pos, n, gene_table_offset);
+            block.j_end = ExtractColumn<int32_t>(data, pos, n, gene_table_offset);
+            block.chain_type = ExtractColumn<uint8_t>(data, pos, n, gene_table_offset);
+            block.strand = ExtractColumn<uint8_t>(data, pos, n, gene_table_offset);
+            block.filtering_reason = ExtractColumn<uint8_t>(data, pos, n, gene_table_offset);
+            block.names = ExtractColumn<char>(data, pos, size_t(block_header[1]), gene_table_offset);
+            blocks_.push_back(block);
+            num_rows_ += n;
+        }
+        VERIFY_MSG(pos == gene_table_offset, "Blocks of binary alignment info are inconsistent with gene table");
+        const uint64_t *table_header = ExtractColumn<uint64_t>(data, pos, 2, file_size - trailer_size);
+        num_genes_ = size_t(table_header[0]);
+        gene_name_offset_ = ExtractColumn<uint64_t>(data, pos, num_genes_ + 1, file_size - trailer_size);
+        gene_names_ = ExtractColumn<char>(data, pos, size_t(table_header[1]), file_size - trailer_size);
+    }
+
+    void ConvertBinaryAlignmentInfoToTsv(const VJBinaryAlignmentReader &reader,
+                                         std::ostream &alignment_info_out,
+                                         std::ostream &filtering_info_out) {
+        std::vector<std::string> gene_names;
+        for(uint32_t i = 0; i < reader.NumGenes(); i++)
+            gene_names.push_back(reader.GeneName(i));
+        WriteAlignmentInfoHeader(alignment_info_out);
+        for(size_t b = 0; b < reader.NumBlocks(); b++) {
+            const VJBinaryAlignmentReader::Block &block = reader.GetBlock(b);
+            for(size_t i = 0; i < block.num_rows; i++) {
+                if(block.Filtered(i)) {
+                    auto filtering_reason = VJFilteringReason(block.filtering_reason[i]);
+                    filtering_info_out << block.ReadName(i) << "\t" << filtering_reason;
+                    if(filtering_reason != VJFilteringReason::VJHitsAreEmptyReason)
+                        filtering_info_out << "\t" << block.filtering_value[i];
+                    filtering_info_out << '\n';
+                    continue;
+                }
+                alignment_info_out << block.ReadName(i) << "\t" <<
+                        germline_utils::ChainType(germline_utils::ImmuneChainType(block.chain_type[i])) << "\t" <<
+                        gene_names[block.v_gene[i]] << "\t" << block.v_start[i] + 1 << "\t" << block.v_end[i] <<
+                        "\t" << block.v_score[i] << "\t" << gene_names[block.j_gene[i]] << "\t" <<
+                        block.j_start[i] + 1 << "\t" << block.j_end[i] << "\t" << block.j_score[i] << "\t\n";
+            }
+        }
+    }
+}
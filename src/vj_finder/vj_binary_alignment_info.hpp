@@ -0,0 +1,158 @@
+#pragma once
+
+#include <fstream>
+#include <cstdint>
+#include <unordered_map>
+
+#include <io/mmapped_reader.hpp>
+
+#include "vj_alignment_info.hpp"
+
+namespace vj_finder {
+    // columnar binary counterpart of alignment_info.csv and filtering_info.csv
+    //
+    // layout of the file (numbers are stored in the host byte order, each section is padded to 8 bytes):
+    //   header:     char magic[8], uint64 version
+    //   blocks:     uint64 num_rows, uint64 names_size and columns of num_rows elements (in this order):
+    //               uint64 read_index, uint64 name_offset (num_rows + 1 elements), double v_score, double j_score,
+    //               int64 filtering_value, uint32 v_gene, uint32 j_gene, int32 v_start, int32 v_end,
+    //               int32 j_start, int32 j_end, uint8 chain_type, uint8 strand, uint8 filtering_reason,
+    //               char names[names_size]
+    //   gene table: uint64 num_genes, uint64 names_size, uint64 name_offset[num_genes + 1], char names[names_size]
+    //   trailer:    uint64 gene_table_offset, uint64 num_blocks, char magic[8]
+    //
+    // aligned read takes num_aligned_candidates rows (a row per line of alignment_info.csv),
+    // filtered read takes a single row with missing_gene instead of gene ids
+    // start positions are 0-based and inclusive, end positions are exclusive
+    // in-memory output consists of a single block, streaming output writes a block per chunk
+    struct VJBinaryAlignmentFormat {
+        static const char magic[8];
+        static const uint64_t version = 1;
+        static const uint32_t missing_gene = uint32_t(-1);
+    };
+
+    class VJBinaryAlignmentWriter {
+        // columns of the current block
+        struct Columns {
+            std::vector<uint64_t> read_index;
+            std::vector<uint64_t> name_offset;
+            std::vector<double> v_score;
+            std::vector<double> j_score;
+            std::vector<int64_t> filtering_value;
+            std::vector<uint32_t> v_gene;
+            std::vector<uint32_t> j_gene;
+            std::vector<int32_t> v_start;
+            std::vector<int32_t> v_end;
+            std::vector<int32_t> j_start;
+            std::vector<int32_t> j_end;
+            std::vector<uint8_t> chain_type;
+            std::vector<uint8_t> strand;
+            std::vector<uint8_t> filtering_reason;
+            std::string names;
+
+            void Clear();
+        };
+
+        std::string fname_;
+        std::ofstream out_;
+        size_t num_aligned_candidates_;
+
+        uint64_t num_written_reads_;
+        uint64_t num_blocks_;
+        Columns columns_;
+
+        // genes are identified by their addresses in germline databases
+        std::unordered_map<const germline_utils::ImmuneGene*, uint32_t> gene_ids_;
+        std::vector<const germline_utils::ImmuneGene*> genes_;
+
+        uint32_t GetGeneId(const germline_utils::ImmuneGene &gene);
+
+        void AddRow(uint64_t read_index, const std::string &read_name);
+
+        void AddAlignedRead(const VJHits &vj_hits, uint64_t read_index);
+
+        void AddFilteredRead(const VJFilteringInfo &filtering_info, uint64_t read_index);
+
+        template<typename T>
+        void WriteColumn(const T *data, size_t size);
+
+        template<typename T>
+        void WriteColumn(const std::vector<T> &column) { WriteColumn(column.data(), column.size()); }
+
+        void WriteGeneTable();
+
+    public:
+        VJBinaryAlignmentWriter(std::string fname, size_t num_aligned_candidates);
+
+        // writes alignment info as a single block, read indices of block are counted from the end of previous one
+        void Write(const VJAlignmentInfo &alignment_info);
+
+        void Close();
+
+        size_t NumWrittenReads() const { return num_written_reads_; }
+    };
+
+    // file is mapped into memory, columns of blocks are accessed directly without copying
+    class VJBinaryAlignmentReader {
+    public:
+        struct Block {
+            size_t num_rows;
+            const uint64_t *read_index;
+            const uint64_t *name_offset;
+            const double *v_score;
+            const double *j_score;
+            const int64_t *filtering_value;
+            const uint32_t *v_gene;
+            const uint32_t *j_gene;
+            const int32_t *v_start;
+            const int32_t *v_end;
+            const int32_t *j_start;
+            const int32_t *j_end;
+            const uint8_t *chain_type;
+            const uint8_t *strand;
+            const uint8_t *filtering_reason;
+            const char *names;
+
+            bool Filtered(size_t row) const { return v_gene[row] == VJBinaryAlignmentFormat::missing_gene; }
+
+            std::string ReadName(size_t row) const {
+                return std::string(names + name_offset[row], names + name_offset[row + 1]);
+            }
+        };
+
+    private:
+        MMappedReader file_;
+        std::vector<Block> blocks_;
+        size_t num_rows_;
+
+        size_t num_genes_;
+        const uint64_t *gene_name_offset_;
+        const char *gene_names_;
+
+        void Initialize(const std::string &fname);
+
+    public:
+        explicit VJBinaryAlignmentReader(const std::string &fname);
+
+        size_t NumBlocks() const { return blocks_.size(); }
+
+        const Block& GetBlock(size_t index) const {
+            VERIFY_MSG(index < blocks_.size(), "Block index " << index << " exceeds number of blocks");
+            return blocks_[index];
+        }
+
+        size_t NumRows() const { return num_rows_; }
+
+        size_t NumGenes() const { return num_genes_; }
+
+        std::string GeneName(uint32_t gene_id) const {
+            VERIFY_MSG(gene_id < num_genes_, "Gene id " << gene_id << " exceeds number of genes");
+            return std::string(gene_names_ + gene_name_offset_[gene_id], gene_names_ + gene_name_offset_[gene_id + 1]);
+        }
+    };
+
+    // writes content of binary file in the format of alignment_info.csv and filtering_info.csv
+    void ConvertBinaryAlignmentInfoToTsv(const VJBinaryAlignmentReader &reader,
+                                         std::ostream &alignment_info_out,
+                                         std::ostream &filtering_info_out);
+}
@@ -10,6 +10,8 @@ namespace vj_finder {
     void load(VJFinderConfig::RunParams &rp, boost::property_tree::ptree const &pt, bool) {
         using config_common::load;
         load(rp.num_threads, pt, "num_threads");
+        load(rp.streaming_mode, pt, "streaming_mode");
+        load(rp.chunk_size, pt, "chunk_size");
     }
 
     void update_input_config(VJFinderConfig::IOParams::InputParams & ip) {
@@ -32,6 +34,7 @@ namespace vj_finder {
         load(od.fix_spaces, pt, "fix_spaces");
         load(od.separator, pt, "separator");
         load(od.num_aligned_candidates, pt, "num_aligned_candidates");
+        load(od.binary_alignment_info, pt, "binary_alignment_info");
     }
 
     void update_output_files_config(VJFinderConfig::IOParams::OutputParams::OutputFiles & of) {
@@ -41,6 +44,7 @@ namespace vj_finder {
         of.filtering_info_filename = path::append_path(of.output_dir, of.filtering_info_filename);
         of.cleaned_reads_fname = path::append_path(of.output_dir, of.cleaned_reads_fname);
         of.valignments_filename = path::append_path(of.output_dir, of.valignments_filename);
+        of.binary_alignment_info_fname = path::append_path(of.output_dir, of.binary_alignment_info_fname);
     }
 
     void load(VJFinderConfig::IOParams::OutputParams::OutputFiles & of,
@@ -53,6 +57,7 @@ namespace vj_finder {
         load(of.output_dir, pt, "output_dir");
         load(of.cleaned_reads_fname, pt, "cleaned_reads_fname");
         load(of.valignments_filename, pt, "valignments_filename");
+        load(of.binary_alignment_info_fname, pt, "binary_alignment_info_fname");
         //update_output_files_config(of);
     }
 
@@ -72,11 +77,23 @@ namespace vj_finder {
         using config_common::load;
         load(ap.word_size_v, pt, "word_size_v");
         load(ap.word_size_j, pt, "word_size_j");
+        load(ap.minimizer_window_v, pt, "minimizer_window_v");
+        load(ap.minimizer_window_j, pt, "minimizer_window_j");
+        // consecutive minimizers should overlap or abut to be merged into one match by block aligner
+        VERIFY_MSG(ap.minimizer_window_v <= ap.word_size_v && ap.minimizer_window_j <= ap.word_size_j,
+                   "minimizer_window_v (" << ap.minimizer_window_v << ") and minimizer_window_j (" <<
+                   ap.minimizer_window_j << ") should not exceed word_size_v (" << ap.word_size_v <<
+                   ") and word_size_j (" << ap.word_size_j << ")");
         load(ap.min_k_coverage_v, pt, "min_k_coverage_v");
         load(ap.min_k_coverage_j, pt, "min_k_coverage_j");
         load(ap.max_candidates_v, pt, "max_candidates_v");
         load(ap.max_candidates_j, pt, "max_candidates_j");
         load(ap.fix_strand, pt, "fix_strand");
+        load(ap.strand_vote_ratio, pt, "strand_vote_ratio");
+        VERIFY_MSG(ap.strand_vote_ratio <= 0 || ap.strand_vote_ratio > 1,
+                   "strand_vote_ratio should be greater than 1 or non-positive to disable vote, but it is " <<
+                   ap.strand_vote_ratio);
+        load(ap.deduplicate_reads, pt, "deduplicate_reads");
     }
 
     void load(VJFinderConfig::AlgorithmParams::FilteringParams &fp, boost::property_tree::ptree const &pt, bool) {
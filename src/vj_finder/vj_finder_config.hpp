@@ -9,6 +9,8 @@ namespace vj_finder {
     struct VJFinderConfig {
         struct RunParams {
             size_t num_threads;
+            bool streaming_mode;
+            size_t chunk_size;
         };
 
         struct IOParams {
@@ -27,6 +29,7 @@ namespace vj_finder {
                     std::string alignment_info_fname;
                     std::string filtering_info_filename;
                     std::string valignments_filename;
+                    std::string binary_alignment_info_fname;
                 };
 
                 struct OutputDetails {
@@ -34,6 +37,8 @@ namespace vj_finder {
                     bool fix_spaces;
                     std::string separator;
                     size_t num_aligned_candidates;
+                    // alignment info is written in columnar binary format instead of alignment_info.csv
+                    bool binary_alignment_info;
                 };
 
                 OutputFiles output_files;
@@ -48,11 +53,21 @@ namespace vj_finder {
             struct AlignerParams {
                 size_t word_size_v;
                 size_t word_size_j;
+                // k-mer indices are sampled by (w, k)-minimizers if window w > 1, 1 means that all k-mers are used;
+                // larger windows decrease index size and the number of k-mer matches, but also sensitivity
+                size_t minimizer_window_v;
+                size_t minimizer_window_j;
                 size_t min_k_coverage_v;
                 size_t min_k_coverage_j;
                 size_t max_candidates_v;
                 size_t max_candidates_j;
                 bool fix_strand;
+                // strand is selected without alignment of reverse-complement read if numbers of k-mer hits
+                // of one strand exceeds that of another one at least strand_vote_ratio times;
+                // the ratio should be greater than 1, 0 disables vote
+                double strand_vote_ratio;
+                // align only one read from each group of reads with identical sequences
+                bool deduplicate_reads;
             };
 
             struct FilteringParams {
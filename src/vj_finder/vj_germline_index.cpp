@@ -0,0 +1,38 @@
+#include <verify.hpp>
+#include <logger/logger.hpp>
+
+#include "vj_germline_index.hpp"
+
+namespace vj_finder {
+    VJGermlineIndex::VJGermlineIndex(const germline_utils::CustomGeneDatabase &v_db,
+                                     const germline_utils::CustomGeneDatabase &j_db,
+                                     const VJFinderConfig::AlgorithmParams::AlignerParams &aligner_params) :
+            v_db_(v_db),
+            j_db_(j_db),
+            v_helper_(v_db),
+            v_kmer_index_(v_db, aligner_params.word_size_v, v_helper_, aligner_params.minimizer_window_v) {
+        CheckDbConsistencyFatal();
+        TRACE("Kmer index for V gene segment DB was constructed");
+        InitializeJIndices(aligner_params.word_size_j, aligner_params.minimizer_window_j);
+    }
+
+    void VJGermlineIndex::CheckDbConsistencyFatal() const {
+        VERIFY_MSG(v_db_.num_dbs() == j_db_.num_dbs(), "Size of V gene DB (" << v_db_.num_dbs() <<
+                ") does not match with J gene DB (" << j_db_.num_dbs() << ")");
+    }
+
+    void VJGermlineIndex::InitializeJIndices(size_t word_size_j, size_t minimizer_window_j) {
+        for(auto it = j_db_.cbegin(); it != j_db_.cend(); it++) {
+            const germline_utils::ImmuneGeneDatabase &j_gene_db = j_db_.GetConstDbByGeneType(*it);
+            j_chain_indices_[it->Chain()] = std::make_shared<JChainIndex>(j_gene_db, word_size_j, minimizer_window_j);
+            TRACE("Kmer index for J database of locus " << it->Chain() << " (" << j_gene_db.size() <<
+                          " gene segments) was constructed");
+        }
+    }
+
+    const VJGermlineIndex::JChainIndex& VJGermlineIndex::GetJIndexByChain(
+            germline_utils::ChainType chain_type) const {
+        VERIFY_MSG(ContainsJChain(chain_type), "J index does not contain locus " << chain_type);
+        return *(j_chain_indices_.at(chain_type));
+    }
+}
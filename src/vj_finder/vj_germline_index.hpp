@@ -0,0 +1,79 @@
+#pragma once
+
+#include <germline_utils/germline_databases/custom_gene_database.hpp>
+#include <hashes/subject_query_kmer_index.hpp>
+
+#include "vj_finder_config.hpp"
+#include "vj_alignment_structs.hpp"
+
+namespace vj_finder {
+    // class stores read-only k-mer indices of V and J germline databases
+    // indices are constructed once per run and shared by all alignment threads
+    class VJGermlineIndex {
+    public:
+        typedef algorithms::SubjectQueryKmerIndex<germline_utils::CustomGeneDatabase, seqan::Dna5String,
+                CustomGermlineDbHelper> VKmerIndex;
+        typedef algorithms::SubjectQueryKmerIndex<germline_utils::ImmuneGeneDatabase, seqan::Dna5String,
+                ImmuneGeneGermlineDbHelper> JKmerIndex;
+
+        // J index is built separately for each chain type since J search is performed
+        // only after locus of the read was identified by V hits
+        struct JChainIndex {
+            const germline_utils::ImmuneGeneDatabase &db;
+            ImmuneGeneGermlineDbHelper helper;
+            JKmerIndex kmer_index;
+
+            JChainIndex(const germline_utils::ImmuneGeneDatabase &db, size_t k, size_t minimizer_window) :
+                    db(db),
+                    helper(db),
+                    kmer_index(db, k, helper, minimizer_window) { }
+        };
+
+    private:
+        const germline_utils::CustomGeneDatabase &v_db_;
+        const germline_utils::CustomGeneDatabase &j_db_;
+
+        CustomGermlineDbHelper v_helper_;
+        VKmerIndex v_kmer_index_;
+
+        std::unordered_map<germline_utils::ChainType, std::shared_ptr<JChainIndex>,
+                germline_utils::ChainTypeHasher> j_chain_indices_;
+
+        void CheckDbConsistencyFatal() const;
+
+        void InitializeJIndices(size_t word_size_j, size_t minimizer_window_j);
+
+    public:
+        VJGermlineIndex(const germline_utils::CustomGeneDatabase &v_db,
+                        const germline_utils::CustomGeneDatabase &j_db,
+                        const VJFinderConfig::AlgorithmParams::AlignerParams &aligner_params);
+
+        VJGermlineIndex(const VJGermlineIndex&) = delete;
+
+        VJGermlineIndex& operator=(const VJGermlineIndex&) = delete;
+
+        const germline_utils::CustomGeneDatabase& VDb() const { return v_db_; }
+
+        const germline_utils::CustomGeneDatabase& JDb() const { return j_db_; }
+
+        const CustomGermlineDbHelper& VHelper() const { return v_helper_; }
+
+        const VKmerIndex& VIndex() const { return v_kmer_index_; }
+
+        bool ContainsJChain(germline_utils::ChainType chain_type) const {
+            return j_chain_indices_.find(chain_type) != j_chain_indices_.end();
+        }
+
+        const JChainIndex& GetJIndexByChain(germline_utils::ChainType chain_type) const;
+
+        typedef std::unordered_map<germline_utils::ChainType, std::shared_ptr<JChainIndex>,
+                germline_utils::ChainTypeHasher>::const_iterator JChainIndexConstIter;
+
+        JChainIndexConstIter j_chain_cbegin() const { return j_chain_indices_.cbegin(); }
+
+        JChainIndexConstIter j_chain_cend() const { return j_chain_indices_.cend(); }
+
+    private:
+        DECL_LOGGER("VJGermlineIndex");
+    };
+}
@@ -2,48 +2,71 @@
 
 namespace vj_finder {
     void VJParallelProcessor::Initialize() {
-        for(size_t i = 0; i < read_archive_.size(); i++)
-            thread_id_per_read_.push_back(size_t(-1));
-        for(size_t i = 0; i < num_threads_; i++)
-            info_per_thread.push_back(VJAlignmentInfo());
+        processed_groups_.reserve(read_duplicates_.NumUniqueReads());
+        for(size_t group_index = 0; group_index < read_duplicates_.NumUniqueReads(); group_index++)
+            processed_groups_.emplace_back(read_archive_[read_duplicates_.UniqueReadIndex(group_index)]);
     }
 
-    VJAlignmentInfo VJParallelProcessor::GatherAlignmentInfos() {
-        VJAlignmentInfo consistent_alignment_info;
+    VJAlignmentInfo VJParallelProcessor::CollectAlignmentInfo() {
+        VJAlignmentInfo alignment_info;
+        alignment_info.Reserve(read_archive_.size());
         for(size_t i = 0; i < read_archive_.size(); i++) {
-            size_t thread_id = thread_id_per_read_[i];
-            if(info_per_thread[thread_id].ReadIsFiltered(read_archive_[i])) {
-                size_t local_index = info_per_thread[thread_id].GetFilteringInfoIndexByRead(read_archive_[i]);
-                consistent_alignment_info.UpdateFilteringInfo(
-                        info_per_thread[thread_id].GetFilteringInfoByIndex(local_index));
+            size_t group_index = read_duplicates_.GetGroupIndex(i);
+            ProcessedVJHits &processed_group = processed_groups_[group_index];
+            bool is_representative = read_duplicates_.IsRepresentative(i);
+            if(processed_group.ReadToBeFiltered()) {
+                alignment_info.UpdateFilteringInfo(is_representative ? processed_group.filtering_info :
+                        PropagateRepresentativeFilteringInfo(processed_group.filtering_info, read_archive_, i));
             }
+            // hits of a unique read are not needed anymore and are moved
+            else if(read_duplicates_.GroupSize(group_index) == 1)
+                alignment_info.AddHitsWithoutChainType(std::move(processed_group.vj_hits));
             else {
-                size_t local_index = info_per_thread[thread_id].GetVJHitIndexByRead(read_archive_[i]);
-                consistent_alignment_info.UpdateHits(info_per_thread[thread_id].GetVJHitsByIndex(local_index));
+                alignment_info.AddHitsWithoutChainType(is_representative ? processed_group.vj_hits :
+                        PropagateRepresentativeHits(processed_group.vj_hits, read_archive_, i));
             }
         }
-        return consistent_alignment_info;
+        alignment_info.AddChainTypeAbundance(chain_type_abundance_);
+        return alignment_info;
     }
 
     VJAlignmentInfo VJParallelProcessor::Process() {
+        if(algorithm_params_.aligner_params.deduplicate_reads)
+            INFO(read_duplicates_.NumUniqueReads() << " unique sequences out of " << read_archive_.size() <<
+                         " reads will be aligned");
         omp_set_num_threads(int(num_threads_));
-#pragma omp parallel for schedule(dynamic)
-        for(size_t i = 0; i < read_archive_.size(); i++) {
-            TRACE("Processing read: " << read_archive_[i].name);
-            size_t thread_id = omp_get_thread_num();
-            thread_id_per_read_[i] = thread_id;
-            VJQueryProcessor vj_query_processor(algorithm_params_, read_archive_, v_db_, j_db_);
-            auto processed_read = vj_query_processor.Process(read_archive_[i]);
-            if(processed_read.ReadToBeFiltered()) {
-//                std::cout << "bad: " << processed_read.filtering_info.filtering_reason << std::endl;
-                info_per_thread[thread_id].UpdateFilteringInfo(processed_read.filtering_info);
+#pragma omp parallel
+        {
+            // query processor keeps aligners over the shared germline index, so it is created once per thread
+            VJQueryProcessor vj_query_processor(algorithm_params_, read_archive_, germline_index_);
+            VJAlignmentInfo::ChainTypeAbundance thread_chain_type_abundance;
+#pragma omp for schedule(dynamic)
+            for(size_t group_index = 0; group_index < read_duplicates_.NumUniqueReads(); group_index++) {
+                // only representatives of groups of identical reads are aligned
+                size_t i = read_duplicates_.UniqueReadIndex(group_index);
+                TRACE("Processing read: " << read_archive_[i].name);
+                auto processed_read = vj_query_processor.Process(read_archive_[i]);
+                ProcessedVJHits &processed_group = processed_groups_[group_index];
+                processed_group.filtering_info = processed_read.filtering_info;
+                if(!processed_read.ReadToBeFiltered()) {
+                    thread_chain_type_abundance[processed_read.vj_hits.Chain()] +=
+                            read_duplicates_.GroupSize(group_index);
+                    processed_group.vj_hits = std::move(processed_read.vj_hits);
+                }
             }
-            else {
-//                std::cout << "good" << std::endl;
-                info_per_thread[thread_id].UpdateHits(processed_read.vj_hits);
+#pragma omp critical
+            {
+                for(auto it = thread_chain_type_abundance.cbegin(); it != thread_chain_type_abundance.cend(); it++)
+                    chain_type_abundance_[it->first] += it->second;
+                strand_vote_stats_.Update(vj_query_processor.GetStrandVoteStats());
+                allocation_stats_.Update(vj_query_processor.GetAllocationStats());
             }
         }
-        auto total_alignment_info = GatherAlignmentInfos();
+        if(algorithm_params_.aligner_params.fix_strand)
+            INFO("Strand selection: " << strand_vote_stats_);
+        if(allocation_counter::Enabled())
+            INFO("Read processing made " << allocation_stats_);
+        auto total_alignment_info = CollectAlignmentInfo();
         size_t num_aligned_reads = total_alignment_info.NumVJHits();
         for(auto it = total_alignment_info.chain_type_cbegin(); it != total_alignment_info.chain_type_cend(); it++) {
             float perc = float(it->second) / float(num_aligned_reads) * 100;
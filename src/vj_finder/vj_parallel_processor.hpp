@@ -2,33 +2,40 @@
 
 #include "vj_alignment_info.hpp"
 #include "vj_query_processing.hpp"
+#include "vj_germline_index.hpp"
+#include "vj_read_duplicates.hpp"
 
 namespace vj_finder {
     class VJParallelProcessor {
         core::ReadArchive &read_archive_;
         const VJFinderConfig::AlgorithmParams &algorithm_params_;
-        const germline_utils::CustomGeneDatabase &v_db_;
-        const germline_utils::CustomGeneDatabase &j_db_;
+        const VJGermlineIndex &germline_index_;
         size_t num_threads_;
+        VJReadDuplicates read_duplicates_;
 
-        // i-th element shows which thread processed i-th read
-        std::vector<size_t> thread_id_per_read_;
-        // i-th element stores Alignment info created by i-th thread
-        std::vector<VJAlignmentInfo> info_per_thread;
+        // i-th slot stores result of processing of representative of i-th group of identical reads,
+        // slots are preallocated and each of them is written by exactly one thread, so no locking is needed
+        std::vector<ProcessedVJHits> processed_groups_;
+        // chain type abundance of aligned reads is computed by each thread separately and reduced afterwards
+        VJAlignmentInfo::ChainTypeAbundance chain_type_abundance_;
+        StrandVoteStats strand_vote_stats_;
+        ReadAllocationStats allocation_stats_;
 
         void Initialize();
 
-        VJAlignmentInfo GatherAlignmentInfos();
+        // collects results in the order of input reads, results of representatives are propagated to duplicates
+        VJAlignmentInfo CollectAlignmentInfo();
 
     public:
         VJParallelProcessor(core::ReadArchive &read_archive,
                             const VJFinderConfig::AlgorithmParams &algorithm_params,
-                            const germline_utils::CustomGeneDatabase &v_db,
-                            const germline_utils::CustomGeneDatabase &j_db_,
+                            const VJGermlineIndex &germline_index,
                             size_t num_threads) : read_archive_(read_archive),
                                                   algorithm_params_(algorithm_params),
-                                                  v_db_(v_db), j_db_(j_db_),
-                                                  num_threads_(num_threads) {
+                                                  germline_index_(germline_index),
+                                                  num_threads_(num_threads),
+                                                  read_duplicates_(read_archive,
+                                                                   algorithm_params.aligner_params.deduplicate_reads) {
             Initialize();
         }
 
@@ -1,20 +1,50 @@
-#include <unordered_set>
 #include <verify.hpp>
 
 #include <core_utils.hpp>
 #include "vj_query_aligner.hpp"
 
 namespace vj_finder {
-    void VJQueryAligner::CheckDbConsistencyFatal() {
-        VERIFY_MSG(v_custom_db_.num_dbs() == j_custom_db_.num_dbs(), "Size of V gene DB (" << v_custom_db_.num_dbs() <<
-                ") does not match with J gene DB (" << j_custom_db_.num_dbs() << ")");
+    std::ostream& operator<<(std::ostream &out, const StrandVoteStats &stats) {
+        out << "strand of " << stats.num_reads - stats.num_fallbacks << " reads was selected by k-mer vote, " <<
+               stats.num_fallbacks << " reads were aligned in both orientations";
+        return out;
+    }
+
+    void VJQueryAligner::InitializeVAligner() {
+        v_aligner_ = algorithms::CreateSpecializedBlockAligner<germline_utils::CustomGeneDatabase, seqan::Dna5String,
+                DefaultVAlignerPolicy>(
+                germline_index_.VIndex(), germline_index_.VHelper(),
+                CreateBlockAlignmentScoring<VJFinderConfig::AlgorithmParams::ScoringParams::VScoringParams>(
+                        algorithm_params_.scoring_params.v_scoring),
+                CreateVBlockAlignerParams());
+    }
+
+    void VJQueryAligner::InitializeJAligners() {
+        for(auto it = germline_index_.j_chain_cbegin(); it != germline_index_.j_chain_cend(); it++) {
+            auto j_aligner = algorithms::CreateSpecializedBlockAligner<germline_utils::ImmuneGeneDatabase,
+                    seqan::Dna5String, DefaultJAlignerPolicy>(
+                    it->second->kmer_index, it->second->helper,
+                    CreateBlockAlignmentScoring<VJFinderConfig::AlgorithmParams::ScoringParams::JScoringParams>(
+                            algorithm_params_.scoring_params.j_scoring),
+                    CreateJBlockAlignerParams());
+            j_contexts_.emplace(it->first, JAlignmentContext(*it->second, j_aligner));
+        }
+    }
+
+    VJQueryAligner::JAlignmentContext& VJQueryAligner::GetJContext(germline_utils::ChainType chain_type) {
+        auto it = j_contexts_.find(chain_type);
+        VERIFY_MSG(it != j_contexts_.end(), "J index does not contain locus " << chain_type);
+        return it->second;
     }
 
     bool VJQueryAligner::VAlignmentsAreConsistent(const VJQueryAligner::CustomDbBlockAlignmentHits &v_alignments) const {
-        std::unordered_set<germline_utils::ImmuneGeneType, germline_utils::ImmuneGeneTypeHasher> gene_types;
-        for(size_t i = 0; i < v_alignments.size(); i++)
-            gene_types.insert(v_custom_db_[v_alignments[i].second].GeneType());
-        return gene_types.size() == 1;
+        if(v_alignments.size() == 0)
+            return false;
+        const germline_utils::ImmuneGeneType gene_type = v_custom_db_[v_alignments[0].second].GeneType();
+        for(size_t i = 1; i < v_alignments.size(); i++)
+            if(!(v_custom_db_[v_alignments[i].second].GeneType() == gene_type))
+                return false;
+        return true;
     }
 
     germline_utils::ChainType VJQueryAligner::IdentifyLocus(const CustomDbBlockAlignmentHits &v_alignments) const {
@@ -24,88 +54,114 @@ namespace vj_finder {
         return v_custom_db_[index0].Chain();
     }
 
-    seqan::Dna5String VJQueryAligner::DefineReadJSuffix(const CustomDbBlockAlignmentHits &v_alignments,
-                                                        seqan::Dna5String read) const {
+    size_t VJQueryAligner::DefineJWindowStart(const CustomDbBlockAlignmentHits &v_alignments,
+                                              const seqan::Dna5String &read_seq) const {
         size_t end_of_v = core::max_map(v_alignments.cbegin(), v_alignments.cend(),
                                [](const CustomDbBlockAlignmentHits::IndicedPairwiseBlockAlignment &align) ->
                                        size_t { return align.first.last_match_read_pos(); });
-        if(seqan::length(read) - end_of_v < algorithm_params_.filtering_params.min_j_segment_length)
-            return seqan::Dna5String();
-        return seqan::suffix(read, end_of_v + 1);
+        if(seqan::length(read_seq) - end_of_v < algorithm_params_.filtering_params.min_j_segment_length)
+            return seqan::length(read_seq);
+        return end_of_v + 1;
+    }
+
+    VJQueryAligner::StrandVote VJQueryAligner::VoteStrand() const {
+        double vote_ratio = algorithm_params_.aligner_params.strand_vote_ratio;
+        if(vote_ratio <= 0)
+            return StrandVote::AmbiguousStrand;
+        double num_forward_hits = double(strand_lookups_.NumKmerHits(0));
+        double num_reverse_hits = double(strand_lookups_.NumKmerHits(1));
+        TRACE("K-mer hits of forward strand: " << num_forward_hits << ", reverse strand: " << num_reverse_hits);
+        if(num_forward_hits > 0 and num_forward_hits >= vote_ratio * num_reverse_hits)
+            return StrandVote::ForwardStrand;
+        if(num_reverse_hits > 0 and num_reverse_hits >= vote_ratio * num_forward_hits)
+            return StrandVote::ReverseStrand;
+        return StrandVote::AmbiguousStrand;
+    }
+
+    VJQueryAligner::CustomDbBlockAlignmentHits& VJQueryAligner::AlignStrandedV(const core::Read &read,
+                                                                             const seqan::Dna5String* &stranded_seq,
+                                                                             bool &strand) {
+        stranded_seq = &read.seq;
+        strand = true;
+        if(!algorithm_params_.aligner_params.fix_strand) {
+            v_aligner_->Align(read.seq, v_aligns_);
+            return v_aligns_;
+        }
+        seqan::assign(read_rc_seq_, read.seq);
+        seqan::reverseComplement(read_rc_seq_);
+        strand_vote_stats_.num_reads++;
+        const seqan::Dna5String *strands[] = {&read.seq, &read_rc_seq_};
+        germline_index_.VIndex().LookupQueries(strands, 2, strand_lookups_);
+        StrandVote vote = VoteStrand();
+        if(vote == StrandVote::ForwardStrand) {
+            v_aligner_->Align(read.seq, strand_lookups_, 0, v_aligns_);
+            return v_aligns_;
+        }
+        if(vote == StrandVote::ReverseStrand) {
+            TRACE("Reverse complementary strand was selected by k-mer vote");
+            stranded_seq = &read_rc_seq_;
+            strand = false;
+            v_aligner_->Align(read_rc_seq_, strand_lookups_, 1, reverse_v_aligns_);
+            return reverse_v_aligns_;
+        }
+        // vote is ambiguous: both strands are aligned and the best one is selected
+        strand_vote_stats_.num_fallbacks++;
+        v_aligner_->Align(read.seq, strand_lookups_, 0, v_aligns_);
+        v_aligner_->Align(read_rc_seq_, strand_lookups_, 1, reverse_v_aligns_);
+        if(v_aligns_.BestScore() < reverse_v_aligns_.BestScore()) {
+            TRACE("Reverse complementary strand was selected");
+            stranded_seq = &read_rc_seq_;
+            strand = false;
+            return reverse_v_aligns_;
+        }
+        return v_aligns_;
     }
 
     VJHits VJQueryAligner::Align(const core::Read &read) {
         using namespace algorithms;
         TRACE("VJ Aligner algorithm starts");
-        // we can construct it once and use as a parameter of constructor
-        CustomGermlineDbHelper v_kmer_index_helper(v_custom_db_);
-        SubjectQueryKmerIndex<germline_utils::CustomGeneDatabase, seqan::Dna5String> v_kmer_index(
-                v_custom_db_, algorithm_params_.aligner_params.word_size_v, v_kmer_index_helper);
-        TRACE("Kmer index for V gene segment DB was constructed");
-        PairwiseBlockAligner<germline_utils::CustomGeneDatabase, seqan::Dna5String> v_aligner(
-                v_kmer_index, v_kmer_index_helper,
-                CreateBlockAlignmentScoring<VJFinderConfig::AlgorithmParams::ScoringParams::VScoringParams>(
-                algorithm_params_.scoring_params.v_scoring),
-                CreateVBlockAlignerParams());
         TRACE("Computation of V hits");
-        CustomDbBlockAlignmentHits v_aligns = v_aligner.Align(read.seq);
+        const seqan::Dna5String *stranded_seq = &read.seq;
+        bool strand = true;
+        CustomDbBlockAlignmentHits &v_aligns = AlignStrandedV(read, stranded_seq, strand);
         TRACE(v_aligns.size() << " V hits were computed: ")
         for(auto it = v_aligns.begin(); it != v_aligns.end(); it++) {
             TRACE(v_custom_db_[it->second].name() << ", start: " << it->first.first_match_read_pos() <<
                     ", end: " << it->first.last_match_read_pos());
         }
-        core::Read stranded_read = read;
-        bool strand = true;
-        if(algorithm_params_.aligner_params.fix_strand) {
-            core::Read read_rc = read.ReverseComplement();
-            CustomDbBlockAlignmentHits reverse_v_aligns = v_aligner.Align(read_rc.seq);
-            if(v_aligns.BestScore() < reverse_v_aligns.BestScore()) {
-                TRACE("Reverse complementary strand was selected");
-                stranded_read = read_rc;
-                v_aligns = reverse_v_aligns;
-                strand = false;
-            }
-        }
         if(v_aligns.size() == 0 or !VAlignmentsAreConsistent(v_aligns))
             return VJHits(read);
         germline_utils::ChainType v_chain_type = IdentifyLocus(v_aligns);
         TRACE("V Locus was identified: " << v_chain_type);
         TRACE("Strand: " << strand);
 
-        const germline_utils::ImmuneGeneDatabase& j_gene_db = j_custom_db_.GetConstDbByGeneType(
-                germline_utils::ImmuneGeneType(v_chain_type, germline_utils::SegmentType::JoinSegment));
+        JAlignmentContext &j_context = GetJContext(v_chain_type);
+        const germline_utils::ImmuneGeneDatabase& j_gene_db = j_context.chain_index.db;
         TRACE("J database for locus " << v_chain_type << " consists of " << j_gene_db.size() << " gene segments");
-
-        ImmuneGeneGermlineDbHelper j_kmer_index_helper(j_gene_db);
-        SubjectQueryKmerIndex<germline_utils::ImmuneGeneDatabase, seqan::Dna5String> j_kmer_index(
-                j_gene_db, algorithm_params_.aligner_params.word_size_j, j_kmer_index_helper);
-        PairwiseBlockAligner<germline_utils::ImmuneGeneDatabase, seqan::Dna5String> j_aligner(
-                j_kmer_index, j_kmer_index_helper,
-                CreateBlockAlignmentScoring<VJFinderConfig::AlgorithmParams::ScoringParams::JScoringParams>(
-                        algorithm_params_.scoring_params.j_scoring),
-                CreateJBlockAlignerParams());
-        auto dj_read_suffix = DefineReadJSuffix(v_aligns, stranded_read.seq);
-        if(seqan::length(dj_read_suffix) == 0)
+        // J segment is searched in the suffix of stranded read that starts after the end of V segment
+        size_t j_window_start = DefineJWindowStart(v_aligns, *stranded_seq);
+        if(j_window_start >= seqan::length(*stranded_seq))
             return VJHits(read);
 
         TRACE("Computation of J hits");
-        auto j_aligns = j_aligner.Align(dj_read_suffix);
-        //for(auto it = j_aligns.begin(); it != j_aligns.end(); it++)
-        //    it->first.add_read_shift(int(stranded_read.length() - seqan::length(dj_read_suffix)));
+        ImmuneDbBlockAlignmentHits &j_aligns = j_context.j_aligns;
+        j_context.aligner->AlignWindow(*stranded_seq, j_window_start, j_aligns);
         TRACE(j_aligns.size() << " J hits were computed: ")
         for(auto it = j_aligns.begin(); it != j_aligns.end(); it++) {
             TRACE(j_gene_db[it->second].name() << ", Q start: " << it->first.first_match_read_pos() <<
             ", Q end: " << it->first.last_match_read_pos() << ", S start: " << it->first.first_match_subject_pos() <<
             ", S end: " << it->first.last_match_subject_pos());
         }
-        read_archive_.UpdateReadByIndex(read.id, stranded_read.seq);
+        if(!strand)
+            read_archive_.UpdateReadByIndex(read.id, *stranded_seq);
         VJHits vj_hits(read);
+        vj_hits.Reserve(v_aligns.size(), j_aligns.size());
         for(auto it = v_aligns.begin(); it != v_aligns.end(); it++)
             vj_hits.AddVHit(VGeneHit(read, v_custom_db_[it->second], it->first, strand));
         for(auto it = j_aligns.begin(); it != j_aligns.end(); it++) {
             JGeneHit j_hit(read, j_gene_db[it->second], it->first, strand);
-            j_hit.AddShift(int(read.length() - seqan::length(dj_read_suffix)));
-            vj_hits.AddJHit(j_hit);
+            j_hit.AddShift(int(j_window_start));
+            vj_hits.AddJHit(std::move(j_hit));
         }
         return vj_hits;
     }
@@ -3,17 +3,80 @@
 #include "vj_finder_config.hpp"
 #include <germline_utils/germline_databases/custom_gene_database.hpp>
 #include "vj_alignment_structs.hpp"
+#include "vj_germline_index.hpp"
 #include "block_alignment/pairwise_block_aligner.hpp"
 
 namespace vj_finder {
+    // statistics of k-mer vote that selects strand of reads before V alignment
+    struct StrandVoteStats {
+        size_t num_reads;
+        // the number of reads with ambiguous vote that were aligned in both orientations
+        size_t num_fallbacks;
+
+        StrandVoteStats() : num_reads(0), num_fallbacks(0) { }
+
+        void Update(const StrandVoteStats &stats) {
+            num_reads += stats.num_reads;
+            num_fallbacks += stats.num_fallbacks;
+        }
+    };
+
+    std::ostream& operator<<(std::ostream &out, const StrandVoteStats &stats);
+
     class VJQueryAligner {
+        typedef algorithms::BlockAligner<germline_utils::CustomGeneDatabase, seqan::Dna5String> VAligner;
+        typedef algorithms::BlockAligner<germline_utils::ImmuneGeneDatabase, seqan::Dna5String> JAligner;
+
+        typedef algorithms::BlockAlignmentHits<germline_utils::CustomGeneDatabase> CustomDbBlockAlignmentHits;
+
+        typedef algorithms::BlockAlignmentHits<germline_utils::ImmuneGeneDatabase> ImmuneDbBlockAlignmentHits;
+
+        // aligners for the default word sizes and scoring schemes of config are specialized at compile time,
+        // other configurations are aligned by aligners with run-time parameters
+        typedef algorithms::BlockAlignerPolicy<CustomGermlineDbHelper,
+                algorithms::StaticBlockAlignmentScoring<24, 12, 12, 4, 1, 1, 0, 0>, 7> DefaultVAlignerPolicy;
+        typedef algorithms::BlockAlignerPolicy<ImmuneGeneGermlineDbHelper,
+                algorithms::StaticBlockAlignmentScoring<24, 12, 12, 5, 2, 1, 0, 0>, 5> DefaultJAlignerPolicy;
+
         const VJFinderConfig::AlgorithmParams & algorithm_params_;
 
         core::ReadArchive &read_archive_;
+        const VJGermlineIndex &germline_index_;
         const germline_utils::CustomGeneDatabase &v_custom_db_;
-        const germline_utils::CustomGeneDatabase &j_custom_db_;
 
-        void CheckDbConsistencyFatal();
+        StrandVoteStats strand_vote_stats_;
+
+        // workspace: buffers are reused across reads
+        seqan::Dna5String read_rc_seq_;
+        // k-mers of forward (0) and reverse-complement (1) strands of read are looked up in V index by one batch,
+        // the lookups are shared by strand vote and V alignment
+        algorithms::KmerLookupBatch strand_lookups_;
+        // V alignments of forward and reverse-complement strands of read
+        CustomDbBlockAlignmentHits v_aligns_;
+        CustomDbBlockAlignmentHits reverse_v_aligns_;
+
+        // ready-to-use J alignment context of a locus: J database and its index are shared by all threads,
+        // aligner and J alignments keep workspace of this query aligner
+        struct JAlignmentContext {
+            const VJGermlineIndex::JChainIndex &chain_index;
+            std::shared_ptr<JAligner> aligner;
+            ImmuneDbBlockAlignmentHits j_aligns;
+
+            JAlignmentContext(const VJGermlineIndex::JChainIndex &chain_index, std::shared_ptr<JAligner> aligner) :
+                    chain_index(chain_index), aligner(aligner), j_aligns(chain_index.db) { }
+        };
+
+        // aligners are lightweight wrappers over the shared germline index,
+        // they are created once per query aligner for all loci and reused for all reads
+        std::shared_ptr<VAligner> v_aligner_;
+        std::unordered_map<germline_utils::ChainType, JAlignmentContext,
+                germline_utils::ChainTypeHasher> j_contexts_;
+
+        void InitializeVAligner();
+
+        void InitializeJAligners();
+
+        JAlignmentContext& GetJContext(germline_utils::ChainType chain_type);
 
         template<typename ConfigStruct>
         algorithms::BlockAlignmentScoringScheme CreateBlockAlignmentScoring(const ConfigStruct& cfg) const {
@@ -39,31 +102,44 @@ namespace vj_finder {
                                                   algorithm_params_.aligner_params.max_candidates_j);
         }
 
-        typedef algorithms::BlockAlignmentHits<germline_utils::CustomGeneDatabase> CustomDbBlockAlignmentHits;
-
-        typedef algorithms::BlockAlignmentHits<germline_utils::ImmuneGeneDatabase> ImmuneDbBlockAlignmentHits;
-
         bool VAlignmentsAreConsistent(const CustomDbBlockAlignmentHits& v_alignments) const;
 
         germline_utils::ChainType IdentifyLocus(const CustomDbBlockAlignmentHits& v_alignments) const;
 
-        seqan::Dna5String DefineReadJSuffix(const CustomDbBlockAlignmentHits& v_alignments,
-                                            seqan::Dna5String read) const;
+        enum class StrandVote { ForwardStrand, ReverseStrand, AmbiguousStrand };
+
+        // compares numbers of hits of forward and reverse-complement k-mers in V index (strand_lookups_)
+        StrandVote VoteStrand() const;
+
+        // selects strand of read and computes V alignments of stranded read
+        // stranded_seq points either to sequence of read or to read_rc_seq_,
+        // returned alignments are stored in v_aligns_ or reverse_v_aligns_
+        CustomDbBlockAlignmentHits& AlignStrandedV(const core::Read &read,
+                                                  const seqan::Dna5String* &stranded_seq,
+                                                  bool &strand);
+
+        // returns start of read suffix where J segment is searched, length of read if J segment can not be found
+        size_t DefineJWindowStart(const CustomDbBlockAlignmentHits& v_alignments,
+                                  const seqan::Dna5String &read_seq) const;
 
     public:
         VJQueryAligner(const VJFinderConfig::AlgorithmParams &algorithm_params,
                        core::ReadArchive &read_archive,
-                       const germline_utils::CustomGeneDatabase &v_custom_db,
-                       const germline_utils::CustomGeneDatabase &j_custom_db) :
+                       const VJGermlineIndex &germline_index) :
                 algorithm_params_(algorithm_params),
                 read_archive_(read_archive),
-                v_custom_db_(v_custom_db),
-                j_custom_db_(j_custom_db) {
-            CheckDbConsistencyFatal();
+                germline_index_(germline_index),
+                v_custom_db_(germline_index.VDb()),
+                v_aligns_(v_custom_db_),
+                reverse_v_aligns_(v_custom_db_) {
+            InitializeVAligner();
+            InitializeJAligners();
         }
 
         VJHits Align(const core::Read& read);
 
+        const StrandVoteStats& GetStrandVoteStats() const { return strand_vote_stats_; }
+
     private:
         DECL_LOGGER("VJQueryAligner");
     };
@@ -20,6 +20,9 @@ namespace vj_finder {
     };
 
     class AggressiveFillFixCropProcessor : public BaseFillFixCropProcessor {
+        // workspace: sequence of processed read is reused across reads
+        seqan::Dna5String seq_;
+
     public:
         AggressiveFillFixCropProcessor(const VJFinderConfig::AlgorithmParams::FixCropFillParams &params,
                                        core::ReadArchive &read_archive) : BaseFillFixCropProcessor(params,
@@ -3,6 +3,12 @@
 #include "vj_query_fix_fill_crop.hpp"
 
 namespace vj_finder {
+    std::ostream& operator<<(std::ostream &out, const ReadAllocationStats &stats) {
+        out << stats.num_allocations << " heap allocations for " << stats.num_reads << " reads (" <<
+               double(stats.num_allocations) / double(std::max<size_t>(stats.num_reads, 1)) << " per read)";
+        return out;
+    }
+
     std::shared_ptr<BaseFillFixCropProcessor> VJQueryProcessor::GetFillFixCropProcessor() {
         return std::shared_ptr<BaseFillFixCropProcessor>(
                 new AggressiveFillFixCropProcessor(params_.fix_crop_fill_params,
@@ -11,23 +17,26 @@ namespace vj_finder {
 
     ProcessedVJHits VJQueryProcessor::ComputeFilteringResults(const core::Read &read, VJHits vj_hits) {
         ProcessedVJHits processed_hits(read);
-        processed_hits.vj_hits = vj_hits;
-        if(params_.filtering_params.enable_filtering) {
-            VersatileVjFilter vj_filter(params_.filtering_params);
-            processed_hits.filtering_info = vj_filter.Filter(vj_hits);
-        }
+        if(params_.filtering_params.enable_filtering)
+            processed_hits.filtering_info = vj_filter_.Filter(vj_hits);
+        processed_hits.vj_hits = std::move(vj_hits);
         return processed_hits;
     }
 
-    ProcessedVJHits VJQueryProcessor::Process(const core::Read &read) {
-        VJQueryAligner vj_query_aligner(params_, read_archive_, v_db_, j_db_);
-        VJHits vj_hits = vj_query_aligner.Align(read);
-        ProcessedVJHits hits_after_fitering = ComputeFilteringResults(read, vj_hits);
+    ProcessedVJHits VJQueryProcessor::ProcessRead(const core::Read &read) {
+        ProcessedVJHits hits_after_fitering = ComputeFilteringResults(read, vj_query_aligner_.Align(read));
         if(hits_after_fitering.ReadToBeFiltered()) {
             return hits_after_fitering;
         }
-        auto fix_fill_crop_processor = GetFillFixCropProcessor();
-        hits_after_fitering.vj_hits = fix_fill_crop_processor->Process(hits_after_fitering.vj_hits);
+        hits_after_fitering.vj_hits = fix_fill_crop_processor_->Process(std::move(hits_after_fitering.vj_hits));
         return hits_after_fitering;
     }
+
+    ProcessedVJHits VJQueryProcessor::Process(const core::Read &read) {
+        size_t num_allocations = allocation_counter::ThreadAllocations();
+        ProcessedVJHits processed_read = ProcessRead(read);
+        allocation_stats_.num_allocations += allocation_counter::ThreadAllocations() - num_allocations;
+        allocation_stats_.num_reads++;
+        return processed_read;
+    }
 }
\ No newline at end of file
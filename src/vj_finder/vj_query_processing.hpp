@@ -6,6 +6,8 @@
 #include "vj_query_fix_fill_crop.hpp"
 #include "vj_hits_filter.hpp"
 
+#include <allocation_counter.hpp>
+
 namespace vj_finder {
     struct ProcessedVJHits {
         const core::Read &read;
@@ -19,25 +21,52 @@ namespace vj_finder {
         bool ReadToBeFiltered() const { return filtering_info.read_to_be_filtered; }
     };
 
+    // heap allocations made during processing of reads,
+    // they are counted only in profiling builds (see allocation_counter.hpp)
+    struct ReadAllocationStats {
+        size_t num_reads;
+        size_t num_allocations;
+
+        ReadAllocationStats() : num_reads(0), num_allocations(0) { }
+
+        void Update(const ReadAllocationStats &stats) {
+            num_reads += stats.num_reads;
+            num_allocations += stats.num_allocations;
+        }
+    };
+
+    std::ostream& operator<<(std::ostream &out, const ReadAllocationStats &stats);
+
     class VJQueryProcessor {
         const VJFinderConfig::AlgorithmParams &params_;
         core::ReadArchive &read_archive_;
-        const germline_utils::CustomGeneDatabase &v_db_;
-        const germline_utils::CustomGeneDatabase &j_db_;
+        VJQueryAligner vj_query_aligner_;
+        // filter and fix-fill-crop processor are created once and reused for all reads
+        VersatileVjFilter vj_filter_;
+        std::shared_ptr<BaseFillFixCropProcessor> fix_fill_crop_processor_;
+
+        ReadAllocationStats allocation_stats_;
 
         ProcessedVJHits ComputeFilteringResults(const core::Read &read, VJHits vj_hits);
 
         std::shared_ptr<BaseFillFixCropProcessor> GetFillFixCropProcessor();
 
+        ProcessedVJHits ProcessRead(const core::Read &read);
+
     public:
         VJQueryProcessor(const VJFinderConfig::AlgorithmParams &params,
                          core::ReadArchive &read_archive,
-                         const germline_utils::CustomGeneDatabase &v_db,
-                         const germline_utils::CustomGeneDatabase &j_db) : params_(params),
-                                                                           read_archive_(read_archive),
-                                                                           v_db_(v_db),
-                                                                           j_db_(j_db) { }
+                         const VJGermlineIndex &germline_index) : params_(params),
+                                                                  read_archive_(read_archive),
+                                                                  vj_query_aligner_(params, read_archive,
+                                                                                    germline_index),
+                                                                  vj_filter_(params.filtering_params),
+                                                                  fix_fill_crop_processor_(GetFillFixCropProcessor()) { }
 
         ProcessedVJHits Process(const core::Read &read);
+
+        const StrandVoteStats& GetStrandVoteStats() const { return vj_query_aligner_.GetStrandVoteStats(); }
+
+        const ReadAllocationStats& GetAllocationStats() const { return allocation_stats_; }
     };
 }
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include <unordered_map>
+
+#include "vj_read_duplicates.hpp"
+
+namespace vj_finder {
+    void VJReadDuplicates::Initialize(const core::ReadArchive &read_archive, bool deduplicate) {
+        representatives_.reserve(read_archive.size());
+        group_index_.reserve(read_archive.size());
+        std::unordered_map<std::string, size_t> group_by_seq;
+        for(size_t i = 0; i < read_archive.size(); i++) {
+            size_t group_index = unique_reads_.size();
+            if(deduplicate) {
+                seqan::CharString seq = read_archive[i].seq;
+                auto it = group_by_seq.insert(std::make_pair(std::string(seqan::toCString(seq)), group_index));
+                group_index = it.first->second;
+            }
+            if(group_index == unique_reads_.size()) {
+                unique_reads_.push_back(i);
+                group_sizes_.push_back(0);
+            }
+            group_sizes_[group_index]++;
+            group_index_.push_back(group_index);
+            representatives_.push_back(unique_reads_[group_index]);
+        }
+    }
+
+    VJHits PropagateRepresentativeHits(const VJHits &representative_hits,
+                                       core::ReadArchive &read_archive,
+                                       size_t read_index) {
+        read_archive.UpdateReadByIndex(read_index, representative_hits.Read().seq);
+        VJHits vj_hits = representative_hits;
+        vj_hits.UpdateRead(read_archive[read_index]);
+        return vj_hits;
+    }
+
+    VJFilteringInfo PropagateRepresentativeFilteringInfo(const VJFilteringInfo &representative_filtering_info,
+                                                         core::ReadArchive &read_archive,
+                                                         size_t read_index) {
+        read_archive.UpdateReadByIndex(read_index, representative_filtering_info.read->seq);
+        VJFilteringInfo filtering_info = representative_filtering_info;
+        filtering_info.read = &read_archive[read_index];
+        return filtering_info;
+    }
+}
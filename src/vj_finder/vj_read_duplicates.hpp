@@ -0,0 +1,65 @@
+#pragma once
+
+#include <read_archive.hpp>
+
+#include "vj_alignment_info.hpp"
+
+namespace vj_finder {
+    // groups reads of read archive by identical sequences (similar to fast_ig_tools::HashCompressor)
+    // the first read of each group is its representative, only representatives should be aligned
+    // if deduplication is disabled, each read is a representative of itself
+    class VJReadDuplicates {
+        // i-th element is index of representative of i-th read
+        std::vector<size_t> representatives_;
+        // i-th element is index of group of i-th read, groups are numbered in order of their representatives
+        std::vector<size_t> group_index_;
+        // i-th element is index of representative of i-th group
+        std::vector<size_t> unique_reads_;
+        // i-th element is number of reads in i-th group
+        std::vector<size_t> group_sizes_;
+
+        void Initialize(const core::ReadArchive &read_archive, bool deduplicate);
+
+    public:
+        VJReadDuplicates(const core::ReadArchive &read_archive, bool deduplicate) {
+            Initialize(read_archive, deduplicate);
+        }
+
+        size_t NumReads() const { return representatives_.size(); }
+
+        size_t NumUniqueReads() const { return unique_reads_.size(); }
+
+        // index of representative read of i-th group
+        size_t UniqueReadIndex(size_t group_index) const {
+            VERIFY_MSG(group_index < NumUniqueReads(), "Group index " << group_index << " exceeds number of groups");
+            return unique_reads_[group_index];
+        }
+
+        size_t GroupSize(size_t group_index) const {
+            VERIFY_MSG(group_index < NumUniqueReads(), "Group index " << group_index << " exceeds number of groups");
+            return group_sizes_[group_index];
+        }
+
+        size_t GetRepresentative(size_t read_index) const {
+            VERIFY_MSG(read_index < NumReads(), "Read index " << read_index << " exceeds number of reads");
+            return representatives_[read_index];
+        }
+
+        size_t GetGroupIndex(size_t read_index) const {
+            VERIFY_MSG(read_index < NumReads(), "Read index " << read_index << " exceeds number of reads");
+            return group_index_[read_index];
+        }
+
+        bool IsRepresentative(size_t read_index) const { return GetRepresentative(read_index) == read_index; }
+    };
+
+    // results of representative read are copied to the read with identical sequence:
+    // updated sequence of representative is stored in read archive and results are rebound to the read
+    VJHits PropagateRepresentativeHits(const VJHits &representative_hits,
+                                       core::ReadArchive &read_archive,
+                                       size_t read_index);
+
+    VJFilteringInfo PropagateRepresentativeFilteringInfo(const VJFilteringInfo &representative_filtering_info,
+                                                         core::ReadArchive &read_archive,
+                                                         size_t read_index);
+}
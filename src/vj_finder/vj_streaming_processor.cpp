@@ -0,0 +1,99 @@
+#include <logger/logger.hpp>
+#include <path_helper.hpp>
+
+#include "vj_streaming_processor.hpp"
+
+namespace vj_finder {
+    VJAlignmentChunkPtr VJStreamingProcessor::ReadNextChunk(seqan::SeqFileIn &input) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        // reading does not run ahead of writing by more than num_threads chunks
+        chunk_is_written_.wait(lock, [this]() {
+            return input_is_over_ or next_chunk_to_read_ < next_chunk_to_write_ + num_threads_;
+        });
+        if(input_is_over_)
+            return VJAlignmentChunkPtr();
+        VJAlignmentChunkPtr chunk(new VJAlignmentChunk(next_chunk_to_read_));
+        if(chunk->read_archive.ExtractChunkFromFile(input, chunk_size_) == 0) {
+            input_is_over_ = true;
+            chunk_is_written_.notify_all();
+            return VJAlignmentChunkPtr();
+        }
+        next_chunk_to_read_++;
+        return chunk;
+    }
+
+    void VJStreamingProcessor::AlignChunk(VJAlignmentChunk &chunk) {
+        if(fix_spaces_)
+            chunk.read_archive.FixSpacesInHeaders();
+        VJQueryProcessor vj_query_processor(algorithm_params_, chunk.read_archive, germline_index_);
+        // reads are deduplicated within a chunk
+        VJReadDuplicates read_duplicates(chunk.read_archive, algorithm_params_.aligner_params.deduplicate_reads);
+        std::vector<ProcessedVJHits> processed_reads;
+        processed_reads.reserve(read_duplicates.NumUniqueReads());
+        for(size_t group_index = 0; group_index < read_duplicates.NumUniqueReads(); group_index++) {
+            const core::Read &read = chunk.read_archive[read_duplicates.UniqueReadIndex(group_index)];
+            TRACE("Processing read: " << read.name);
+            processed_reads.push_back(vj_query_processor.Process(read));
+        }
+        for(size_t i = 0; i < chunk.read_archive.size(); i++) {
+            const ProcessedVJHits &processed_read = processed_reads[read_duplicates.GetGroupIndex(i)];
+            bool is_representative = read_duplicates.IsRepresentative(i);
+            if(processed_read.ReadToBeFiltered())
+                chunk.alignment_info.UpdateFilteringInfo(is_representative ? processed_read.filtering_info :
+                        PropagateRepresentativeFilteringInfo(processed_read.filtering_info, chunk.read_archive, i));
+            else
+                chunk.alignment_info.UpdateHits(is_representative ? processed_read.vj_hits :
+                        PropagateRepresentativeHits(processed_read.vj_hits, chunk.read_archive, i));
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        strand_vote_stats_.Update(vj_query_processor.GetStrandVoteStats());
+        allocation_stats_.Update(vj_query_processor.GetAllocationStats());
+    }
+
+    void VJStreamingProcessor::UpdateStats(const VJAlignmentInfo &alignment_info) {
+        num_vj_hits_ += alignment_info.NumVJHits();
+        num_filtered_reads_ += alignment_info.NumFilteredReads();
+        for(auto it = alignment_info.chain_type_cbegin(); it != alignment_info.chain_type_cend(); it++)
+            chain_type_abundance_[it->first] += it->second;
+    }
+
+    void VJStreamingProcessor::WriteReadyChunks(VJAlignmentChunkPtr chunk, VJStreamingOutput &output) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        reorder_buffer_[chunk->index] = chunk;
+        while(!reorder_buffer_.empty() and reorder_buffer_.begin()->first == next_chunk_to_write_) {
+            const VJAlignmentChunk &ready_chunk = *(reorder_buffer_.begin()->second);
+            output.Write(ready_chunk.alignment_info);
+            UpdateStats(ready_chunk.alignment_info);
+            TRACE("Chunk " << ready_chunk.index << " was written");
+            reorder_buffer_.erase(reorder_buffer_.begin());
+            next_chunk_to_write_++;
+        }
+        chunk_is_written_.notify_all();
+    }
+
+    void VJStreamingProcessor::Process(VJStreamingOutput &output) {
+        path::CheckFileExistenceFATAL(input_reads_);
+        seqan::SeqFileIn input(input_reads_.c_str());
+        omp_set_num_threads(int(num_threads_));
+#pragma omp parallel
+        {
+            while(true) {
+                VJAlignmentChunkPtr chunk = ReadNextChunk(input);
+                if(!chunk)
+                    break;
+                AlignChunk(*chunk);
+                WriteReadyChunks(chunk, output);
+            }
+        }
+        VERIFY_MSG(reorder_buffer_.empty(), "Reorder buffer still contains " << reorder_buffer_.size() << " chunks");
+        INFO(next_chunk_to_write_ << " chunks of at most " << chunk_size_ << " reads were processed");
+        if(algorithm_params_.aligner_params.fix_strand)
+            INFO("Strand selection: " << strand_vote_stats_);
+        if(allocation_counter::Enabled())
+            INFO("Read processing made " << allocation_stats_);
+        for(auto it = chain_type_abundance_.cbegin(); it != chain_type_abundance_.cend(); it++) {
+            float perc = float(it->second) / float(num_vj_hits_) * 100;
+            INFO(perc << "% of aligned reads have isotype " << it->first);
+        }
+    }
+}
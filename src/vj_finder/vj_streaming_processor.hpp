@@ -0,0 +1,87 @@
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+
+#include "vj_alignment_info.hpp"
+#include "vj_query_processing.hpp"
+#include "vj_germline_index.hpp"
+#include "vj_read_duplicates.hpp"
+
+namespace vj_finder {
+    // chunk of consecutive input reads along with results of their alignment
+    struct VJAlignmentChunk {
+        size_t index;
+        core::ReadArchive read_archive;
+        VJAlignmentInfo alignment_info;
+
+        VJAlignmentChunk(size_t index) : index(index) { }
+    };
+
+    typedef std::shared_ptr<VJAlignmentChunk> VJAlignmentChunkPtr;
+
+    // streaming counterpart of VJParallelProcessor:
+    // each thread reads the next chunk of reads, aligns it and passes it to the reorder buffer,
+    // reorder buffer writes chunks in the input order as soon as all preceding chunks were written
+    // the number of chunks that were read but not written yet does not exceed the number of threads,
+    // so memory consumption is bounded by chunk size times the number of threads
+    class VJStreamingProcessor {
+        const std::string input_reads_;
+        const VJFinderConfig::AlgorithmParams &algorithm_params_;
+        const VJGermlineIndex &germline_index_;
+        size_t num_threads_;
+        size_t chunk_size_;
+        bool fix_spaces_;
+
+        std::mutex mutex_;
+        std::condition_variable chunk_is_written_;
+        size_t next_chunk_to_read_;
+        size_t next_chunk_to_write_;
+        bool input_is_over_;
+        std::map<size_t, VJAlignmentChunkPtr> reorder_buffer_;
+
+        size_t num_vj_hits_;
+        size_t num_filtered_reads_;
+        std::unordered_map<germline_utils::ChainType, size_t, germline_utils::ChainTypeHasher> chain_type_abundance_;
+        StrandVoteStats strand_vote_stats_;
+        ReadAllocationStats allocation_stats_;
+
+        // returns empty pointer if input reads are over
+        VJAlignmentChunkPtr ReadNextChunk(seqan::SeqFileIn &input);
+
+        void AlignChunk(VJAlignmentChunk &chunk);
+
+        void WriteReadyChunks(VJAlignmentChunkPtr chunk, VJStreamingOutput &output);
+
+        void UpdateStats(const VJAlignmentInfo &alignment_info);
+
+    public:
+        VJStreamingProcessor(std::string input_reads,
+                             const VJFinderConfig::AlgorithmParams &algorithm_params,
+                             const VJGermlineIndex &germline_index,
+                             size_t num_threads,
+                             size_t chunk_size,
+                             bool fix_spaces) : input_reads_(input_reads),
+                                                algorithm_params_(algorithm_params),
+                                                germline_index_(germline_index),
+                                                num_threads_(num_threads),
+                                                chunk_size_(chunk_size),
+                                                fix_spaces_(fix_spaces),
+                                                next_chunk_to_read_(0),
+                                                next_chunk_to_write_(0),
+                                                input_is_over_(false),
+                                                num_vj_hits_(0),
+                                                num_filtered_reads_(0) {
+            VERIFY_MSG(chunk_size_ > 0, "Chunk size should be positive");
+        }
+
+        void Process(VJStreamingOutput &output);
+
+        size_t NumVJHits() const { return num_vj_hits_; }
+
+        size_t NumFilteredReads() const { return num_filtered_reads_; }
+
+    private:
+        DECL_LOGGER("VJStreamingProcessor");
+    };
+}
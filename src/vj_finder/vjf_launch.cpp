@@ -5,6 +5,7 @@
 #include <read_archive.hpp>
 #include "germline_utils/germline_db_generator.hpp"
 #include "vj_parallel_processor.hpp"
+#include "vj_streaming_processor.hpp"
 
 using namespace germline_utils;
 
@@ -17,18 +18,25 @@ namespace vj_finder {
                 vj_hits.GetJHitByIndex(0).ImmuneGene().name() << std::endl;
     }
 
-    void VJFinderLaunch::Run() {
-        INFO("== VJ Finder starts == ");
+    void VJFinderLaunch::RunStreaming(const VJGermlineIndex &germline_index) {
+        INFO("Alignment against VJ germline segments starts in streaming mode (chunk size: " <<
+                     config_.run_params.chunk_size << ")");
+        VJStreamingProcessor processor(config_.io_params.input_params.input_reads, config_.algorithm_params,
+                                       germline_index, config_.run_params.num_threads,
+                                       config_.run_params.chunk_size,
+                                       config_.io_params.output_params.output_details.fix_spaces);
+        VJStreamingOutput alignment_output(config_.io_params.output_params);
+        processor.Process(alignment_output);
+        alignment_output.Close();
+        INFO(processor.NumVJHits() << " reads were aligned; " << processor.NumFilteredReads() <<
+                     " reads were filtered out");
+    }
+
+    void VJFinderLaunch::RunInMemory(const VJGermlineIndex &germline_index) {
         core::ReadArchive read_archive(config_.io_params.input_params.input_reads);
         if(config_.io_params.output_params.output_details.fix_spaces)
             read_archive.FixSpacesInHeaders();
-        GermlineDbGenerator db_generator(config_.io_params.input_params.germline_input,
-                                         config_.algorithm_params.germline_params);
-        INFO("Generation of DB for variable segments...");
-        germline_utils::CustomGeneDatabase v_db = db_generator.GenerateVariableDb();
-        INFO("Generation of DB for join segments...");
-        germline_utils::CustomGeneDatabase j_db = db_generator.GenerateJoinDb();
-        VJParallelProcessor processor(read_archive, config_.algorithm_params, v_db, j_db,
+        VJParallelProcessor processor(read_archive, config_.algorithm_params, germline_index,
                                       config_.run_params.num_threads);
         INFO("Alignment against VJ germline segments starts");
         VJAlignmentInfo alignment_info = processor.Process();
@@ -40,6 +48,22 @@ namespace vj_finder {
         alignment_info_output.OutputVAlignments();
         alignment_info_output.OutputFilteredReads();
         alignment_info_output.OutputFilteringInfo();
+    }
+
+    void VJFinderLaunch::Run() {
+        INFO("== VJ Finder starts == ");
+        GermlineDbGenerator db_generator(config_.io_params.input_params.germline_input,
+                                         config_.algorithm_params.germline_params);
+        INFO("Generation of DB for variable segments...");
+        germline_utils::CustomGeneDatabase v_db = db_generator.GenerateVariableDb();
+        INFO("Generation of DB for join segments...");
+        germline_utils::CustomGeneDatabase j_db = db_generator.GenerateJoinDb();
+        INFO("Construction of k-mer indices for germline segments...");
+        VJGermlineIndex germline_index(v_db, j_db, config_.algorithm_params.aligner_params);
+        if(config_.run_params.streaming_mode)
+            RunStreaming(germline_index);
+        else
+            RunInMemory(germline_index);
         INFO("== VJ Finder ends == ");
     }
 }
\ No newline at end of file
@@ -1,12 +1,17 @@
 #pragma once
 
 #include "vj_finder_config.hpp"
+#include "vj_germline_index.hpp"
 
 namespace vj_finder {
     class VJFinderLaunch {
         const VJFinderConfig &config_;
 
+        // reads, aligns and writes input reads chunk by chunk
+        void RunStreaming(const VJGermlineIndex &germline_index);
 
+        // loads all input reads into memory and writes results after alignment of all reads
+        void RunInMemory(const VJGermlineIndex &germline_index);
 
     public:
         VJFinderLaunch(const VJFinderConfig &config) :